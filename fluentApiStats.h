@@ -0,0 +1,422 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export grid model API accounting
+ *
+ * FluentApiStats counts the grid model API calls of an export and times
+ * them. FLUENT_API_CALL(fn, args) calls fn through fluentApiCall(), which
+ * charges the call to the current export phase while a FluentApiStats is
+ * started on the calling thread. Otherwise it only costs a thread local
+ * load. A worker thread counts its calls in stats of its own, started with
+ * countWorker() and charged to the worker's phase. mergeWorkers() adds them
+ * to the export's stats once the workers are done, so no counter is shared
+ * between threads.
+ *
+ * The latency of each call is kept in a histogram with a bucket per power of
+ * two nanoseconds, so the percentiles are reported to within a factor of
+ * two. The cost of reading the clock is measured by start() and subtracted
+ * from every call.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTAPISTATS_H_
+#define _FLUENTAPISTATS_H_
+
+#include "apiPWP.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+
+// The grid model API functions that are counted
+#define FLUENT_API_CALLS(X) \
+    X(PwBlkCondition) \
+    X(PwBlkElementCount) \
+    X(PwBlkEnumElements) \
+    X(PwDomCondition) \
+    X(PwDomElementCount) \
+    X(PwDomEnumElements) \
+    X(PwElemDataMod) \
+    X(PwElemDataModEnum) \
+    X(PwModAppendEnumElementOrder) \
+    X(PwModBlockCount) \
+    X(PwModDomainCount) \
+    X(PwModEnumBlocks) \
+    X(PwModEnumDomains) \
+    X(PwModEnumElements) \
+    X(PwModEnumVertices) \
+    X(PwModGetAttributeBOOL) \
+    X(PwModGetAttributeEnum) \
+    X(PwModGetAttributeREAL) \
+    X(PwModGetAttributeString) \
+    X(PwModGetAttributeUINT32) \
+    X(PwModVertexCount) \
+    X(PwVertDataMod)
+
+
+class FluentApiStats {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+#define FLUENT_API_ENUM(fn) Call_##fn,
+    enum Call {
+        FLUENT_API_CALLS(FLUENT_API_ENUM)
+        CallCount
+    };
+#undef FLUENT_API_ENUM
+
+    enum Phase {
+        Other,          // settings, estimates and reports
+        Header,         // writeHeader()
+        Verts,          // writeVerts()
+        BlockVCMap,     // processBlockVCMap()
+        VCZone,         // writeVCZone()
+        NeighborVC,     // getNeighborVCId()
+        CloseFaceZone,  // writeCloseFaceZone()
+        Faces,          // the rest of the face stream
+        End,            // endCB()
+        CellTypes,      // the PipelineCellTypes worker
+        Nodes,          // the PipelineNodes worker
+        PhaseCount
+    };
+
+    enum {
+        BucketCount = 40    // bucket b counts [2^b, 2^(b+1)) ns
+    };
+
+    FluentApiStats() :
+        phase_(Other),
+        overheadNs_(0),
+        started_(false)
+    {
+        for (int p = 0; p < PhaseCount; ++p) {
+            for (int c = 0; c < CallCount; ++c) {
+                counts_[p][c] = 0;
+                ns_[p][c] = 0;
+            }
+        }
+        for (int c = 0; c < CallCount; ++c) {
+            maxNs_[c] = 0;
+            for (int b = 0; b < BucketCount; ++b) {
+                hist_[c][b] = 0;
+            }
+        }
+    }
+
+    ~FluentApiStats()
+    {
+        stop();
+    }
+
+    // Counts the calls of this thread from now on
+    void start()
+    {
+        // The cheapest of many clock reads is the cost of timing a call
+        PWP_UINT64 best = ~PWP_UINT64(0);
+        for (int i = 0; i < 1000; ++i) {
+            const Clock::time_point t0 = Clock::now();
+            const Clock::time_point t1 = Clock::now();
+            best = std::min(best, nanoseconds(t1 - t0));
+        }
+        overheadNs_ = best;
+        started_ = true;
+        current() = this;
+    }
+
+    void stop()
+    {
+        if (this == current()) {
+            current() = nullptr;
+        }
+    }
+
+    bool enabled() const
+    {
+        return started_;
+    }
+
+    // Counts the calls of this worker thread in new stats of parent's,
+    // charged to phase, unless parent is null or the thread is counted
+    // already
+    static void countWorker(FluentApiStats *parent, const Phase phase)
+    {
+        if (nullptr == parent || nullptr != current()) {
+            return;
+        }
+        std::unique_ptr<FluentApiStats> worker(new FluentApiStats);
+        worker->start();
+        worker->setPhase(phase);
+        std::lock_guard<std::mutex> lock(parent->workersMutex_);
+        parent->workers_.push_back(std::move(worker));
+    }
+
+    // Adds the calls of the workers to these stats. The workers must have
+    // finished.
+    void mergeWorkers()
+    {
+        std::lock_guard<std::mutex> lock(workersMutex_);
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            const FluentApiStats &w = *workers_[i];
+            for (int c = 0; c < CallCount; ++c) {
+                for (int p = 0; p < PhaseCount; ++p) {
+                    counts_[p][c] += w.counts_[p][c];
+                    ns_[p][c] += w.ns_[p][c];
+                }
+                maxNs_[c] = std::max(maxNs_[c], w.maxNs_[c]);
+                for (int b = 0; b < BucketCount; ++b) {
+                    hist_[c][b] += w.hist_[c][b];
+                }
+            }
+        }
+        workers_.clear();
+    }
+
+    // The stats counting the calls of this thread, or null
+    static FluentApiStats *&current()
+    {
+        static thread_local FluentApiStats *stats = nullptr;
+        return stats;
+    }
+
+    Phase phase() const
+    {
+        return phase_;
+    }
+
+    void setPhase(const Phase phase)
+    {
+        phase_ = phase;
+    }
+
+    // Sets the phase of the current stats, if any
+    static void setCurrentPhase(const Phase phase)
+    {
+        if (nullptr != current()) {
+            current()->setPhase(phase);
+        }
+    }
+
+    // Times one call. Its destructor charges the call.
+    class Timer {
+    public:
+        Timer(FluentApiStats &stats, const Call call) :
+            stats_(stats),
+            call_(call),
+            begin_(Clock::now())
+        {
+        }
+
+        ~Timer()
+        {
+            stats_.add(call_, nanoseconds(Clock::now() - begin_));
+        }
+
+    private:
+        FluentApiStats     &stats_;
+        const Call          call_;
+        Clock::time_point   begin_;
+    };
+
+    // The report as lines of text. secs is the time of the whole export.
+    std::vector<std::string> report(const double secs) const
+    {
+        std::vector<std::string> ret;
+        char line[200];
+        PWP_UINT64 calls = 0;
+        PWP_UINT64 ns = 0;
+        PWP_UINT64 callCount[CallCount];
+        PWP_UINT64 callNs[CallCount];
+        for (int c = 0; c < CallCount; ++c) {
+            callCount[c] = callNs[c] = 0;
+            for (int p = 0; p < PhaseCount; ++p) {
+                callCount[c] += counts_[p][c];
+                callNs[c] += ns_[p][c];
+            }
+            calls += callCount[c];
+            ns += callNs[c];
+        }
+        snprintf(line, sizeof(line), "API calls: %llu calls, %.3f s in the "
+            "grid model API (%.1f%% of the export), %llu ns clock overhead "
+            "subtracted per call", (unsigned long long)calls, 1e-9 * double(ns),
+            100.0 * 1e-9 * double(ns) / std::max(secs, 1e-9),
+            (unsigned long long)overheadNs_);
+        ret.push_back(line);
+        snprintf(line, sizeof(line), "  %-28s %10s %10s %8s %8s %8s %8s "
+            "%8s", "call", "calls", "total ms", "mean ns", "p50 ns", "p90 ns",
+            "p99 ns", "max ns");
+        ret.push_back(line);
+        for (int c = 0; c < CallCount; ++c) {
+            if (0 == callCount[c]) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "  %-28s %10llu %10.3f %8llu %8llu "
+                "%8llu %8llu %8llu", callName(Call(c)),
+                (unsigned long long)callCount[c], 1e-6 * double(callNs[c]),
+                (unsigned long long)(callNs[c] / callCount[c]),
+                (unsigned long long)percentile(Call(c), 0.50),
+                (unsigned long long)percentile(Call(c), 0.90),
+                (unsigned long long)percentile(Call(c), 0.99),
+                (unsigned long long)maxNs_[c]);
+            ret.push_back(line);
+        }
+        snprintf(line, sizeof(line), "  %-18s %-28s %10s %10s", "phase",
+            "call", "calls", "total ms");
+        ret.push_back(line);
+        for (int p = 0; p < PhaseCount; ++p) {
+            for (int c = 0; c < CallCount; ++c) {
+                if (0 != counts_[p][c]) {
+                    snprintf(line, sizeof(line), "  %-18s %-28s %10llu "
+                        "%10.3f", phaseName(Phase(p)), callName(Call(c)),
+                        (unsigned long long)counts_[p][c],
+                        1e-6 * double(ns_[p][c]));
+                    ret.push_back(line);
+                }
+            }
+        }
+        return ret;
+    }
+
+    static const char *callName(const Call call)
+    {
+#define FLUENT_API_NAME(fn) #fn,
+        static const char *names[CallCount] = {
+            FLUENT_API_CALLS(FLUENT_API_NAME)
+        };
+#undef FLUENT_API_NAME
+        return names[call];
+    }
+
+    static const char *phaseName(const Phase phase)
+    {
+        static const char *names[PhaseCount] = {
+            "other", "writeHeader", "writeVerts", "processBlockVCMap",
+            "writeVCZone", "getNeighborVCId", "writeCloseFaceZone",
+            "faceCB", "endCB", "cellTypes worker", "nodes worker"
+        };
+        return names[phase];
+    }
+
+private:
+    static PWP_UINT64 nanoseconds(const Clock::duration d)
+    {
+        return PWP_UINT64(std::chrono::duration_cast<
+            std::chrono::nanoseconds>(d).count());
+    }
+
+    void add(const Call call, PWP_UINT64 ns)
+    {
+        ns -= std::min(ns, overheadNs_);
+        ++counts_[phase_][call];
+        ns_[phase_][call] += ns;
+        maxNs_[call] = std::max(maxNs_[call], ns);
+        int b = 0;
+        while (b + 1 < BucketCount && (PWP_UINT64(2) << b) <= ns) {
+            ++b;
+        }
+        ++hist_[call][b];
+    }
+
+    // Upper bound of the bucket that holds fraction f of the calls, limited
+    // to the slowest call
+    PWP_UINT64 percentile(const Call call, const double f) const
+    {
+        PWP_UINT64 total = 0;
+        for (int b = 0; b < BucketCount; ++b) {
+            total += hist_[call][b];
+        }
+        const PWP_UINT64 want = std::max<PWP_UINT64>(1,
+            PWP_UINT64(f * double(total) + 0.5));
+        PWP_UINT64 seen = 0;
+        for (int b = 0; b < BucketCount; ++b) {
+            seen += hist_[call][b];
+            if (seen >= want) {
+                return std::min(PWP_UINT64(2) << b, maxNs_[call]);
+            }
+        }
+        return maxNs_[call];
+    }
+
+    FluentApiStats(const FluentApiStats&) = delete;
+    FluentApiStats& operator=(const FluentApiStats&) = delete;
+
+private:
+    Phase       phase_;
+    PWP_UINT64  overheadNs_;
+    bool        started_;
+    PWP_UINT64  counts_[PhaseCount][CallCount];
+    PWP_UINT64  ns_[PhaseCount][CallCount];
+    PWP_UINT64  maxNs_[CallCount];
+    PWP_UINT64  hist_[CallCount][BucketCount];
+    std::mutex  workersMutex_;
+    std::vector<std::unique_ptr<FluentApiStats> > workers_;
+};
+
+
+// Charges the calls in its scope to phase, then restores the previous phase
+class FluentApiPhase {
+public:
+    explicit FluentApiPhase(const FluentApiStats::Phase phase) :
+        stats_(FluentApiStats::current()),
+        prev_(FluentApiStats::Other)
+    {
+        if (nullptr != stats_) {
+            prev_ = stats_->phase();
+            stats_->setPhase(phase);
+        }
+    }
+
+    ~FluentApiPhase()
+    {
+        if (nullptr != stats_) {
+            stats_->setPhase(prev_);
+        }
+    }
+
+private:
+    FluentApiStats         *stats_;
+    FluentApiStats::Phase   prev_;
+};
+
+
+// Calls fn(args) and charges it to the current stats of this thread
+template<typename F, typename... Args>
+static inline auto
+fluentApiCall(const FluentApiStats::Call call, F fn, Args... args) ->
+    decltype(fn(args...))
+{
+    FluentApiStats *stats = FluentApiStats::current();
+    if (nullptr == stats) {
+        return fn(args...);
+    }
+    FluentApiStats::Timer timer(*stats, call);
+    return fn(args...);
+}
+
+#define FLUENT_API_CALL(fn, ...) \
+    fluentApiCall(FluentApiStats::Call_##fn, fn, __VA_ARGS__)
+
+#endif /* _FLUENTAPISTATS_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,329 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export arena
+ *
+ * FluentArena is a monotonic allocator that holds the exporter's data
+ * structures for the duration of one export. Small allocations are carved
+ * from chunks that grow geometrically and are only returned by release(), so
+ * an export makes a handful of heap calls instead of one per map node or
+ * name. Allocations of more than LargeSize bytes get a block of their own
+ * that is freed as soon as it is deallocated.
+ *
+ * The arena counts the current and peak bytes of every Use, so the memory
+ * of an export can be logged and planned. FluentArenaAllocator puts a
+ * standard container on the arena. The arena is not thread safe.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTARENA_H_
+#define _FLUENTARENA_H_
+
+#include "apiPWP.h"
+
+#include <algorithm>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+class FluentArena {
+public:
+    enum Use {
+        VCMap,          // BlockVCMap nodes
+        VCNames,        // VC names and types
+        VCBlocks,       // block lists of the VCs
+        ShadowFaces,    // cached shadow faces
+        FaceBatch,      // faces waiting in faceCB()
+        CellZones,      // written cell zones
+        SurfaceNodes,   // vertices of a boundary only export
+        BCZones,        // domain BCs and BC zone cell types
+        UseCount
+    };
+
+    enum {
+        FirstChunkSize = 64 * 1024,
+        MaxChunkSize = 4 * 1024 * 1024,
+        LargeSize = MaxChunkSize / 4
+    };
+
+    struct Usage {
+        PWP_UINT64  current;    // bytes allocated and not deallocated
+        PWP_UINT64  peak;       // largest current
+        PWP_UINT64  allocs;     // number of allocations
+    };
+
+    FluentArena() :
+        cur_(nullptr),
+        end_(nullptr),
+        nextChunk_(FirstChunkSize),
+        reserved_(0),
+        peakReserved_(0)
+    {
+        for (int u = 0; u < UseCount; ++u) {
+            usage_[u] = Usage();
+        }
+    }
+
+    ~FluentArena()
+    {
+        release();
+    }
+
+    void *allocate(size_t bytes, size_t align, Use use)
+    {
+        Usage &u = usage_[use];
+        u.current += bytes;
+        u.peak = std::max(u.peak, u.current);
+        ++u.allocs;
+        if (bytes > LargeSize) {
+            const Block block = { ::operator new(bytes), bytes };
+            large_.push_back(block);
+            grow(bytes);
+            return block.ptr;
+        }
+        char *p = alignUp(cur_, align);
+        if (nullptr == cur_ || bytes > size_t(end_ - p)) {
+            newChunk(bytes + align);
+            p = alignUp(cur_, align);
+        }
+        cur_ = p + bytes;
+        return p;
+    }
+
+    // Chunk memory is only reclaimed by release(). A large block is freed.
+    void deallocate(void *p, size_t bytes, Use use)
+    {
+        usage_[use].current -= std::min<PWP_UINT64>(bytes,
+            usage_[use].current);
+        if (bytes > LargeSize) {
+            for (size_t i = 0; i < large_.size(); ++i) {
+                if (large_[i].ptr == p) {
+                    ::operator delete(p);
+                    reserved_ -= large_[i].size;
+                    large_.erase(large_.begin() + ptrdiff_t(i));
+                    break;
+                }
+            }
+        }
+    }
+
+    // Copies the string s to the arena
+    const char *copy(const char *s, Use use)
+    {
+        const size_t len = (s ? strlen(s) : 0);
+        char *p = static_cast<char*>(allocate(len + 1, 1, use));
+        if (0 != len) {
+            memcpy(p, s, len);
+        }
+        p[len] = '\0';
+        return p;
+    }
+
+    // Frees all memory in one step. The peak counts are kept.
+    void release()
+    {
+        for (size_t i = 0; i < chunks_.size(); ++i) {
+            ::operator delete(chunks_[i].ptr);
+        }
+        for (size_t i = 0; i < large_.size(); ++i) {
+            ::operator delete(large_[i].ptr);
+        }
+        chunks_.clear();
+        large_.clear();
+        cur_ = end_ = nullptr;
+        nextChunk_ = FirstChunkSize;
+        reserved_ = 0;
+        for (int u = 0; u < UseCount; ++u) {
+            usage_[u].current = 0;
+        }
+    }
+
+    const Usage &usage(Use use) const
+    {
+        return usage_[use];
+    }
+
+    // Bytes held from the heap, now and at most
+    PWP_UINT64 reserved() const
+    {
+        return reserved_;
+    }
+
+    PWP_UINT64 peakReserved() const
+    {
+        return peakReserved_;
+    }
+
+    // The usage as lines of text
+    std::vector<std::string> report() const
+    {
+        static const char *names[UseCount] = {
+            "VC map", "VC names", "VC blocks", "shadow faces", "face batch",
+            "cell zones", "surface nodes", "BC zones"
+        };
+        std::vector<std::string> ret;
+        char line[160];
+        snprintf(line, sizeof(line), "Arena: %llu bytes peak, %llu bytes "
+            "held in %u chunks and %u large blocks",
+            (unsigned long long)peakReserved_, (unsigned long long)reserved_,
+            unsigned(chunks_.size()), unsigned(large_.size()));
+        ret.push_back(line);
+        for (int u = 0; u < UseCount; ++u) {
+            snprintf(line, sizeof(line), "  %-12s %12llu bytes peak %12llu "
+                "current %8llu allocations", names[u],
+                (unsigned long long)usage_[u].peak,
+                (unsigned long long)usage_[u].current,
+                (unsigned long long)usage_[u].allocs);
+            ret.push_back(line);
+        }
+        return ret;
+    }
+
+private:
+    struct Block {
+        void   *ptr;
+        size_t  size;
+    };
+
+    static char *alignUp(char *p, size_t align)
+    {
+        const size_t mis = size_t(reinterpret_cast<uintptr_t>(p) % align);
+        return (0 == mis) ? p : p + (align - mis);
+    }
+
+    void newChunk(size_t minSize)
+    {
+        const size_t size = std::max(nextChunk_, minSize);
+        const Block block = { ::operator new(size), size };
+        chunks_.push_back(block);
+        grow(size);
+        cur_ = static_cast<char*>(block.ptr);
+        end_ = cur_ + size;
+        nextChunk_ = std::min(2 * nextChunk_, size_t(MaxChunkSize));
+    }
+
+    void grow(size_t bytes)
+    {
+        reserved_ += bytes;
+        peakReserved_ = std::max(peakReserved_, reserved_);
+    }
+
+    FluentArena(const FluentArena&) = delete;
+    FluentArena& operator=(const FluentArena&) = delete;
+
+private:
+    char               *cur_;       // next free byte of the current chunk
+    char               *end_;       // end of the current chunk
+    size_t              nextChunk_;
+    std::vector<Block>  chunks_;
+    std::vector<Block>  large_;
+    PWP_UINT64          reserved_;
+    PWP_UINT64          peakReserved_;
+    Usage               usage_[UseCount];
+};
+
+
+// Standard allocator on a FluentArena. A default constructed allocator uses
+// the heap. Containers take the allocator along on assignment and swap.
+template<typename T>
+class FluentArenaAllocator {
+public:
+    typedef T               value_type;
+    typedef std::true_type  propagate_on_container_copy_assignment;
+    typedef std::true_type  propagate_on_container_move_assignment;
+    typedef std::true_type  propagate_on_container_swap;
+
+    FluentArenaAllocator() :
+        arena_(nullptr),
+        use_(FluentArena::VCMap)
+    {
+    }
+
+    FluentArenaAllocator(FluentArena *arena, FluentArena::Use use) :
+        arena_(arena),
+        use_(use)
+    {
+    }
+
+    template<typename U>
+    FluentArenaAllocator(const FluentArenaAllocator<U> &other) :
+        arena_(other.arena()),
+        use_(other.use())
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        if (nullptr == arena_) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T),
+            use_));
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        if (nullptr == arena_) {
+            ::operator delete(p);
+        }
+        else {
+            arena_->deallocate(p, n * sizeof(T), use_);
+        }
+    }
+
+    FluentArena *arena() const
+    {
+        return arena_;
+    }
+
+    FluentArena::Use use() const
+    {
+        return use_;
+    }
+
+private:
+    FluentArena        *arena_;
+    FluentArena::Use    use_;
+};
+
+
+template<typename T, typename U>
+static inline bool
+operator==(const FluentArenaAllocator<T> &a, const FluentArenaAllocator<U> &b)
+{
+    return a.arena() == b.arena();
+}
+
+
+template<typename T, typename U>
+static inline bool
+operator!=(const FluentArenaAllocator<T> &a, const FluentArenaAllocator<U> &b)
+{
+    return a.arena() != b.arena();
+}
+
+#endif /* _FLUENTARENA_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,1428 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT batch converter
+ *
+ * fluentBatch writes the FLUENT case file of a FluentMeshFile without the
+ * meshing application. It implements the grid model, face stream and CAEP
+ * utility calls that runtimeWrite() makes on top of the mapped mesh file,
+ * and runs the plugin's export code unchanged. See README.md for the build
+ * and the options.
+ *
+ * The face stream is built from the cells. The faces of all cells are
+ * sorted by their vertices. A face found twice is an interior or connection
+ * face and a face found once is a boundary face. Domain elements are matched
+ * to the faces by their vertices. As in the meshing application, the owner
+ * is the cell with the lower index and the face vertices are ordered so that
+ * the right-hand rule points into the owner.
+ *
+ ***************************************************************************/
+
+#include "apiCAEP.h"
+#include "apiCAEPUtils.h"
+#include "apiGridModel.h"
+#include "apiPWP.h"
+#include "runtimeWrite.h"
+
+#include "fluentMeshFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <map>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The format's BC and VC types
+#include "rtCaepSupportData.h"
+
+
+/************************************************
+*   Messages and abort
+*************************************************/
+
+// Set by SIGINT and SIGTERM. The export stops as if aborted in the host.
+static volatile sig_atomic_t QuitSignal = 0;
+
+// true if info messages are not printed
+static bool Quiet = false;
+
+
+static void
+onQuitSignal(int /*sig*/)
+{
+    QuitSignal = 1;
+}
+
+
+static void
+report(const char *kind, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "fluentBatch: %s: ", kind);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+
+/************************************************
+*   The grid model
+*************************************************/
+
+// An export attribute published by runtimeCreate()
+struct Published {
+    PWP_ENUM_VALTYPE    type;
+    std::string         value;      // default value
+    std::string         range;      // "a|b|c" or "lo hi"
+};
+
+// The grid model of the mesh file. The cells of the blocks are numbered in
+// the order of the blocks in order.
+struct BatchModel {
+    FluentMeshFile                      file;
+    std::vector<PWGM_ELEMCOUNTS>        blockCounts;
+    std::vector<PWGM_ELEMCOUNTS>        domainCounts;
+    std::vector<PWP_UINT32>             order;      // block indices
+    std::vector<PWP_UINT32>             firstCell;  // of order[i], + total
+    std::vector<PWP_UINT32>             orderPos;   // of each block
+    std::vector<PWP_UINT32>             vcGroup;    // of each block
+    std::map<std::string, std::string>  attributes; // set by the user
+    std::map<std::string, Published>    published;
+    PWP_UINT32                          threads;
+};
+
+static BatchModel Model;
+
+
+static BatchModel &
+modelOf(PWGM_HGRIDMODEL model)
+{
+    return *reinterpret_cast<BatchModel*>(model);
+}
+
+
+static PWGM_HGRIDMODEL
+modelHandle()
+{
+    return reinterpret_cast<PWGM_HGRIDMODEL>(&Model);
+}
+
+
+// The SDK element type of a FluentMeshFile element type
+static PWGM_ENUM_ELEMTYPE
+sdkElemType(const PWP_UINT32 type)
+{
+    switch (type) {
+    case FluentMeshFile::Bar: return PWGM_ELEMTYPE_BAR;
+    case FluentMeshFile::Tri: return PWGM_ELEMTYPE_TRI;
+    case FluentMeshFile::Quad: return PWGM_ELEMTYPE_QUAD;
+    case FluentMeshFile::Tet: return PWGM_ELEMTYPE_TET;
+    case FluentMeshFile::Pyramid: return PWGM_ELEMTYPE_PYRAMID;
+    case FluentMeshFile::Wedge: return PWGM_ELEMTYPE_WEDGE;
+    default: return PWGM_ELEMTYPE_HEX;
+    }
+}
+
+
+static void
+countElements(const FluentMeshFile &file, const FluentMeshFile::Entity &ent,
+    PWGM_ELEMCOUNTS &counts)
+{
+    memset(&counts, 0, sizeof(counts));
+    for (PWP_UINT32 i = 0; i < PWP_UINT32(ent.elemCount); ++i) {
+        ++counts.count[sdkElemType(file.elementType(ent, i))];
+    }
+}
+
+
+// Numbers the cells block by block, with the blocks grouped by VC if byVC
+static bool
+setCellOrder(BatchModel &m, const bool byVC)
+{
+    const FluentMeshFile &file = m.file;
+    const PWP_UINT32 nBlk = file.blockCount();
+    // The VCs in the order of their first block
+    std::vector<PWP_UINT32> vcIds;
+    m.vcGroup.assign(nBlk, 0);
+    for (PWP_UINT32 b = 0; b < nBlk; ++b) {
+        const PWP_UINT32 id = file.block(b).id;
+        std::vector<PWP_UINT32>::iterator it = std::find(vcIds.begin(),
+            vcIds.end(), id);
+        m.vcGroup[b] = PWP_UINT32(it - vcIds.begin());
+        if (vcIds.end() == it) {
+            vcIds.push_back(id);
+        }
+    }
+    m.order.clear();
+    for (PWP_UINT32 b = 0; b < nBlk; ++b) {
+        m.order.push_back(b);
+    }
+    if (byVC) {
+        std::stable_sort(m.order.begin(), m.order.end(),
+            [&m](PWP_UINT32 a, PWP_UINT32 b) {
+                return m.vcGroup[a] < m.vcGroup[b];
+            });
+    }
+    m.firstCell.assign(1, 0);
+    m.orderPos.assign(nBlk, 0);
+    PWP_UINT64 total = 0;
+    for (PWP_UINT32 i = 0; i < nBlk; ++i) {
+        m.orderPos[m.order[i]] = i;
+        total += file.block(m.order[i]).elemCount;
+        if (total >= PWP_BADID) {
+            return false;
+        }
+        m.firstCell.push_back(PWP_UINT32(total));
+    }
+    return true;
+}
+
+
+static bool
+loadModel(BatchModel &m, const char *filename)
+{
+    if (!m.file.open(filename)) {
+        report("error", "%s: %s", filename, m.file.error().c_str());
+        return false;
+    }
+    m.blockCounts.resize(m.file.blockCount());
+    for (PWP_UINT32 b = 0; b < m.file.blockCount(); ++b) {
+        countElements(m.file, m.file.block(b), m.blockCounts[b]);
+    }
+    m.domainCounts.resize(m.file.domainCount());
+    for (PWP_UINT32 d = 0; d < m.file.domainCount(); ++d) {
+        countElements(m.file, m.file.domain(d), m.domainCounts[d]);
+    }
+    if (!setCellOrder(m, false)) {
+        report("error", "%s: too many cells", filename);
+        return false;
+    }
+    return true;
+}
+
+
+// The block and block element of cell
+static void
+cellLocation(const BatchModel &m, const PWP_UINT32 cell, PWP_UINT32 &block,
+    PWP_UINT32 &elem)
+{
+    const PWP_UINT32 pos = PWP_UINT32(std::upper_bound(m.firstCell.begin(),
+        m.firstCell.end(), cell) - m.firstCell.begin()) - 1;
+    block = m.order[pos];
+    elem = cell - m.firstCell[pos];
+}
+
+
+static PWGM_HBLOCK
+blockHandle(PWGM_HGRIDMODEL model, const PWP_UINT32 ndx)
+{
+    PWGM_HBLOCK h = PWGM_HBLOCK_INIT;
+    if (ndx < modelOf(model).file.blockCount()) {
+        h.hP = model;
+        h.id = ndx;
+    }
+    return h;
+}
+
+
+static PWGM_HDOMAIN
+domainHandle(PWGM_HGRIDMODEL model, const PWP_UINT32 ndx)
+{
+    PWGM_HDOMAIN h = PWGM_HDOMAIN_INIT;
+    if (ndx < modelOf(model).file.domainCount()) {
+        h.hP = model;
+        h.id = ndx;
+    }
+    return h;
+}
+
+
+static PWGM_HVERTEX
+vertexHandle(PWGM_HGRIDMODEL model, const PWP_UINT32 ndx)
+{
+    PWGM_HVERTEX h;
+    h.hP = nullptr;
+    h.id = PWP_BADID;
+    if (ndx < modelOf(model).file.vertexCount()) {
+        h.hP = model;
+        h.id = ndx;
+    }
+    return h;
+}
+
+
+// Element handle parent types
+enum {
+    BlockElement,
+    DomainElement
+};
+
+static PWGM_HELEMENT
+elementHandle(PWGM_HGRIDMODEL model, const int ptype, const PWP_UINT32 parent,
+    const PWP_UINT32 ndx)
+{
+    const FluentMeshFile &file = modelOf(model).file;
+    PWGM_HELEMENT h;
+    h.hP = nullptr;
+    h.ptype = ptype;
+    h.parentId = PWP_BADID;
+    h.id = PWP_BADID;
+    const bool ok = (BlockElement == ptype) ?
+        (parent < file.blockCount() && ndx < file.block(parent).elemCount) :
+        (parent < file.domainCount() && ndx < file.domain(parent).elemCount);
+    if (ok) {
+        h.hP = model;
+        h.parentId = parent;
+        h.id = ndx;
+    }
+    return h;
+}
+
+
+static void
+fillElemData(PWGM_HGRIDMODEL model, const PWP_UINT32 type,
+    const PWP_UINT32 *verts, PWGM_ELEMDATA &data)
+{
+    data.type = sdkElemType(type);
+    data.vertCnt = FluentMeshFile::typeVertexCount(type);
+    for (PWP_UINT32 i = 0; i < data.vertCnt; ++i) {
+        data.index[i] = verts[i];
+        data.vert[i] = vertexHandle(model, verts[i]);
+    }
+}
+
+
+static PWP_BOOL
+condition(const FluentMeshFile &file, const FluentMeshFile::Entity &ent,
+    PWGM_CONDDATA *pCondData)
+{
+    if (nullptr == pCondData) {
+        return PWP_FALSE;
+    }
+    pCondData->name = file.string(ent.name);
+    pCondData->id = ent.id;
+    pCondData->type = file.string(ent.type);
+    pCondData->tid = ent.typeId;
+    return PWP_TRUE;
+}
+
+
+static PWP_UINT32
+elementCount(const PWGM_ELEMCOUNTS &counts, PWGM_ELEMCOUNTS *pCounts)
+{
+    PWP_UINT32 ret = 0;
+    for (int i = 0; i < PWGM_ELEMTYPE_SIZE; ++i) {
+        ret += counts.count[i];
+    }
+    if (nullptr != pCounts) {
+        *pCounts = counts;
+    }
+    return ret;
+}
+
+
+PWP_UINT32
+PwModBlockCount(PWGM_HGRIDMODEL model)
+{
+    return modelOf(model).file.blockCount();
+}
+
+
+PWGM_HBLOCK
+PwModEnumBlocks(PWGM_HGRIDMODEL model, PWP_UINT32 ndx)
+{
+    return blockHandle(model, ndx);
+}
+
+
+PWP_UINT32
+PwModDomainCount(PWGM_HGRIDMODEL model)
+{
+    return modelOf(model).file.domainCount();
+}
+
+
+PWGM_HDOMAIN
+PwModEnumDomains(PWGM_HGRIDMODEL model, PWP_UINT32 ndx)
+{
+    return domainHandle(model, ndx);
+}
+
+
+PWP_UINT32
+PwModVertexCount(PWGM_HGRIDMODEL model)
+{
+    return modelOf(model).file.vertexCount();
+}
+
+
+PWGM_HVERTEX
+PwModEnumVertices(PWGM_HGRIDMODEL model, PWP_UINT32 ndx)
+{
+    return vertexHandle(model, ndx);
+}
+
+
+PWP_BOOL
+PwVertDataMod(PWGM_HVERTEX vertex, PWGM_VERTDATA *pVertData)
+{
+    if (!PWGM_HVERTEX_ISVALID(vertex) || nullptr == pVertData) {
+        return PWP_FALSE;
+    }
+    const double *xyz = modelOf(vertex.hP).file.vertex(vertex.id);
+    pVertData->x = xyz[0];
+    pVertData->y = xyz[1];
+    pVertData->z = xyz[2];
+    pVertData->i = vertex.id;
+    return PWP_TRUE;
+}
+
+
+PWGM_HELEMENT
+PwModEnumElements(PWGM_HGRIDMODEL model, PWP_UINT32 ndx)
+{
+    const BatchModel &m = modelOf(model);
+    if (ndx >= m.firstCell.back()) {
+        return elementHandle(model, BlockElement, PWP_BADID, PWP_BADID);
+    }
+    PWP_UINT32 block;
+    PWP_UINT32 elem;
+    cellLocation(m, ndx, block, elem);
+    return elementHandle(model, BlockElement, block, elem);
+}
+
+
+PWP_UINT32
+PwModEnumElementCount(PWGM_HGRIDMODEL model, PWGM_ELEMCOUNTS *pCounts)
+{
+    const BatchModel &m = modelOf(model);
+    PWGM_ELEMCOUNTS total;
+    memset(&total, 0, sizeof(total));
+    for (size_t b = 0; b < m.blockCounts.size(); ++b) {
+        for (int i = 0; i < PWGM_ELEMTYPE_SIZE; ++i) {
+            total.count[i] += m.blockCounts[b].count[i];
+        }
+    }
+    return elementCount(total, pCounts);
+}
+
+
+PWP_BOOL
+PwModAppendEnumElementOrder(PWGM_HGRIDMODEL model, PWGM_ENUM_ELEMORDER order)
+{
+    return PWP_CAST_BOOL(setCellOrder(modelOf(model),
+        PWGM_ELEMORDER_VC == order));
+}
+
+
+PWP_UINT32
+PwBlkElementCount(PWGM_HBLOCK block, PWGM_ELEMCOUNTS *pCounts)
+{
+    if (!PWGM_HBLOCK_ISVALID(block)) {
+        return 0;
+    }
+    return elementCount(modelOf(block.hP).blockCounts[block.id], pCounts);
+}
+
+
+PWGM_HELEMENT
+PwBlkEnumElements(PWGM_HBLOCK block, PWP_UINT32 ndx)
+{
+    return elementHandle(block.hP, BlockElement, block.id, ndx);
+}
+
+
+PWP_BOOL
+PwBlkCondition(PWGM_HBLOCK block, PWGM_CONDDATA *pCondData)
+{
+    if (!PWGM_HBLOCK_ISVALID(block)) {
+        return PWP_FALSE;
+    }
+    const FluentMeshFile &file = modelOf(block.hP).file;
+    return condition(file, file.block(block.id), pCondData);
+}
+
+
+PWP_UINT32
+PwDomElementCount(PWGM_HDOMAIN domain, PWGM_ELEMCOUNTS *pCounts)
+{
+    if (!PWGM_HDOMAIN_ISVALID(domain)) {
+        return 0;
+    }
+    return elementCount(modelOf(domain.hP).domainCounts[domain.id], pCounts);
+}
+
+
+PWGM_HELEMENT
+PwDomEnumElements(PWGM_HDOMAIN domain, PWP_UINT32 ndx)
+{
+    return elementHandle(domain.hP, DomainElement, domain.id, ndx);
+}
+
+
+PWP_BOOL
+PwDomCondition(PWGM_HDOMAIN domain, PWGM_CONDDATA *pCondData)
+{
+    if (!PWGM_HDOMAIN_ISVALID(domain)) {
+        return PWP_FALSE;
+    }
+    const FluentMeshFile &file = modelOf(domain.hP).file;
+    return condition(file, file.domain(domain.id), pCondData);
+}
+
+
+PWP_BOOL
+PwElemDataMod(PWGM_HELEMENT element, PWGM_ELEMDATA *pElemData)
+{
+    if (!PWGM_HELEMENT_ISVALID(element) || nullptr == pElemData) {
+        return PWP_FALSE;
+    }
+    const FluentMeshFile &file = modelOf(element.hP).file;
+    const FluentMeshFile::Entity &ent = (BlockElement == element.ptype) ?
+        file.block(element.parentId) : file.domain(element.parentId);
+    fillElemData(element.hP, file.elementType(ent, element.id),
+        file.elementVerts(ent, element.id), *pElemData);
+    return PWP_TRUE;
+}
+
+
+PWP_BOOL
+PwElemDataModEnum(PWGM_HELEMENT element, PWGM_ENUMELEMDATA *pEnumElemData)
+{
+    if (nullptr == pEnumElemData ||
+            !PwElemDataMod(element, &pEnumElemData->elemData)) {
+        return PWP_FALSE;
+    }
+    pEnumElemData->hBlkElement = element;
+    return PWP_TRUE;
+}
+
+
+/************************************************
+*   Export attributes
+*************************************************/
+
+// Attributes the host sets that are not published by runtimeCreate()
+static const char *HostAttributes[] = {
+    "AppNameAndVersion"
+};
+
+
+// The user's value of attribute name, else its published default
+static const char *
+attributeValue(PWGM_HGRIDMODEL model, const char *name)
+{
+    const BatchModel &m = modelOf(model);
+    std::map<std::string, std::string>::const_iterator it =
+        m.attributes.find(name);
+    if (m.attributes.end() != it) {
+        return it->second.c_str();
+    }
+    std::map<std::string, Published>::const_iterator pit =
+        m.published.find(name);
+    return (m.published.end() != pit) ? pit->second.value.c_str() : nullptr;
+}
+
+
+static bool
+parseBool(const char *val, PWP_BOOL &on)
+{
+    std::string s(val);
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    if ("true" == s || "1" == s || "yes" == s || "on" == s) {
+        on = PWP_TRUE;
+        return true;
+    }
+    if ("false" == s || "0" == s || "no" == s || "off" == s) {
+        on = PWP_FALSE;
+        return true;
+    }
+    return false;
+}
+
+
+static bool
+parseReal(const char *val, PWP_REAL &r)
+{
+    char *end = nullptr;
+    r = strtod(val, &end);
+    return end != val && '\0' == *end;
+}
+
+
+PWP_BOOL
+PwModGetAttributeString(PWGM_HGRIDMODEL model, const char *name,
+    const char **val)
+{
+    const char *v = attributeValue(model, name);
+    if (nullptr == v || nullptr == val) {
+        return PWP_FALSE;
+    }
+    *val = v;
+    return PWP_TRUE;
+}
+
+
+PWP_BOOL
+PwModGetAttributeEnum(PWGM_HGRIDMODEL model, const char *name,
+    const char **val)
+{
+    return PwModGetAttributeString(model, name, val);
+}
+
+
+PWP_BOOL
+PwModGetAttributeUINT32(PWGM_HGRIDMODEL model, const char *name,
+    PWP_UINT32 *val)
+{
+    const char *v = attributeValue(model, name);
+    PWP_REAL r;
+    if (nullptr == v || nullptr == val || !parseReal(v, r) || r < 0 ||
+            r >= 4294967296.0) {
+        return PWP_FALSE;
+    }
+    *val = PWP_UINT32(r);
+    return PWP_TRUE;
+}
+
+
+PWP_BOOL
+PwModGetAttributeINT32(PWGM_HGRIDMODEL model, const char *name,
+    PWP_INT32 *val)
+{
+    const char *v = attributeValue(model, name);
+    PWP_REAL r;
+    if (nullptr == v || nullptr == val || !parseReal(v, r) ||
+            r < -2147483648.0 || r >= 2147483648.0) {
+        return PWP_FALSE;
+    }
+    *val = PWP_INT32(r);
+    return PWP_TRUE;
+}
+
+
+PWP_BOOL
+PwModGetAttributeREAL(PWGM_HGRIDMODEL model, const char *name, PWP_REAL *val)
+{
+    const char *v = attributeValue(model, name);
+    return PWP_CAST_BOOL(nullptr != v && nullptr != val && parseReal(v, *val));
+}
+
+
+PWP_BOOL
+PwModGetAttributeBOOL(PWGM_HGRIDMODEL model, const char *name, PWP_BOOL *val)
+{
+    const char *v = attributeValue(model, name);
+    return PWP_CAST_BOOL(nullptr != v && nullptr != val && parseBool(v, *val));
+}
+
+
+// Checks the user's attributes against the published definitions
+static bool
+checkAttributes(const BatchModel &m)
+{
+    bool ret = true;
+    std::map<std::string, std::string>::const_iterator it;
+    for (it = m.attributes.begin(); it != m.attributes.end(); ++it) {
+        const char *name = it->first.c_str();
+        const char *val = it->second.c_str();
+        std::map<std::string, Published>::const_iterator pit =
+            m.published.find(it->first);
+        if (m.published.end() == pit) {
+            bool host = false;
+            for (size_t i = 0; i < ARRAYSIZE(HostAttributes); ++i) {
+                host = host || (it->first == HostAttributes[i]);
+            }
+            if (!host) {
+                report("error", "unknown attribute %s", name);
+                ret = false;
+            }
+            continue;
+        }
+        const Published &pub = pit->second;
+        bool ok = true;
+        PWP_REAL r = 0.0;
+        PWP_BOOL on;
+        switch (pub.type) {
+        case PWP_VALTYPE_BOOL:
+            ok = parseBool(val, on);
+            break;
+        case PWP_VALTYPE_ENUM:
+            ok = std::string::npos != ("|" + pub.range + "|").find(
+                "|" + it->second + "|");
+            break;
+        case PWP_VALTYPE_UINT:
+        case PWP_VALTYPE_INT:
+        case PWP_VALTYPE_REAL: {
+            PWP_REAL lo;
+            PWP_REAL hi;
+            ok = parseReal(val, r) && (PWP_VALTYPE_REAL == pub.type ||
+                r == PWP_REAL(PWP_INT64(r)));
+            if (ok && 2 == sscanf(pub.range.c_str(), "%lf %lf", &lo, &hi)) {
+                ok = (lo <= r && r <= hi);
+            }
+            break; }
+        default:
+            break;
+        }
+        if (!ok) {
+            report("error", "bad value '%s' for %s (%s)", val, name,
+                pub.range.c_str());
+            ret = false;
+        }
+    }
+    return ret;
+}
+
+
+/************************************************
+*   The face stream
+*************************************************/
+
+// Faces of the cell types, with the vertices ordered so that the right-hand
+// rule points into the cell. A face of fewer vertices ends with -1.
+static const int TriFaces[3][4] = {
+    { 0, 1, -1, -1 }, { 1, 2, -1, -1 }, { 2, 0, -1, -1 }
+};
+static const int QuadFaces[4][4] = {
+    { 0, 1, -1, -1 }, { 1, 2, -1, -1 }, { 2, 3, -1, -1 }, { 3, 0, -1, -1 }
+};
+static const int TetFaces[4][4] = {
+    { 0, 1, 2, -1 }, { 0, 3, 1, -1 }, { 1, 3, 2, -1 }, { 2, 3, 0, -1 }
+};
+static const int PyramidFaces[5][4] = {
+    { 0, 1, 2, 3 }, { 0, 4, 1, -1 }, { 1, 4, 2, -1 }, { 2, 4, 3, -1 },
+    { 3, 4, 0, -1 }
+};
+static const int WedgeFaces[5][4] = {
+    { 0, 1, 2, -1 }, { 3, 5, 4, -1 }, { 0, 3, 4, 1 }, { 1, 4, 5, 2 },
+    { 2, 5, 3, 0 }
+};
+static const int HexFaces[6][4] = {
+    { 0, 1, 2, 3 }, { 4, 7, 6, 5 }, { 0, 4, 5, 1 }, { 1, 5, 6, 2 },
+    { 2, 6, 7, 3 }, { 3, 7, 4, 0 }
+};
+
+
+// Returns the number of faces of a cell type and sets faces to their table
+static PWP_UINT32
+cellFaces(const PWP_UINT32 type, const int (**faces)[4])
+{
+    switch (type) {
+    case FluentMeshFile::Tri: *faces = TriFaces; return 3;
+    case FluentMeshFile::Quad: *faces = QuadFaces; return 4;
+    case FluentMeshFile::Tet: *faces = TetFaces; return 4;
+    case FluentMeshFile::Pyramid: *faces = PyramidFaces; return 5;
+    case FluentMeshFile::Wedge: *faces = WedgeFaces; return 5;
+    case FluentMeshFile::Hex: *faces = HexFaces; return 6;
+    default: *faces = nullptr; return 0;
+    }
+}
+
+
+// A cell face or a domain element, keyed by its sorted vertices
+struct FaceKey {
+    PWP_UINT32  key[4];     // PWP_BADID after the last vertex
+    PWP_UINT32  owner;      // cell, or domain
+    PWP_UINT32  ndx;        // face of the cell, or domain element
+
+    void setKey(const PWP_UINT32 *verts, const PWP_UINT32 cnt)
+    {
+        // Insertion sort of at most 4 vertices
+        for (PWP_UINT32 i = 0; i < 4; ++i) {
+            key[i] = PWP_BADID;
+        }
+        for (PWP_UINT32 i = 0; i < cnt; ++i) {
+            PWP_UINT32 j = i;
+            for (; j > 0 && key[j - 1] > verts[i]; --j) {
+                key[j] = key[j - 1];
+            }
+            key[j] = verts[i];
+        }
+    }
+};
+
+
+static inline bool
+keyLess(const FaceKey &a, const FaceKey &b)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (a.key[i] != b.key[i]) {
+            return a.key[i] < b.key[i];
+        }
+    }
+    return a.owner < b.owner;
+}
+
+
+static inline bool
+sameKey(const FaceKey &a, const FaceKey &b)
+{
+    return 0 == memcmp(a.key, b.key, sizeof(a.key));
+}
+
+
+// A face of the stream. Faces are streamed in the order of group, owner and
+// cellFace.
+struct StreamFace {
+    PWP_UINT64  group;      // VC group and zone order within it
+    PWP_UINT32  owner;
+    PWP_UINT32  neighbor;   // PWP_BADID for a boundary face
+    PWP_UINT32  domain;     // PWP_BADID if none
+    PWP_UINT8   cellFace;
+    PWP_UINT8   type;       // PWGM_ENUM_FACETYPE
+};
+
+
+static inline bool
+streamLess(const StreamFace &a, const StreamFace &b)
+{
+    if (a.group != b.group) {
+        return a.group < b.group;
+    }
+    if (a.owner != b.owner) {
+        return a.owner < b.owner;
+    }
+    return a.cellFace < b.cellFace;
+}
+
+
+// Runs func(i) for i in [0, cnt) on up to threads threads
+template<typename Func>
+static void
+parallelFor(const size_t cnt, const PWP_UINT32 threads, Func func)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < cnt; i = next++) {
+            func(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (PWP_UINT32 t = 1; t < threads && t < cnt; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (size_t t = 0; t < pool.size(); ++t) {
+        pool[t].join();
+    }
+}
+
+
+// Elements per slice of parallelSort() at most, so that a quit signal is
+// seen within the sort of one slice
+static const size_t SortSlice = 1024 * 1024;
+
+
+// Sorts slices of v on up to threads threads and merges them. Stops at the
+// next slice or merge pass after a quit signal and returns false.
+template<typename T, typename Less>
+static bool
+parallelSort(std::vector<T> &v, const PWP_UINT32 threads, Less less)
+{
+    const size_t n = v.size();
+    const size_t nSlices = std::max<size_t>(std::max<size_t>(1,
+        std::min<size_t>(threads, n / 65536)), (n + SortSlice - 1) /
+        SortSlice);
+    std::vector<size_t> bounds;
+    for (size_t s = 0; s <= nSlices; ++s) {
+        bounds.push_back(n * s / nSlices);
+    }
+    parallelFor(nSlices, threads, [&](size_t s) {
+        if (!QuitSignal) {
+            std::sort(v.begin() + bounds[s], v.begin() + bounds[s + 1],
+                less);
+        }
+    });
+    for (size_t width = 1; width < nSlices && !QuitSignal; width *= 2) {
+        const size_t nMerges = (nSlices + 2 * width - 1) / (2 * width);
+        parallelFor(nMerges, threads, [&](size_t i) {
+            const size_t lo = 2 * width * i;
+            if (lo + width < nSlices && !QuitSignal) {
+                std::inplace_merge(v.begin() + bounds[lo],
+                    v.begin() + bounds[lo + width],
+                    v.begin() + bounds[std::min(lo + 2 * width, nSlices)],
+                    less);
+            }
+        });
+    }
+    return !QuitSignal;
+}
+
+
+// Cells [first, last) of block order position pos, and the index of their
+// first face key
+struct CellChunk {
+    PWP_UINT32  pos;
+    PWP_UINT32  first;
+    PWP_UINT32  last;
+    size_t      keyStart;
+};
+
+// Cells per chunk of the face key generation
+static const PWP_UINT32 ChunkCells = 65536;
+
+
+// The keys of all cell faces, sorted. Stops at the next chunk of cells
+// after a quit signal and returns false.
+static bool
+cellFaceKeys(const BatchModel &m, std::vector<FaceKey> &keys)
+{
+    const FluentMeshFile &file = m.file;
+    std::vector<CellChunk> chunks;
+    for (PWP_UINT32 pos = 0; pos < m.order.size(); ++pos) {
+        const PWP_UINT32 nCells = m.firstCell[pos + 1] - m.firstCell[pos];
+        for (PWP_UINT32 c = 0; c < nCells; c += ChunkCells) {
+            const CellChunk chunk = { pos, c, std::min(nCells, c + ChunkCells),
+                0 };
+            chunks.push_back(chunk);
+        }
+    }
+    std::vector<size_t> faceCnt(chunks.size());
+    parallelFor(chunks.size(), m.threads, [&](size_t i) {
+        if (QuitSignal) {
+            return;
+        }
+        const FluentMeshFile::Entity &ent = file.block(m.order[chunks[i].pos]);
+        const int (*faces)[4];
+        for (PWP_UINT32 c = chunks[i].first; c < chunks[i].last; ++c) {
+            faceCnt[i] += cellFaces(file.elementType(ent, c), &faces);
+        }
+    });
+    if (QuitSignal) {
+        return false;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i].keyStart = total;
+        total += faceCnt[i];
+    }
+    keys.resize(total);
+    parallelFor(chunks.size(), m.threads, [&](size_t i) {
+        if (QuitSignal) {
+            return;
+        }
+        const CellChunk &chunk = chunks[i];
+        const FluentMeshFile::Entity &ent = file.block(m.order[chunk.pos]);
+        FaceKey *k = keys.data() + chunk.keyStart;
+        for (PWP_UINT32 c = chunk.first; c < chunk.last; ++c) {
+            const int (*faces)[4];
+            const PWP_UINT32 nFaces = cellFaces(file.elementType(ent, c),
+                &faces);
+            const PWP_UINT32 *verts = file.elementVerts(ent, c);
+            for (PWP_UINT32 f = 0; f < nFaces; ++f, ++k) {
+                PWP_UINT32 fv[4];
+                PWP_UINT32 n = 0;
+                for (; n < 4 && faces[f][n] >= 0; ++n) {
+                    fv[n] = verts[faces[f][n]];
+                }
+                k->setKey(fv, n);
+                k->owner = m.firstCell[chunk.pos] + c;
+                k->ndx = f;
+            }
+        }
+    });
+    return !QuitSignal && parallelSort(keys, m.threads, keyLess);
+}
+
+
+// The keys of all domain elements, sorted. Returns false after a quit
+// signal.
+static bool
+domainKeys(const BatchModel &m, std::vector<FaceKey> &keys)
+{
+    const FluentMeshFile &file = m.file;
+    for (PWP_UINT32 d = 0; d < file.domainCount(); ++d) {
+        const FluentMeshFile::Entity &ent = file.domain(d);
+        for (PWP_UINT32 e = 0; e < PWP_UINT32(ent.elemCount); ++e) {
+            FaceKey k;
+            k.setKey(file.elementVerts(ent, e),
+                FluentMeshFile::typeVertexCount(file.elementType(ent, e)));
+            k.owner = d;
+            k.ndx = e;
+            keys.push_back(k);
+        }
+    }
+    return parallelSort(keys, m.threads, keyLess);
+}
+
+
+// Pairs the cell faces, matches them to the domains and orders them for
+// the stream. Only faces on a domain are kept if bcOnly. Returns false
+// after a quit signal, which is checked once per ChunkCells faces.
+static bool
+buildFaces(const BatchModel &m, const bool bcOnly,
+    std::vector<StreamFace> &faces, PWGM_BEGINSTREAM_DATA &counts)
+{
+    std::vector<FaceKey> keys;
+    std::vector<FaceKey> domKeys;
+    if (!cellFaceKeys(m, keys) || !domainKeys(m, domKeys)) {
+        return false;
+    }
+
+    const PWP_UINT64 nBlk = m.file.blockCount();
+    const PWP_UINT64 nDom = m.file.domainCount();
+    size_t d = 0;
+    PWP_UINT64 unmatched = 0;
+    PWP_UINT64 bare = 0;
+    size_t nextQuitCheck = ChunkCells;
+    for (size_t i = 0; i < keys.size(); ) {
+        if (i >= nextQuitCheck) {
+            if (QuitSignal) {
+                return false;
+            }
+            nextQuitCheck = i + ChunkCells;
+        }
+        size_t j = i + 1;
+        while (j < keys.size() && sameKey(keys[i], keys[j])) {
+            ++j;
+        }
+        if (j - i > 2) {
+            report("error", "%u cells share a face", PWP_UINT32(j - i));
+            return false;
+        }
+        StreamFace face;
+        face.owner = keys[i].owner;
+        face.cellFace = PWP_UINT8(keys[i].ndx);
+        face.domain = PWP_BADID;
+        while (d < domKeys.size() && keyLess(domKeys[d], keys[i]) &&
+                !sameKey(domKeys[d], keys[i])) {
+            ++d;
+            ++unmatched;
+        }
+        if (d < domKeys.size() && sameKey(domKeys[d], keys[i])) {
+            face.domain = domKeys[d].owner;
+            while (d < domKeys.size() && sameKey(domKeys[d], keys[i])) {
+                ++d;
+            }
+        }
+        PWP_UINT32 block;
+        PWP_UINT32 elem;
+        cellLocation(m, face.owner, block, elem);
+        const PWP_UINT64 vc = PWP_UINT64(m.vcGroup[block]) << 32;
+        const PWP_UINT64 pos = m.orderPos[block];
+        if (1 == j - i) {
+            face.type = PWGM_FACETYPE_BOUNDARY;
+            face.neighbor = PWP_BADID;
+            ++counts.numBoundaryFaces;
+            if (PWP_BADID == face.domain) {
+                ++bare;
+            }
+            // The BC faces of a VC follow its other faces, by domain
+            face.group = vc + 2 * nBlk + ((PWP_BADID == face.domain) ? nDom :
+                face.domain);
+        }
+        else {
+            // keyLess() put the lower cell first
+            PWP_UINT32 nBlock;
+            cellLocation(m, keys[i + 1].owner, nBlock, elem);
+            face.neighbor = keys[i + 1].owner;
+            face.type = (nBlock == block) ? PWGM_FACETYPE_INTERIOR :
+                PWGM_FACETYPE_CONNECTION;
+            if (PWGM_FACETYPE_INTERIOR == face.type) {
+                ++counts.numInteriorFaces;
+            }
+            else {
+                ++counts.numConnectionFaces;
+            }
+            // By block, with its interior faces first
+            face.group = vc + 2 * pos + ((PWGM_FACETYPE_CONNECTION ==
+                face.type) ? 1 : 0);
+        }
+        if (bcOnly) {
+            face.group = vc + face.domain;
+        }
+        if (!bcOnly || PWP_BADID != face.domain) {
+            faces.push_back(face);
+        }
+        i = j;
+    }
+    unmatched += domKeys.size() - d;
+    std::vector<FaceKey>().swap(keys);
+
+    if (0 != unmatched) {
+        report("warning", "%llu domain elements are not cell faces",
+            (unsigned long long)unmatched);
+    }
+    if (0 != bare) {
+        report("warning", "%llu boundary faces are not on a domain",
+            (unsigned long long)bare);
+    }
+    if (faces.size() >= PWP_BADID) {
+        report("error", "too many faces");
+        return false;
+    }
+    counts.totalNumFaces = PWP_UINT32(faces.size());
+    counts.numBoundaryAndConnectionFaces = counts.numBoundaryFaces +
+        counts.numConnectionFaces;
+    return parallelSort(faces, m.threads, streamLess);
+}
+
+
+PWP_BOOL
+PwModStreamFaces(PWGM_HGRIDMODEL model, PWGM_ENUM_FACEORDER order,
+    PWGM_BEGINSTREAM_CALLBACK beginCB, PWGM_FACESTREAM_CALLBACK faceCB,
+    PWGM_ENDSTREAM_CALLBACK endCB, void *userData)
+{
+    const BatchModel &m = modelOf(model);
+    const FluentMeshFile &file = m.file;
+    if (PWGM_FACEORDER_VCGROUPSBCLAST != order &&
+            PWGM_FACEORDER_BCGROUPSONLY != order) {
+        report("error", "face order %d is not supported", int(order));
+        return PWP_FALSE;
+    }
+    PWGM_BEGINSTREAM_DATA begin;
+    memset(&begin, 0, sizeof(begin));
+    begin.userData = userData;
+    begin.model = model;
+    std::vector<StreamFace> faces;
+    bool ok = buildFaces(m, PWGM_FACEORDER_BCGROUPSONLY == order, faces,
+        begin);
+    ok = ok && 0 != beginCB(&begin);
+
+    PWGM_FACESTREAM_DATA data;
+    memset(&data, 0, sizeof(data));
+    data.userData = userData;
+    data.model = model;
+    for (size_t i = 0; ok && i < faces.size(); ++i) {
+        const StreamFace &face = faces[i];
+        PWP_UINT32 block;
+        PWP_UINT32 elem;
+        cellLocation(m, face.owner, block, elem);
+        const FluentMeshFile::Entity &ent = file.block(block);
+        const PWP_UINT32 *verts = file.elementVerts(ent, elem);
+        const int (*cf)[4];
+        cellFaces(file.elementType(ent, elem), &cf);
+        PWP_UINT32 fv[4];
+        PWP_UINT32 n = 0;
+        for (; n < 4 && cf[face.cellFace][n] >= 0; ++n) {
+            fv[n] = verts[cf[face.cellFace][n]];
+        }
+        fillElemData(model, (2 == n) ? FluentMeshFile::Bar :
+            ((3 == n) ? FluentMeshFile::Tri : FluentMeshFile::Quad), fv,
+            data.elemData);
+        data.face = PWP_UINT32(i);
+        data.type = PWGM_ENUM_FACETYPE(face.type);
+        data.owner.block = blockHandle(model, block);
+        data.owner.cellIndex = face.owner;
+        data.owner.cellFaceIndex = face.cellFace;
+        data.owner.domain = domainHandle(model, face.domain);
+        data.neighborCellIndex = face.neighbor;
+        ok = 0 != faceCB(&data);
+    }
+
+    PWGM_ENDSTREAM_DATA end;
+    memset(&end, 0, sizeof(end));
+    end.userData = userData;
+    end.model = model;
+    end.ok = PWP_CAST_BOOL(ok);
+    ok = (0 != endCB(&end)) && ok;
+    return PWP_CAST_BOOL(ok);
+}
+
+
+/************************************************
+*   CAEP utilities
+*************************************************/
+
+static bool
+checkQuit(CAEP_RTITEM *pRti)
+{
+    if (QuitSignal) {
+        pRti->opAborted = PWP_TRUE;
+    }
+    return !pRti->opAborted;
+}
+
+
+PWP_BOOL
+PwuProgressQuit(const char /*api*/[])
+{
+    return PWP_CAST_BOOL(0 != QuitSignal);
+}
+
+
+PWP_BOOL
+caeuProgressInit(CAEP_RTITEM *pRti, PWP_UINT32 cnt)
+{
+    pRti->progTotal = cnt;
+    pRti->progComplete = 0;
+    return PWP_CAST_BOOL(checkQuit(pRti));
+}
+
+
+PWP_BOOL
+caeuProgressBeginStep(CAEP_RTITEM *pRti, PWP_UINT32 /*total*/)
+{
+    return PWP_CAST_BOOL(checkQuit(pRti));
+}
+
+
+PWP_BOOL
+caeuProgressIncr(CAEP_RTITEM *pRti)
+{
+    return PWP_CAST_BOOL(checkQuit(pRti));
+}
+
+
+PWP_BOOL
+caeuProgressEndStep(CAEP_RTITEM *pRti)
+{
+    ++pRti->progComplete;
+    return PWP_CAST_BOOL(checkQuit(pRti));
+}
+
+
+PWP_VOID
+caeuProgressEnd(CAEP_RTITEM * /*pRti*/, PWP_BOOL /*ok*/)
+{
+}
+
+
+PWP_BOOL
+caeuAssignInfoValue(const char /*key*/[], const char /*value*/[],
+    bool /*createOnly*/)
+{
+    return PWP_TRUE;
+}
+
+
+PWP_BOOL
+caeuPublishValueDefinition(const char key[], PWP_ENUM_VALTYPE type,
+    const char value[], const char /*access*/[], const char /*desc*/[],
+    const char range[])
+{
+    Published &pub = Model.published[key];
+    pub.type = type;
+    pub.value = value;
+    pub.range = range;
+    return PWP_TRUE;
+}
+
+
+PWP_VOID
+caeuSendInfoMsg(CAEP_RTITEM * /*pRti*/, const char txt[],
+    PWP_UINT32 /*code*/)
+{
+    if (!Quiet) {
+        report("info", "%s", txt);
+    }
+}
+
+
+PWP_VOID
+caeuSendWarningMsg(CAEP_RTITEM * /*pRti*/, const char txt[],
+    PWP_UINT32 /*code*/)
+{
+    report("warning", "%s", txt);
+}
+
+
+PWP_VOID
+caeuSendErrorMsg(CAEP_RTITEM * /*pRti*/, const char txt[],
+    PWP_UINT32 /*code*/)
+{
+    report("error", "%s", txt);
+}
+
+
+/************************************************
+*   main
+*************************************************/
+
+// The worker threads for the face stream, as runtimeWrite() chooses them
+static PWP_UINT32
+streamThreads(PWGM_HGRIDMODEL model)
+{
+    PWP_UINT32 n = 0;
+    const char *env = getenv("CAEUNSFLUENT_THREADS");
+    if (env && *env) {
+        n = PWP_UINT32(strtoul(env, nullptr, 0));
+    }
+    else {
+        PwModGetAttributeUINT32(model, "Threads", &n);
+    }
+    return (0 != n) ? n : std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+// Sets up rti for the exports of Model and publishes the export attributes
+static bool
+createRuntime(CAEP_RTITEM &rti)
+{
+    static PWU_RTITEM api;
+    memset(&api, 0, sizeof(api));
+    api.apiInfo.name = "fluentBatch";
+    memset(&rti, 0, sizeof(rti));
+    rti.pApiData = &api;
+    rti.pBCInfo = CaeUnsFluentBCInfo;
+    rti.BCCnt = ARRAYSIZE(CaeUnsFluentBCInfo);
+    rti.pVCInfo = CaeUnsFluentVCInfo;
+    rti.VCCnt = ARRAYSIZE(CaeUnsFluentVCInfo);
+    rti.pFileExt = CaeUnsFluentFileExt;
+    rti.ExtCnt = ARRAYSIZE(CaeUnsFluentFileExt);
+    rti.model = modelHandle();
+    return 0 != runtimeCreate(&rti);
+}
+
+
+// Exports the loaded Model to caseFile. Returns 0 on success, 1 if the
+// export failed and 2 if the case file cannot be created.
+static int
+exportModel(CAEP_RTITEM &rti, const char *caseFile,
+    const PWP_ENUM_PRECISION precision)
+{
+    CAEP_WRITEINFO writeInfo;
+    memset(&writeInfo, 0, sizeof(writeInfo));
+    writeInfo.fileDest = caseFile;
+    writeInfo.conditionsOnly = PWP_FALSE;
+    writeInfo.encoding = PWP_ENCODING_ASCII;
+    writeInfo.precision = precision;
+    writeInfo.dimension = (2 == Model.file.dimension()) ? PWP_DIMENSION_2D :
+        PWP_DIMENSION_3D;
+    rti.pWriteInfo = &writeInfo;
+    rti.opAborted = PWP_FALSE;
+    rti.fp = fopen(caseFile, "wb");
+    if (nullptr == rti.fp) {
+        report("error", "cannot open %s", caseFile);
+        return 2;
+    }
+    const bool ok = 0 != runtimeWrite(&rti, rti.model, &writeInfo);
+    fclose(rti.fp);
+    rti.fp = nullptr;
+    rti.pWriteInfo = nullptr;
+    return ok ? 0 : 1;
+}
+
+
+#if !defined(FLUENT_BATCH_NO_MAIN)
+
+static void
+usage()
+{
+    fprintf(stderr,
+        "usage: fluentBatch [options] <mesh file> <case file>\n"
+        "  -f text|cff|both      case file format (CaseFormat)\n"
+        "  -t <n>                worker threads, 0 uses all cores (Threads)\n"
+        "  -s                    report statistics (Stats)\n"
+        "  -p single|double      coordinate precision, default double\n"
+        "  -a <name>=<value>     set an export attribute, may be repeated\n"
+        "  -q                    do not print info messages\n"
+        "  -h                    print this help\n"
+        "The exit status is 0 on success, 1 if the export failed, 2 for a\n"
+        "usage or mesh file error and 3 if it was interrupted.\n");
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    const char *meshFile = nullptr;
+    const char *caseFile = nullptr;
+    PWP_ENUM_PRECISION precision = PWP_PRECISION_DOUBLE;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if ('-' != arg[0]) {
+            if (nullptr == meshFile) {
+                meshFile = arg;
+            }
+            else if (nullptr == caseFile) {
+                caseFile = arg;
+            }
+            else {
+                usage();
+                return 2;
+            }
+            continue;
+        }
+        if (0 == strcmp(arg, "-s")) {
+            Model.attributes["Stats"] = "true";
+        }
+        else if (0 == strcmp(arg, "-q")) {
+            Quiet = true;
+        }
+        else if (0 == strcmp(arg, "-h")) {
+            usage();
+            return 0;
+        }
+        else if (nullptr == val) {
+            usage();
+            return 2;
+        }
+        else if (0 == strcmp(arg, "-f")) {
+            Model.attributes["CaseFormat"] = argv[++i];
+        }
+        else if (0 == strcmp(arg, "-t")) {
+            Model.attributes["Threads"] = argv[++i];
+        }
+        else if (0 == strcmp(arg, "-p") && 0 == strcmp(val, "single")) {
+            precision = PWP_PRECISION_SINGLE;
+            ++i;
+        }
+        else if (0 == strcmp(arg, "-p") && 0 == strcmp(val, "double")) {
+            precision = PWP_PRECISION_DOUBLE;
+            ++i;
+        }
+        else if (0 == strcmp(arg, "-a") && nullptr != strchr(val, '=')) {
+            const char *eq = strchr(argv[++i], '=');
+            Model.attributes[std::string(val, eq)] = eq + 1;
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (nullptr == caseFile) {
+        usage();
+        return 2;
+    }
+
+    CAEP_RTITEM rti;
+    if (!createRuntime(rti) || !checkAttributes(Model)) {
+        return 2;
+    }
+    if (!loadModel(Model, meshFile)) {
+        return 2;
+    }
+    Model.threads = streamThreads(rti.model);
+
+    signal(SIGINT, onQuitSignal);
+    signal(SIGTERM, onQuitSignal);
+    const int status = exportModel(rti, caseFile, precision);
+    runtimeDestroy(&rti);
+    if (QuitSignal) {
+        report("error", "interrupted");
+        return 3;
+    }
+    return status;
+}
+
+#endif // FLUENT_BATCH_NO_MAIN
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,196 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export cell type lists
+ *
+ * FluentCellTypeLists produces the cell type lists of the mixed cell zones
+ * on a worker thread while the faces are streamed. Each list is keyed by its
+ * VC id and produced in the order given to start(). The worker also formats
+ * each list as the body of its cell (12) section with fluentFormatCellTypes(),
+ * so the export thread only copies the text to the case file. take() hands a
+ * list to the export thread, waiting for it if the worker has not got there
+ * yet.
+ *
+ * The worker calls the grid model API while the export thread streams the
+ * faces, so it must only be used with a host whose grid model API is thread
+ * safe. The export turns it on only on request (PipelineCellTypes).
+ *
+ * The lists are held on the heap, not on the export's arena, because the
+ * arena is not thread safe. A list is freed once it is taken.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTCELLTYPES_H_
+#define _FLUENTCELLTYPES_H_
+
+#include "apiPWP.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Appends types to text as the body of a mixed cell (12) section: " %x" per
+// cell, nine cells per line.
+static inline void
+fluentFormatCellTypes(const std::vector<unsigned char> &types,
+    std::string &text)
+{
+    static const char digits[] = "0123456789abcdef";
+    text.reserve(text.size() + 2 * types.size() + types.size() / 9 + 1);
+    for (size_t ndx = 0; ndx < types.size(); ++ndx) {
+        if (0 != ndx && 0 == ndx % 9) {
+            text += '\n';
+        }
+        text += ' ';
+        if (types[ndx] > 0xf) {
+            text += digits[types[ndx] >> 4];
+        }
+        text += digits[types[ndx] & 0xf];
+    }
+    text += '\n';
+}
+
+
+class FluentCellTypeLists {
+public:
+    typedef std::vector<unsigned char> Types;
+
+    // Fills types with the cell types of the VC vcId. Returns false if it
+    // stopped early because cancelled became true.
+    typedef std::function<bool(PWP_UINT32 vcId, Types &types,
+        const std::atomic<bool> &cancelled)> Producer;
+
+    FluentCellTypeLists() :
+        cancelled_(false)
+    {
+    }
+
+    ~FluentCellTypeLists()
+    {
+        stop();
+    }
+
+    // Starts producing the lists of vcIds, in order
+    void start(const std::vector<PWP_UINT32> &vcIds, Producer produce)
+    {
+        stop();
+        cancelled_ = false;
+        lists_.assign(vcIds.size(), List());
+        for (size_t i = 0; i < vcIds.size(); ++i) {
+            lists_[i].vcId = vcIds[i];
+        }
+        produce_ = produce;
+        worker_ = std::thread([this]() { run(); });
+    }
+
+    bool started() const
+    {
+        return worker_.joinable();
+    }
+
+    // Moves the list of vcId to types and its formatted text to text,
+    // waiting for the worker if needed. Returns false if the list was not
+    // produced, in which case the caller makes it itself.
+    bool take(const PWP_UINT32 vcId, Types &types, std::string &text)
+    {
+        for (size_t i = 0; i < lists_.size(); ++i) {
+            List &list = lists_[i];
+            if (list.vcId == vcId) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [&list]() { return list.done; });
+                types.clear();
+                types.swap(list.types);
+                text.clear();
+                text.swap(list.text);
+                const bool ok = list.ok;
+                list.ok = false;
+                return ok;
+            }
+        }
+        return false;
+    }
+
+    // Cancels the lists not produced yet and waits for the worker
+    void stop()
+    {
+        cancelled_ = true;
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+private:
+    struct List {
+        PWP_UINT32  vcId{ 0 };
+        Types       types;
+        std::string text;       // types as formatted by fluentFormatCellTypes
+        bool        done{ false };
+        bool        ok{ false };
+    };
+
+    void run()
+    {
+        for (size_t i = 0; i < lists_.size(); ++i) {
+            Types types;
+            std::string text;
+            bool ok = false;
+            if (!cancelled_) {
+                try {
+                    ok = produce_(lists_[i].vcId, types, cancelled_);
+                    if (ok) {
+                        fluentFormatCellTypes(types, text);
+                    }
+                }
+                catch (const std::bad_alloc &) {
+                    ok = false;
+                    types = Types();
+                    text = std::string();
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            lists_[i].types.swap(types);
+            lists_[i].text.swap(text);
+            lists_[i].ok = ok;
+            lists_[i].done = true;
+            ready_.notify_all();
+        }
+    }
+
+    FluentCellTypeLists(const FluentCellTypeLists&) = delete;
+    FluentCellTypeLists& operator=(const FluentCellTypeLists&) = delete;
+
+private:
+    std::vector<List>       lists_;
+    Producer                produce_;
+    std::atomic<bool>       cancelled_;
+    std::mutex              mutex_;
+    std::condition_variable ready_;
+    std::thread             worker_;
+};
+
+#endif /* _FLUENTCELLTYPES_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,647 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT Common Fluids Format (HDF5) mesh writer
+ *
+ * Writes the mesh to "<case>.h5" using the CFF mesh group layout:
+ *
+ *   /meshes/1                        dimension, nodeCount, cellCount,
+ *                                    faceCount attributes
+ *   /meshes/1/nodes/zoneTopology/    id, minId, maxId, dimension
+ *   /meshes/1/nodes/coords/1         nodeCount x dimension reals (32 bit
+ *                                    for a single precision export)
+ *   /meshes/1/cells/zoneTopology/    id, minId, maxId, cellType
+ *   /meshes/1/cells/ctype/<n>/       section of the n-th cell zone, with
+ *                                    elementType, minId and maxId
+ *                                    attributes. cell-types holds the type
+ *                                    of each cell of a mixed zone.
+ *   /meshes/1/faces/zoneTopology/    id, minId, maxId, zoneType, faceType
+ *   /meshes/1/faces/nodes/1/         nnodes (nodes per face) and nodes
+ *   /meshes/1/faces/c0/1             right cell of each face
+ *   /meshes/1/faces/c1/1             left cell of each face (0 if none)
+ *
+ * The nodes and the faces are one section each, numbered 1, in the order of
+ * their indices. The zoneTopology arrays map the zones to index ranges of
+ * the sections. Every section has minId and maxId attributes and every
+ * group of sections an nSections attribute. The type codes and 1-based
+ * indices are those of the text case file. Zone names are joined with ';'
+ * into the name attribute of each zoneTopology group. Attributes are one
+ * element arrays.
+ *
+ * Every dataset is chunked and deflated. Full chunks are compressed on a
+ * pool of worker threads and stored in order with H5Dwrite_chunk(), so the
+ * export never waits on the HDF5 filter pipeline.
+ *
+ * Build with CAEUNSFLUENT_HAVE_HDF5 defined and link HDF5 (1.10.3 or newer)
+ * and zlib. Without it, FluentCffWriter::open() always fails.
+ *
+ * The writer is experimental. The layout follows the published descriptions
+ * of the format; files written with it have not been read by Fluent.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTCFF_H_
+#define _FLUENTCFF_H_
+
+#include "apiGridModel.h"
+#include "apiPWP.h"
+
+#include <string>
+
+#if defined(CAEUNSFLUENT_HAVE_HDF5)
+
+#include <hdf5.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+
+// Deflates chunks on worker threads
+class FluentChunkCompressor {
+public:
+    typedef std::vector<unsigned char> Bytes;
+
+    FluentChunkCompressor(PWP_UINT32 threads, int level) :
+        level_(level),
+        stop_(false)
+    {
+        for (PWP_UINT32 i = 0; i < std::max(threads, 1u); ++i) {
+            workers_.push_back(std::thread([this]() { run(); }));
+        }
+    }
+
+    ~FluentChunkCompressor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i].join();
+        }
+    }
+
+    // Returns the zlib stream of raw, as the HDF5 deflate filter stores it.
+    // An empty result means compression failed.
+    std::future<Bytes> submit(std::shared_ptr<Bytes> raw)
+    {
+        const int level = level_;
+        std::packaged_task<Bytes()> task([raw, level]() {
+            uLongf len = compressBound(uLong(raw->size()));
+            Bytes out(len);
+            if (Z_OK != compress2(out.data(), &len, raw->data(),
+                    uLong(raw->size()), level)) {
+                len = 0;
+            }
+            out.resize(len);
+            return out;
+        });
+        std::future<Bytes> ret = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+        return ret;
+    }
+
+private:
+    void run()
+    {
+        for (;;) {
+            std::packaged_task<Bytes()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    FluentChunkCompressor(const FluentChunkCompressor&) = delete;
+    FluentChunkCompressor& operator=(const FluentChunkCompressor&) = delete;
+
+private:
+    int                                     level_;
+    bool                                    stop_;
+    std::mutex                              mutex_;
+    std::condition_variable                 cv_;
+    std::deque<std::packaged_task<Bytes()> > tasks_;
+    std::vector<std::thread>                workers_;
+};
+
+
+// A growing, chunked and deflated dataset of rows of cols values of T. Full
+// chunks are compressed on the pool and written in order.
+template<typename T>
+class FluentCffDataset {
+public:
+    typedef FluentChunkCompressor::Bytes Bytes;
+
+    FluentCffDataset() :
+        dset_(-1),
+        pool_(nullptr),
+        cols_(1),
+        chunkRows_(0),
+        rows_(0),
+        chunksWritten_(0),
+        ok_(true)
+    {
+    }
+
+    ~FluentCffDataset()
+    {
+        close();
+    }
+
+    bool create(hid_t loc, const char *name, hid_t fileType, hsize_t cols,
+        hsize_t chunkRows, FluentChunkCompressor *pool)
+    {
+        cols_ = cols;
+        chunkRows_ = chunkRows;
+        pool_ = pool;
+        rows_ = 0;
+        chunksWritten_ = 0;
+        cur_.clear();
+        const int rank = (1 == cols ? 1 : 2);
+        const hsize_t dims[2] = { 0, cols };
+        const hsize_t maxDims[2] = { H5S_UNLIMITED, cols };
+        const hsize_t chunk[2] = { chunkRows, cols };
+        hid_t space = H5Screate_simple(rank, dims, maxDims);
+        hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+        hid_t lcpl = H5Pcreate(H5P_LINK_CREATE);
+        H5Pset_create_intermediate_group(lcpl, 1);
+        H5Pset_chunk(dcpl, rank, chunk);
+        H5Pset_deflate(dcpl, 1);
+        dset_ = H5Dcreate2(loc, name, fileType, space, lcpl, dcpl,
+            H5P_DEFAULT);
+        H5Pclose(lcpl);
+        H5Pclose(dcpl);
+        H5Sclose(space);
+        cur_.reserve(size_t(chunkRows_ * cols_));
+        ok_ = (dset_ >= 0);
+        return ok_;
+    }
+
+    // Appends one row
+    void append(const T *row)
+    {
+        cur_.insert(cur_.end(), row, row + cols_);
+        ++rows_;
+        if (cur_.size() == chunkRows_ * cols_) {
+            submitChunk();
+            drain(false);
+        }
+    }
+
+    void append(const T &value)
+    {
+        append(&value);
+    }
+
+    // Writes the last partial chunk, waits for all chunks and closes the
+    // dataset. Returns false if any step failed.
+    bool close()
+    {
+        if (dset_ < 0) {
+            return ok_;
+        }
+        if (!cur_.empty()) {
+            // Edge chunks are stored full size
+            cur_.resize(size_t(chunkRows_ * cols_), T());
+            submitChunk();
+        }
+        drain(true);
+        const hsize_t dims[2] = { rows_, cols_ };
+        ok_ = (H5Dset_extent(dset_, dims) >= 0) && ok_;
+        ok_ = (H5Dclose(dset_) >= 0) && ok_;
+        dset_ = -1;
+        return ok_;
+    }
+
+private:
+    void submitChunk()
+    {
+        std::shared_ptr<Bytes> raw(new Bytes(cur_.size() * sizeof(T)));
+        memcpy(raw->data(), cur_.data(), raw->size());
+        cur_.clear();
+        pending_.push_back(pool_->submit(raw));
+    }
+
+    // Writes the finished chunks at the front of pending_. If wait, writes
+    // all chunks.
+    void drain(bool wait)
+    {
+        while (!pending_.empty() && (wait || std::future_status::ready ==
+                pending_.front().wait_for(std::chrono::seconds(0)))) {
+            const Bytes bytes = pending_.front().get();
+            pending_.pop_front();
+            const hsize_t offset[2] = { chunksWritten_ * chunkRows_, 0 };
+            const hsize_t dims[2] = { offset[0] + chunkRows_, cols_ };
+            ok_ = ok_ && !bytes.empty() && H5Dset_extent(dset_, dims) >= 0 &&
+                H5Dwrite_chunk(dset_, H5P_DEFAULT, 0, offset, bytes.size(),
+                    bytes.data()) >= 0;
+            ++chunksWritten_;
+        }
+    }
+
+    FluentCffDataset(const FluentCffDataset&) = delete;
+    FluentCffDataset& operator=(const FluentCffDataset&) = delete;
+
+private:
+    hid_t                                   dset_;
+    FluentChunkCompressor                  *pool_;
+    hsize_t                                 cols_;
+    hsize_t                                 chunkRows_;
+    hsize_t                                 rows_;
+    hsize_t                                 chunksWritten_;
+    std::vector<T>                          cur_;
+    std::deque<std::future<Bytes> >         pending_;
+    bool                                    ok_;
+};
+
+
+class FluentCffWriter {
+public:
+    // Values per chunk
+    enum { ChunkSize = 65536 };
+
+    FluentCffWriter() :
+        file_(-1),
+        mesh_(-1),
+        dim_(3),
+        single_(false),
+        ok_(true),
+        faceZone_(0)
+    {
+    }
+
+    ~FluentCffWriter()
+    {
+        close(0, 0, 0);
+    }
+
+    bool open(const char *filename, PWP_UINT32 dim, PWP_UINT32 threads,
+        bool singlePrecision = false)
+    {
+        H5Eset_auto2(H5E_DEFAULT, nullptr, nullptr);
+        file_ = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        if (file_ < 0) {
+            return false;
+        }
+        hid_t lcpl = H5Pcreate(H5P_LINK_CREATE);
+        H5Pset_create_intermediate_group(lcpl, 1);
+        mesh_ = H5Gcreate2(file_, "/meshes/1", lcpl, H5P_DEFAULT,
+            H5P_DEFAULT);
+        H5Pclose(lcpl);
+        dim_ = dim;
+        single_ = singlePrecision;
+        pool_.reset(new FluentChunkCompressor(threads, 1));
+        ok_ = (mesh_ >= 0);
+        return ok_;
+    }
+
+    bool isOpen() const
+    {
+        return file_ >= 0;
+    }
+
+    void beginNodes(PWP_UINT32 zone, PWP_UINT32 nNodes)
+    {
+        addZone(nodeZones_, zone, 1, nNodes, dim_, 0, "");
+        const char *name = "nodes/coords/1";
+        if (single_) {
+            ok_ = coordsSingle_.create(mesh_, name, H5T_IEEE_F32LE, dim_,
+                ChunkSize / dim_, pool_.get()) && ok_;
+        }
+        else {
+            ok_ = coords_.create(mesh_, name, H5T_IEEE_F64LE, dim_,
+                ChunkSize / dim_, pool_.get()) && ok_;
+        }
+    }
+
+    void addNode(PWP_REAL x, PWP_REAL y, PWP_REAL z)
+    {
+        if (single_) {
+            const float xyz[3] = { float(x), float(y), float(z) };
+            coordsSingle_.append(xyz);
+        }
+        else {
+            const double xyz[3] = { x, y, z };
+            coords_.append(xyz);
+        }
+    }
+
+    void endNodes()
+    {
+        ok_ = (single_ ? coordsSingle_.close() : coords_.close()) && ok_;
+    }
+
+    // A mixed zone (cellType 0) is followed by addCellType() for each cell
+    void beginCellZone(PWP_UINT32 zone, PWP_UINT32 first, PWP_UINT32 last,
+        PWP_UINT32 cellType, const std::string &name)
+    {
+        addZone(cellZones_, zone, first, last, cellType, 0, name);
+        const std::string path = "cells/ctype/" +
+            std::to_string(cellZones_.id.size());
+        hid_t grp = createGroup(path.c_str());
+        if (grp >= 0) {
+            writeAttr(grp, "elementType", cellType);
+            writeAttr(grp, "minId", first);
+            writeAttr(grp, "maxId", last);
+            H5Gclose(grp);
+        }
+        if (0 == cellType) {
+            ok_ = ctype_.create(mesh_, (path + "/cell-types").c_str(),
+                H5T_STD_I16LE, 1, ChunkSize, pool_.get()) && ok_;
+        }
+    }
+
+    void addCellType(PWP_UINT32 cellType)
+    {
+        ctype_.append(PWP_UINT16(cellType));
+    }
+
+    void endCellZone()
+    {
+        ok_ = ctype_.close() && ok_;
+    }
+
+    // The faces of all zones go to one section, created for the first zone
+    void beginFaceZone(PWP_UINT32 zone)
+    {
+        faceZone_ = zone;
+        if (!faceZones_.id.empty()) {
+            return;
+        }
+        ok_ = nnodes_.create(mesh_, "faces/nodes/1/nnodes", H5T_STD_I16LE,
+            1, ChunkSize, pool_.get()) && ok_;
+        ok_ = nodes_.create(mesh_, "faces/nodes/1/nodes", H5T_STD_U32LE, 1,
+            ChunkSize, pool_.get()) && ok_;
+        ok_ = c0_.create(mesh_, "faces/c0/1", H5T_STD_U32LE, 1, ChunkSize,
+            pool_.get()) && ok_;
+        ok_ = c1_.create(mesh_, "faces/c1/1", H5T_STD_U32LE, 1, ChunkSize,
+            pool_.get()) && ok_;
+    }
+
+    void addFaces(const PWGM_FACESTREAM_DATA *faces, PWP_UINT32 cnt)
+    {
+        for (PWP_UINT32 i = 0; i < cnt; ++i) {
+            const PWGM_FACESTREAM_DATA &f = faces[i];
+            nnodes_.append(PWP_UINT16(f.elemData.vertCnt));
+            for (PWP_UINT32 n = 0; n < f.elemData.vertCnt; ++n) {
+                nodes_.append(PWP_UINT32(f.elemData.index[n] + 1));
+            }
+            c0_.append(PWP_UINT32(f.owner.cellIndex + 1));
+            c1_.append(PWP_UINT32(PWGM_FACETYPE_BOUNDARY == f.type ? 0 :
+                f.neighborCellIndex + 1));
+        }
+    }
+
+    void endFaceZone(PWP_UINT32 first, PWP_UINT32 last, PWP_UINT32 zoneType,
+        PWP_UINT32 faceType, const std::string &name)
+    {
+        addZone(faceZones_, faceZone_, first, last, zoneType, faceType, name);
+    }
+
+    // Writes the zone topology and the mesh attributes and closes the file.
+    // Returns false if anything failed.
+    bool close(PWP_UINT64 nodeCount, PWP_UINT64 cellCount,
+        PWP_UINT64 faceCount)
+    {
+        if (file_ < 0) {
+            return ok_;
+        }
+        coords_.close();
+        coordsSingle_.close();
+        ctype_.close();
+        ok_ = nnodes_.close() && ok_;
+        ok_ = nodes_.close() && ok_;
+        ok_ = c0_.close() && ok_;
+        ok_ = c1_.close() && ok_;
+        if (0 != nodeCount) {
+            writeTopology("nodes/zoneTopology", nodeZones_, "dimension", "");
+            writeTopology("cells/zoneTopology", cellZones_, "cellType", "");
+            writeTopology("faces/zoneTopology", faceZones_, "zoneType",
+                "faceType");
+            writeSections("nodes/coords", nodeCount, 1);
+            writeSections("cells/ctype", 0, cellZones_.id.size());
+            if (!faceZones_.id.empty()) {
+                writeSections("faces/nodes", faceCount, 1);
+                writeSections("faces/c0", faceCount, 1);
+                writeSections("faces/c1", faceCount, 1);
+            }
+            writeAttr(mesh_, "dimension", dim_);
+            writeAttr(mesh_, "nodeCount", nodeCount);
+            writeAttr(mesh_, "cellCount", cellCount);
+            writeAttr(mesh_, "faceCount", faceCount);
+            writeAttr(mesh_, "nodeOffset", PWP_UINT64(0));
+            writeAttr(mesh_, "cellOffset", PWP_UINT64(0));
+            writeAttr(mesh_, "faceOffset", PWP_UINT64(0));
+            writeAttr(mesh_, "version", PWP_UINT64(1));
+        }
+        pool_.reset();
+        H5Gclose(mesh_);
+        ok_ = (H5Fclose(file_) >= 0) && ok_;
+        mesh_ = -1;
+        file_ = -1;
+        return ok_ && 0 != nodeCount;
+    }
+
+private:
+    struct Zones {
+        std::vector<PWP_UINT32> id;
+        std::vector<PWP_UINT32> minId;
+        std::vector<PWP_UINT32> maxId;
+        std::vector<PWP_UINT32> type1;
+        std::vector<PWP_UINT32> type2;
+        std::string             names;
+    };
+
+    static void addZone(Zones &zones, PWP_UINT32 id, PWP_UINT32 minId,
+        PWP_UINT32 maxId, PWP_UINT32 type1, PWP_UINT32 type2,
+        const std::string &name)
+    {
+        zones.id.push_back(id);
+        zones.minId.push_back(minId);
+        zones.maxId.push_back(maxId);
+        zones.type1.push_back(type1);
+        zones.type2.push_back(type2);
+        zones.names.append(zones.names.empty() ? "" : ";").append(name);
+    }
+
+    // Creates the group at path in the mesh group, with any missing parents
+    hid_t createGroup(const char *path)
+    {
+        hid_t lcpl = H5Pcreate(H5P_LINK_CREATE);
+        H5Pset_create_intermediate_group(lcpl, 1);
+        hid_t grp = H5Gcreate2(mesh_, path, lcpl, H5P_DEFAULT, H5P_DEFAULT);
+        H5Pclose(lcpl);
+        ok_ = (grp >= 0) && ok_;
+        return grp;
+    }
+
+    // Sets the nSections attribute of the group at path. If nItems is not
+    // 0, the group has one section, "1", with items 1..nItems.
+    void writeSections(const char *path, PWP_UINT64 nItems,
+        PWP_UINT64 nSections)
+    {
+        hid_t grp = H5Oopen(mesh_, path, H5P_DEFAULT);
+        ok_ = (grp >= 0) && ok_;
+        if (grp < 0) {
+            return;
+        }
+        writeAttr(grp, "nSections", nSections);
+        if (0 != nItems) {
+            hid_t section = H5Oopen(grp, "1", H5P_DEFAULT);
+            ok_ = (section >= 0) && ok_;
+            if (section >= 0) {
+                writeAttr(section, "minId", PWP_UINT64(1));
+                writeAttr(section, "maxId", nItems);
+                H5Oclose(section);
+            }
+        }
+        H5Oclose(grp);
+    }
+
+    void writeTopology(const char *path, const Zones &zones,
+        const char *type1, const char *type2)
+    {
+        hid_t grp = createGroup(path);
+        if (grp < 0) {
+            return;
+        }
+        writeArray(grp, "id", zones.id);
+        writeArray(grp, "minId", zones.minId);
+        writeArray(grp, "maxId", zones.maxId);
+        writeArray(grp, type1, zones.type1);
+        if (*type2) {
+            writeArray(grp, type2, zones.type2);
+        }
+        // Fixed length string of the joined names
+        hid_t strType = H5Tcopy(H5T_C_S1);
+        H5Tset_size(strType, std::max<size_t>(zones.names.size(), 1));
+        const hsize_t dims[1] = { 1 };
+        hid_t space = H5Screate_simple(1, dims, nullptr);
+        hid_t attr = H5Acreate2(grp, "name", strType, space, H5P_DEFAULT,
+            H5P_DEFAULT);
+        const std::string names = zones.names.empty() ? std::string(" ") :
+            zones.names;
+        ok_ = (attr >= 0) && (H5Awrite(attr, strType, names.c_str()) >= 0) &&
+            ok_;
+        H5Aclose(attr);
+        H5Sclose(space);
+        H5Tclose(strType);
+        H5Gclose(grp);
+    }
+
+    void writeArray(hid_t grp, const char *name,
+        const std::vector<PWP_UINT32> &v)
+    {
+        const hsize_t dims[1] = { v.size() };
+        hid_t space = H5Screate_simple(1, dims, nullptr);
+        hid_t dset = H5Dcreate2(grp, name, H5T_STD_I32LE, space, H5P_DEFAULT,
+            H5P_DEFAULT, H5P_DEFAULT);
+        ok_ = (dset >= 0) && (v.empty() || H5Dwrite(dset, H5T_NATIVE_UINT32,
+            H5S_ALL, H5S_ALL, H5P_DEFAULT, v.data()) >= 0) && ok_;
+        H5Dclose(dset);
+        H5Sclose(space);
+    }
+
+    void writeAttr(hid_t obj, const char *name, PWP_UINT64 value)
+    {
+        const hsize_t dims[1] = { 1 };
+        hid_t space = H5Screate_simple(1, dims, nullptr);
+        hid_t attr = H5Acreate2(obj, name, H5T_STD_I64LE, space, H5P_DEFAULT,
+            H5P_DEFAULT);
+        ok_ = (attr >= 0) && (H5Awrite(attr, H5T_NATIVE_UINT64, &value) >= 0)
+            && ok_;
+        H5Aclose(attr);
+        H5Sclose(space);
+    }
+
+    FluentCffWriter(const FluentCffWriter&) = delete;
+    FluentCffWriter& operator=(const FluentCffWriter&) = delete;
+
+private:
+    hid_t                                   file_;
+    hid_t                                   mesh_;
+    PWP_UINT32                              dim_;
+    bool                                    single_;
+    bool                                    ok_;
+    PWP_UINT32                              faceZone_;
+    std::unique_ptr<FluentChunkCompressor>  pool_;
+    FluentCffDataset<double>                coords_;
+    FluentCffDataset<float>                 coordsSingle_;
+    FluentCffDataset<PWP_UINT16>            ctype_;
+    FluentCffDataset<PWP_UINT16>            nnodes_;
+    FluentCffDataset<PWP_UINT32>            nodes_;
+    FluentCffDataset<PWP_UINT32>            c0_;
+    FluentCffDataset<PWP_UINT32>            c1_;
+    Zones                                   nodeZones_;
+    Zones                                   cellZones_;
+    Zones                                   faceZones_;
+};
+
+#else // !CAEUNSFLUENT_HAVE_HDF5
+
+// Stand-in used when the plugin is built without HDF5. open() fails, so no
+// other method is ever called.
+class FluentCffWriter {
+public:
+    bool open(const char *, PWP_UINT32, PWP_UINT32, bool = false)
+    {
+        return false;
+    }
+    bool isOpen() const { return false; }
+    void beginNodes(PWP_UINT32, PWP_UINT32) {}
+    void addNode(PWP_REAL, PWP_REAL, PWP_REAL) {}
+    void endNodes() {}
+    void beginCellZone(PWP_UINT32, PWP_UINT32, PWP_UINT32, PWP_UINT32,
+        const std::string &) {}
+    void addCellType(PWP_UINT32) {}
+    void endCellZone() {}
+    void beginFaceZone(PWP_UINT32) {}
+    void addFaces(const PWGM_FACESTREAM_DATA *, PWP_UINT32) {}
+    void endFaceZone(PWP_UINT32, PWP_UINT32, PWP_UINT32, PWP_UINT32,
+        const std::string &) {}
+    bool close(PWP_UINT64, PWP_UINT64, PWP_UINT64) { return false; }
+};
+
+#endif // CAEUNSFLUENT_HAVE_HDF5
+
+#endif /* _FLUENTCFF_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,175 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export checkpoint
+ *
+ * FluentCheckpoint records how far an export got: the length and digest of
+ * the case file written so far, the number of streamed faces it holds, and
+ * the exporter state at that face zone boundary. An export of the same model
+ * can verify the file against the record, truncate it to that length and
+ * continue from there. The record is a small text file:
+ *
+ *      fluent-checkpoint 1
+ *      fingerprint <model fingerprint, hex>
+ *      length <case file bytes>
+ *      digest <FluentChunkHash digest of those bytes, hex>
+ *      ordinal <faces of the face stream written>
+ *      state <zone> <faceIndex> <faceStartIndex> <blockIndex> <prevFaceType>
+ *            <prevDom> <prevBlk> <vcCellType> <prevVCId> <prevNeighborVCId>
+ *            <cellCount>                                   (one line)
+ *      cellzones <count>
+ *      <zone> <firstCell> <lastCell>                       (count lines)
+ *      end
+ *
+ * write() replaces the file atomically, so a failure while checkpointing
+ * leaves the previous record in place.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTCHECKPOINT_H_
+#define _FLUENTCHECKPOINT_H_
+
+#include "apiPWP.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+
+struct FluentCheckpoint {
+    struct CellZone {
+        PWP_UINT32  zone;
+        PWP_UINT32  firstCell;
+        PWP_UINT32  lastCell;
+    };
+
+    FluentCheckpoint() :
+        fingerprint(0),
+        length(0),
+        digest(0),
+        ordinal(0),
+        zone(0),
+        faceIndex(0),
+        faceStartIndex(0),
+        blockIndex(0),
+        prevFaceType(0),
+        prevDom(0),
+        prevBlk(0),
+        vcCellType(0),
+        prevVCId(0),
+        prevNeighborVCId(0),
+        cellCount(0)
+    {
+    }
+
+    bool write(const char *filename) const
+    {
+        const std::string tmp = std::string(filename) + ".tmp";
+        FILE *fp = fopen(tmp.c_str(), "w");
+        if (nullptr == fp) {
+            return false;
+        }
+        fprintf(fp, "fluent-checkpoint 1\n");
+        fprintf(fp, "fingerprint %016llx\n", (unsigned long long)fingerprint);
+        fprintf(fp, "length %llu\n", (unsigned long long)length);
+        fprintf(fp, "digest %016llx\n", (unsigned long long)digest);
+        fprintf(fp, "ordinal %llu\n", (unsigned long long)ordinal);
+        fprintf(fp, "state %u %u %u %u %u %u %u %u %u %u %u\n", zone,
+            faceIndex, faceStartIndex, blockIndex, prevFaceType, prevDom,
+            prevBlk, vcCellType, prevVCId, prevNeighborVCId, cellCount);
+        fprintf(fp, "cellzones %u\n", PWP_UINT32(cellZones.size()));
+        for (size_t i = 0; i < cellZones.size(); ++i) {
+            fprintf(fp, "%u %u %u\n", cellZones[i].zone,
+                cellZones[i].firstCell, cellZones[i].lastCell);
+        }
+        fprintf(fp, "end\n");
+        const bool ok = !ferror(fp);
+        if (0 != fclose(fp) || !ok) {
+            remove(tmp.c_str());
+            return false;
+        }
+#if defined(WINDOWS)
+        remove(filename);
+#endif
+        return 0 == rename(tmp.c_str(), filename);
+    }
+
+    bool read(const char *filename)
+    {
+        FILE *fp = fopen(filename, "r");
+        if (nullptr == fp) {
+            return false;
+        }
+        unsigned version = 0;
+        unsigned long long fp64 = 0;
+        unsigned long long len = 0;
+        unsigned long long dig = 0;
+        unsigned long long ord = 0;
+        PWP_UINT32 nZones = 0;
+        bool ok = 1 == fscanf(fp, " fluent-checkpoint %u", &version) &&
+            1 == version &&
+            1 == fscanf(fp, " fingerprint %llx", &fp64) &&
+            1 == fscanf(fp, " length %llu", &len) &&
+            1 == fscanf(fp, " digest %llx", &dig) &&
+            1 == fscanf(fp, " ordinal %llu", &ord) &&
+            11 == fscanf(fp, " state %u %u %u %u %u %u %u %u %u %u %u", &zone,
+                &faceIndex, &faceStartIndex, &blockIndex, &prevFaceType,
+                &prevDom, &prevBlk, &vcCellType, &prevVCId, &prevNeighborVCId,
+                &cellCount) &&
+            1 == fscanf(fp, " cellzones %u", &nZones);
+        cellZones.clear();
+        for (PWP_UINT32 i = 0; ok && i < nZones; ++i) {
+            CellZone cz;
+            ok = 3 == fscanf(fp, " %u %u %u", &cz.zone, &cz.firstCell,
+                &cz.lastCell);
+            cellZones.push_back(cz);
+        }
+        char end[8] = "";
+        ok = ok && 1 == fscanf(fp, " %7s", end) && 0 == strcmp(end, "end");
+        fclose(fp);
+        fingerprint = fp64;
+        length = len;
+        digest = dig;
+        ordinal = ord;
+        return ok;
+    }
+
+    PWP_UINT64              fingerprint;
+    PWP_UINT64              length;
+    PWP_UINT64              digest;
+    PWP_UINT64              ordinal;
+    PWP_UINT32              zone;
+    PWP_UINT32              faceIndex;
+    PWP_UINT32              faceStartIndex;
+    PWP_UINT32              blockIndex;
+    PWP_UINT32              prevFaceType;
+    PWP_UINT32              prevDom;        // domain id or PWP_BADID
+    PWP_UINT32              prevBlk;        // block id or PWP_BADID
+    PWP_UINT32              vcCellType;
+    PWP_UINT32              prevVCId;
+    PWP_UINT32              prevNeighborVCId;
+    PWP_UINT32              cellCount;
+    std::vector<CellZone>   cellZones;
+};
+
+#endif /* _FLUENTCHECKPOINT_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -25,7 +25,9 @@ enum SectionId {
     FLUENT_HEADER = 1,
     FLUENT_DIMENSION = 2,
     FLUENT_PERIODIC_SHADOW = 18,
+    FLUENT_PARTITION = 40,        // cell partition ids
     FLUENT_INTERIOR = 2,          // interior face
+    FLUENT_WALL = 3,              // wall face, the BC zones of a mesh file
 };
 
 enum CellType {
@@ -0,0 +1,406 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT output fan-out
+ *
+ * Lets one export write several copies of the case file from a single pass
+ * over the grid model. FluentTeeSink hands every write to a list of sinks.
+ * Each extra copy is wrapped in a FluentAsyncSink, so its encoding (such as
+ * gzip compression) and I/O run on a worker thread of its own.
+ *
+ * fluentOpenCopySink() opens a copy by file name. Names ending in ".gz" are
+ * gzip compressed, which needs CAEUNSFLUENT_HAVE_ZLIB defined and zlib
+ * linked. Fluent reads compressed case files directly.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTFANOUT_H_
+#define _FLUENTFANOUT_H_
+
+#include "apiPWP.h"
+#include "fluentSink.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(CAEUNSFLUENT_HAVE_ZLIB)
+#   include <zlib.h>
+#endif
+
+
+// Hands every write, patch and flush to each of its sinks. Patchable only if
+// all the sinks are.
+class FluentTeeSink : public FluentSink {
+public:
+    FluentTeeSink()
+    {
+    }
+
+    // The sink must outlive the tee
+    void add(FluentSink *sink)
+    {
+        sinks_.push_back(sink);
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        bool ret = true;
+        for (size_t i = 0; i < sinks_.size(); ++i) {
+            ret = sinks_[i]->write(buf, len) && ret;
+        }
+        pos_ += len;
+        return ret || fail();
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        bool ret = true;
+        for (size_t i = 0; i < sinks_.size(); ++i) {
+            ret = sinks_[i]->patch(offset, buf, len) && ret;
+        }
+        return ret || fail();
+    }
+
+    virtual bool isPatchable() const
+    {
+        for (size_t i = 0; i < sinks_.size(); ++i) {
+            if (!sinks_[i]->isPatchable()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    virtual bool flush()
+    {
+        bool ret = true;
+        for (size_t i = 0; i < sinks_.size(); ++i) {
+            ret = sinks_[i]->flush() && ret;
+        }
+        return (ret || fail()) && ok();
+    }
+
+private:
+    std::vector<FluentSink*>    sinks_;
+};
+
+
+// Runs an owned sink on a worker thread. Writes are collected into blocks of
+// BlockSize bytes and queued. At most MaxQueued blocks wait in the queue, so a
+// slow sink throttles the export instead of growing without bound. flush()
+// waits until the worker has written everything.
+class FluentAsyncSink : public FluentSink {
+public:
+    enum {
+        BlockSize = 1024 * 1024,
+        MaxQueued = 8
+    };
+
+    explicit FluentAsyncSink(FluentSink *sink) :
+        sink_(sink),
+        patchable_(sink->isPatchable()),
+        error_(false),
+        busy_(false),
+        done_(false),
+        worker_(&FluentAsyncSink::run, this)
+    {
+        // Offsets are those of the wrapped sink
+        pos_ = sink->tell();
+        pending_.reserve(BlockSize);
+    }
+
+    virtual ~FluentAsyncSink()
+    {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        wake_.notify_all();
+        worker_.join();
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        if (error_) {
+            return fail();
+        }
+        const char *p = static_cast<const char*>(buf);
+        pending_.insert(pending_.end(), p, p + len);
+        pos_ += len;
+        if (pending_.size() >= BlockSize) {
+            submitPending();
+        }
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        if (!patchable_ || offset + len > pos_ || error_) {
+            return fail();
+        }
+        const PWP_UINT64 pendingStart = pos_ - pending_.size();
+        const char *p = static_cast<const char*>(buf);
+        if (offset < pendingStart) {
+            // part or all of the range is already queued
+            const size_t queued = size_t(std::min<PWP_UINT64>(len,
+                pendingStart - offset));
+            submit(Op::Patch, offset, std::vector<char>(p, p + queued));
+            p += queued;
+            len -= queued;
+            offset += queued;
+        }
+        if (0 != len) {
+            memcpy(&pending_[size_t(offset - pendingStart)], p, len);
+        }
+        return true;
+    }
+
+    virtual bool isPatchable() const
+    {
+        return patchable_;
+    }
+
+    virtual bool flush()
+    {
+        submitPending();
+        submit(Op::Flush, 0, std::vector<char>());
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return queue_.empty() && !busy_; });
+        return !error_ || fail();
+    }
+
+private:
+    struct Op {
+        enum Kind { Write, Patch, Flush };
+
+        Kind                kind;
+        PWP_UINT64          offset;
+        std::vector<char>   bytes;
+    };
+
+    void submitPending()
+    {
+        if (!pending_.empty()) {
+            submit(Op::Write, 0, std::move(pending_));
+            pending_ = std::vector<char>();
+            pending_.reserve(BlockSize);
+        }
+    }
+
+    void submit(Op::Kind kind, PWP_UINT64 offset,
+        std::vector<char> &&bytes)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return queue_.size() < size_t(MaxQueued); });
+        Op op = { kind, offset, std::move(bytes) };
+        queue_.push_back(std::move(op));
+        wake_.notify_one();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [this] { return done_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                break;
+            }
+            Op op = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+            idle_.notify_all();
+            lock.unlock();
+            bool ok = !error_;
+            if (ok) {
+                switch (op.kind) {
+                case Op::Write:
+                    ok = sink_->write(op.bytes.data(), op.bytes.size());
+                    break;
+                case Op::Patch:
+                    ok = sink_->patch(op.offset, op.bytes.data(),
+                        op.bytes.size());
+                    break;
+                case Op::Flush:
+                    ok = sink_->flush();
+                    break;
+                }
+            }
+            lock.lock();
+            busy_ = false;
+            if (!ok) {
+                error_ = true;
+            }
+            idle_.notify_all();
+        }
+    }
+
+    FluentAsyncSink(const FluentAsyncSink&) = delete;
+    FluentAsyncSink& operator=(const FluentAsyncSink&) = delete;
+
+private:
+    std::unique_ptr<FluentSink> sink_;
+    const bool                  patchable_;
+    std::vector<char>           pending_;   // bytes not yet queued
+    std::deque<Op>              queue_;
+    std::mutex                  mutex_;
+    std::condition_variable     wake_;      // signals the worker
+    std::condition_variable     idle_;      // signals the export thread
+    std::atomic<bool>           error_;
+    bool                        busy_;
+    bool                        done_;
+    std::thread                 worker_;    // declared last; started last
+};
+
+
+// A FluentFileSink that owns its FILE
+class FluentOwnedFileSink : public FluentFileSink {
+public:
+    explicit FluentOwnedFileSink(FILE *fp) :
+        FluentFileSink(fp),
+        fp_(fp)
+    {
+    }
+
+    virtual ~FluentOwnedFileSink()
+    {
+        fclose(fp_);
+    }
+
+private:
+    FILE   *fp_;
+};
+
+
+#if defined(CAEUNSFLUENT_HAVE_ZLIB)
+
+// Writes a gzip compressed stream. Not patchable, so the export stages each
+// face zone until its header is final. flush() pushes the compressed bytes
+// to the file at a byte boundary. close() ends the gzip stream.
+class FluentGzipSink : public FluentSink {
+public:
+    explicit FluentGzipSink(gzFile gz) :
+        gz_(gz)
+    {
+    }
+
+    virtual ~FluentGzipSink()
+    {
+        close();
+    }
+
+    // Writes the gzip trailer and closes the file
+    bool close()
+    {
+        bool ret = true;
+        if (nullptr != gz_) {
+            ret = (Z_OK == gzclose(gz_)) || fail();
+            gz_ = nullptr;
+        }
+        return ret;
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        const char *p = static_cast<const char*>(buf);
+        pos_ += len;
+        while (0 != len) {
+            // gzwrite() takes an unsigned length
+            const unsigned n = unsigned(std::min<size_t>(len, 1U << 30));
+            if (0 >= gzwrite(gz_, p, n)) {
+                return fail();
+            }
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 /*offset*/, const void * /*buf*/,
+        size_t /*len*/)
+    {
+        return fail();
+    }
+
+    virtual bool isPatchable() const
+    {
+        return false;
+    }
+
+    virtual bool flush()
+    {
+        // Z_FINISH would end the gzip member and restart the compression
+        return (nullptr != gz_ && Z_OK == gzflush(gz_, Z_SYNC_FLUSH)) ||
+            fail();
+    }
+
+private:
+    gzFile  gz_;
+};
+
+#endif // CAEUNSFLUENT_HAVE_ZLIB
+
+
+// Opens filename as an extra copy of the case file that is written on its
+// own thread. Returns null and sets err on failure.
+static inline FluentSink *
+fluentOpenCopySink(const std::string &filename, std::string &err)
+{
+    const bool gzip = filename.size() > 3 &&
+        0 == filename.compare(filename.size() - 3, 3, ".gz");
+    FluentSink *sink = nullptr;
+    if (gzip) {
+#if defined(CAEUNSFLUENT_HAVE_ZLIB)
+        // favor throughput over compression ratio
+        gzFile gz = gzopen(filename.c_str(), "wb1");
+        if (nullptr != gz) {
+            gzbuffer(gz, 256 * 1024);
+            sink = new FluentGzipSink(gz);
+        }
+#else
+        err = "Could not write " + filename + " (compressed copies need a "
+            "build with CAEUNSFLUENT_HAVE_ZLIB)";
+        return nullptr;
+#endif
+    }
+    else {
+        FILE *fp = fopen(filename.c_str(), "wb");
+        if (nullptr != fp) {
+            sink = new FluentOwnedFileSink(fp);
+        }
+    }
+    if (nullptr == sink) {
+        err = "Could not open " + filename;
+        return nullptr;
+    }
+    return new FluentAsyncSink(sink);
+}
+
+#endif /* _FLUENTFANOUT_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,584 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export hashing
+ *
+ * FluentXxh64 is a streaming implementation of the XXH64 hash. Its digests
+ * match the reference xxHash library.
+ *
+ * FluentChunkHash hashes a byte stream as a list of ChunkSize chunks. The
+ * digest is the XXH64 of the chunk digests and the total length. A stream can
+ * be extended at any time, and the chunks of a file can be hashed in
+ * parallel by fluentHashFile().
+ *
+ * FluentPatchHash computes the same digest for a stream whose bytes may be
+ * patched after they were written. FluentHashSink passes the bytes written
+ * to a sink through a FluentPatchHash of the whole stream and one of each
+ * section, so that the digests of a case file need no second read.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTHASH_H_
+#define _FLUENTHASH_H_
+
+#include "apiPWP.h"
+#include "fluentSink.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+class FluentXxh64 {
+public:
+    explicit FluentXxh64(PWP_UINT64 seed = 0)
+    {
+        reset(seed);
+    }
+
+    void reset(PWP_UINT64 seed = 0)
+    {
+        v_[0] = seed + P1 + P2;
+        v_[1] = seed + P2;
+        v_[2] = seed;
+        v_[3] = seed - P1;
+        seed_ = seed;
+        total_ = 0;
+        used_ = 0;
+    }
+
+    void update(const void *data, size_t len)
+    {
+        const unsigned char *p = static_cast<const unsigned char*>(data);
+        total_ += len;
+        if (used_ + len < 32) {
+            memcpy(buf_ + used_, p, len);
+            used_ += len;
+            return;
+        }
+        if (0 != used_) {
+            const size_t n = 32 - used_;
+            memcpy(buf_ + used_, p, n);
+            stripe(buf_);
+            p += n;
+            len -= n;
+            used_ = 0;
+        }
+        for (; len >= 32; p += 32, len -= 32) {
+            stripe(p);
+        }
+        memcpy(buf_, p, len);
+        used_ = len;
+    }
+
+    // Adds a value as 8 little endian bytes
+    void update64(PWP_UINT64 v)
+    {
+        unsigned char b[8];
+        for (int i = 0; i < 8; ++i) {
+            b[i] = (unsigned char)(v >> (8 * i));
+        }
+        update(b, sizeof(b));
+    }
+
+    // The digest of the bytes so far. More bytes may be added afterwards.
+    PWP_UINT64 digest() const
+    {
+        PWP_UINT64 h;
+        if (total_ >= 32) {
+            h = rotl(v_[0], 1) + rotl(v_[1], 7) + rotl(v_[2], 12) +
+                rotl(v_[3], 18);
+            for (int i = 0; i < 4; ++i) {
+                h ^= round(0, v_[i]);
+                h = h * P1 + P4;
+            }
+        }
+        else {
+            h = seed_ + P5;
+        }
+        h += total_;
+        const unsigned char *p = buf_;
+        size_t len = used_;
+        for (; len >= 8; p += 8, len -= 8) {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * P1 + P4;
+        }
+        if (len >= 4) {
+            h ^= PWP_UINT64(read32(p)) * P1;
+            h = rotl(h, 23) * P2 + P3;
+            p += 4;
+            len -= 4;
+        }
+        for (; 0 != len; ++p, --len) {
+            h ^= (*p) * P5;
+            h = rotl(h, 11) * P1;
+        }
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static const PWP_UINT64 P1 = 11400714785074694791ULL;
+    static const PWP_UINT64 P2 = 14029467366897019727ULL;
+    static const PWP_UINT64 P3 = 1609587929392839161ULL;
+    static const PWP_UINT64 P4 = 9650029242287828579ULL;
+    static const PWP_UINT64 P5 = 2870177450012600261ULL;
+
+    static PWP_UINT64 rotl(PWP_UINT64 x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static PWP_UINT64 round(PWP_UINT64 acc, PWP_UINT64 input)
+    {
+        acc += input * P2;
+        return rotl(acc, 31) * P1;
+    }
+
+    static PWP_UINT64 read64(const unsigned char *p)
+    {
+        PWP_UINT64 v = 0;
+        for (int i = 7; i >= 0; --i) {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+
+    static PWP_UINT32 read32(const unsigned char *p)
+    {
+        return PWP_UINT32(p[0]) | (PWP_UINT32(p[1]) << 8) |
+            (PWP_UINT32(p[2]) << 16) | (PWP_UINT32(p[3]) << 24);
+    }
+
+    void stripe(const unsigned char *p)
+    {
+        for (int i = 0; i < 4; ++i) {
+            v_[i] = round(v_[i], read64(p + 8 * i));
+        }
+    }
+
+private:
+    PWP_UINT64      v_[4];
+    PWP_UINT64      seed_;
+    PWP_UINT64      total_;
+    unsigned char   buf_[32];
+    size_t          used_;
+};
+
+
+class FluentChunkHash {
+public:
+    enum { ChunkSize = 1024 * 1024 };
+
+    FluentChunkHash() :
+        length_(0)
+    {
+    }
+
+    // Appends bytes to the hashed stream
+    void append(const void *data, size_t len)
+    {
+        const char *p = static_cast<const char*>(data);
+        while (0 != len) {
+            const size_t room = size_t(ChunkSize - length_ % ChunkSize);
+            const size_t n = std::min(len, room);
+            chunk_.update(p, n);
+            length_ += n;
+            p += n;
+            len -= n;
+            if (n == room) {
+                chunks_.push_back(chunk_.digest());
+                chunk_.reset();
+            }
+        }
+    }
+
+    PWP_UINT64 length() const
+    {
+        return length_;
+    }
+
+    PWP_UINT64 digest() const
+    {
+        FluentXxh64 h;
+        for (size_t i = 0; i < chunks_.size(); ++i) {
+            h.update64(chunks_[i]);
+        }
+        if (0 != length_ % ChunkSize) {
+            h.update64(chunk_.digest());
+        }
+        h.update64(length_);
+        return h.digest();
+    }
+
+    // Appends full chunks given their digests. The stream length must be a
+    // multiple of ChunkSize.
+    void appendChunks(const std::vector<PWP_UINT64> &chunks)
+    {
+        chunks_.insert(chunks_.end(), chunks.begin(), chunks.end());
+        length_ += PWP_UINT64(chunks.size()) * ChunkSize;
+    }
+
+private:
+    PWP_UINT64              length_;
+    FluentXxh64             chunk_;     // the partial last chunk
+    std::vector<PWP_UINT64> chunks_;    // digests of the full chunks
+};
+
+
+// The FluentChunkHash digest of a stream in which ranges can be held for a
+// later patch(). A complete chunk that overlaps a held range is kept in
+// memory until the range is released. All other chunks are digested as soon
+// as they are complete, so a hold costs at most a chunk or two of memory.
+class FluentPatchHash {
+public:
+    enum { ChunkSize = FluentChunkHash::ChunkSize };
+
+    FluentPatchHash() :
+        length_(0)
+    {
+    }
+
+    void append(const void *data, size_t len)
+    {
+        const char *p = static_cast<const char*>(data);
+        while (0 != len) {
+            if (cur_.capacity() < size_t(ChunkSize)) {
+                cur_.reserve(ChunkSize);
+            }
+            const size_t n = std::min(len, size_t(ChunkSize) - cur_.size());
+            cur_.insert(cur_.end(), p, p + n);
+            length_ += n;
+            p += n;
+            len -= n;
+            if (size_t(ChunkSize) == cur_.size()) {
+                completeChunk();
+            }
+        }
+    }
+
+    // Holds the bytes [offset, offset + len) for patch(). They need not have
+    // been appended yet.
+    void hold(PWP_UINT64 offset, PWP_UINT64 len)
+    {
+        holds_.push_back(Range(offset, offset + len));
+    }
+
+    // Overwrites appended bytes in a held range or in the last chunk.
+    // Returns false if some of the bytes were digested already.
+    bool patch(PWP_UINT64 offset, const void *data, size_t len)
+    {
+        const char *p = static_cast<const char*>(data);
+        while (0 != len) {
+            const PWP_UINT64 index = offset / ChunkSize;
+            const size_t at = size_t(offset % ChunkSize);
+            const size_t n = std::min(len, size_t(ChunkSize) - at);
+            std::vector<char> *bytes = chunkBytes(index);
+            if (nullptr == bytes || at + n > bytes->size()) {
+                return false;
+            }
+            memcpy(&(*bytes)[at], p, n);
+            offset += n;
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    // Releases the hold that starts at offset
+    void release(PWP_UINT64 offset)
+    {
+        for (size_t i = 0; i < holds_.size(); ++i) {
+            if (holds_[i].first == offset) {
+                holds_.erase(holds_.begin() + ptrdiff_t(i));
+                break;
+            }
+        }
+        for (size_t i = 0; i < held_.size(); ) {
+            if (isHeld(held_[i].first)) {
+                ++i;
+            }
+            else {
+                chunks_[size_t(held_[i].first)] = hash(held_[i].second);
+                held_.erase(held_.begin() + ptrdiff_t(i));
+            }
+        }
+    }
+
+    PWP_UINT64 length() const
+    {
+        return length_;
+    }
+
+    // The FluentChunkHash digest of the bytes, as patched so far
+    PWP_UINT64 digest() const
+    {
+        FluentXxh64 h;
+        for (size_t i = 0; i < chunks_.size(); ++i) {
+            // A held chunk only has a placeholder digest
+            const std::vector<char> *bytes = heldBytes(i);
+            h.update64(bytes ? hash(*bytes) : chunks_[i]);
+        }
+        if (!cur_.empty()) {
+            h.update64(hash(cur_));
+        }
+        h.update64(length_);
+        return h.digest();
+    }
+
+private:
+    typedef std::pair<PWP_UINT64, PWP_UINT64> Range;    // [first, second)
+    typedef std::pair<PWP_UINT64, std::vector<char> > Chunk;
+
+    static PWP_UINT64 hash(const std::vector<char> &bytes)
+    {
+        FluentXxh64 h;
+        h.update(bytes.data(), bytes.size());
+        return h.digest();
+    }
+
+    bool isHeld(PWP_UINT64 index) const
+    {
+        const PWP_UINT64 first = index * ChunkSize;
+        const PWP_UINT64 last = first + ChunkSize;
+        for (size_t i = 0; i < holds_.size(); ++i) {
+            if (holds_[i].first < last && holds_[i].second > first) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<char> *heldBytes(PWP_UINT64 index) const
+    {
+        for (size_t i = 0; i < held_.size(); ++i) {
+            if (held_[i].first == index) {
+                return &held_[i].second;
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<char> *chunkBytes(PWP_UINT64 index)
+    {
+        if (index == chunks_.size()) {
+            return &cur_;
+        }
+        return const_cast<std::vector<char>*>(heldBytes(index));
+    }
+
+    void completeChunk()
+    {
+        const PWP_UINT64 index = chunks_.size();
+        chunks_.push_back(0);
+        if (isHeld(index)) {
+            held_.push_back(Chunk(index, std::vector<char>()));
+            held_.back().second.swap(cur_);
+        }
+        else {
+            chunks_.back() = hash(cur_);
+            cur_.clear();
+        }
+    }
+
+private:
+    PWP_UINT64              length_;
+    std::vector<char>       cur_;       // bytes of the partial last chunk
+    std::vector<PWP_UINT64> chunks_;    // digests of the full chunks
+    std::vector<Chunk>      held_;      // full chunks that are still held
+    std::vector<Range>      holds_;
+};
+
+
+// Hashes the bytes written to sink, as a whole and by section. Sections are
+// consecutive: each one ends where the next begins or at endSection(). The
+// caller holds the ranges it will patch and releases them once patched.
+class FluentHashSink : public FluentSink {
+public:
+    struct Section {
+        std::string name;
+        PWP_UINT64  offset;
+        PWP_UINT64  length;
+        PWP_UINT64  digest;
+    };
+
+    explicit FluentHashSink(FluentSink &sink) :
+        sink_(sink),
+        sectionStart_(0),
+        sectionOpen_(false)
+    {
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        file_.append(buf, len);
+        section_.append(buf, len);
+        pos_ += len;
+        return sink_.write(buf, len) || fail();
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        // The digests are wrong if the bytes were not held
+        if (!file_.patch(offset, buf, len) || offset < sectionStart_ ||
+                !section_.patch(offset - sectionStart_, buf, len)) {
+            fail();
+        }
+        return sink_.patch(offset, buf, len) || fail();
+    }
+
+    virtual bool isPatchable() const
+    {
+        return sink_.isPatchable();
+    }
+
+    virtual bool flush()
+    {
+        return sink_.flush() && ok();
+    }
+
+    void beginSection(const std::string &name)
+    {
+        endSection();
+        sectionName_ = name;
+        sectionStart_ = pos_;
+        sectionOpen_ = true;
+    }
+
+    void endSection()
+    {
+        if (sectionOpen_) {
+            const Section section = { sectionName_, sectionStart_,
+                pos_ - sectionStart_, section_.digest() };
+            sections_.push_back(section);
+            section_ = FluentPatchHash();
+            sectionOpen_ = false;
+        }
+    }
+
+    // Holds the len bytes at offset until release(offset)
+    void hold(PWP_UINT64 offset, PWP_UINT64 len)
+    {
+        file_.hold(offset, len);
+        section_.hold(offset - sectionStart_, len);
+    }
+
+    void release(PWP_UINT64 offset)
+    {
+        file_.release(offset);
+        section_.release(offset - sectionStart_);
+    }
+
+    // The FluentChunkHash digest of everything written
+    PWP_UINT64 digest() const
+    {
+        return file_.digest();
+    }
+
+    const std::vector<Section> &sections() const
+    {
+        return sections_;
+    }
+
+private:
+    FluentSink             &sink_;
+    FluentPatchHash         file_;
+    FluentPatchHash         section_;
+    std::string             sectionName_;
+    PWP_UINT64              sectionStart_;
+    bool                    sectionOpen_;
+    std::vector<Section>    sections_;
+};
+
+
+// Hashes the first length bytes of filename into hash, which must be empty,
+// with up to threads readers. More bytes can then be appended to hash.
+// Returns false if the file is shorter or cannot be read.
+static inline bool
+fluentHashFile(const char *filename, PWP_UINT64 length, PWP_UINT32 threads,
+    FluentChunkHash &hash)
+{
+    const PWP_UINT64 chunkSize = FluentChunkHash::ChunkSize;
+    const PWP_UINT64 nChunks = length / chunkSize;
+    std::vector<PWP_UINT64> chunks(size_t(nChunks), 0);
+    const PWP_UINT64 nThreads = std::max<PWP_UINT64>(1,
+        std::min<PWP_UINT64>(threads, nChunks));
+    std::vector<char> ok(size_t(nThreads), 0);
+    std::vector<char> tailBytes;
+    auto seek = [](FILE *fp, PWP_UINT64 offset) {
+#if defined(WINDOWS)
+        return 0 == _fseeki64(fp, (__int64)offset, SEEK_SET);
+#else
+        return 0 == fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+    };
+    // Each reader hashes a range of full chunks. Reader 0 also appends the
+    // partial last chunk to hash.
+    auto hashRange = [&](PWP_UINT64 t) {
+        FILE *fp = fopen(filename, "rb");
+        if (nullptr == fp) {
+            return;
+        }
+        const PWP_UINT64 first = nChunks * t / nThreads;
+        const PWP_UINT64 last = nChunks * (t + 1) / nThreads;
+        std::vector<char> buf(FluentChunkHash::ChunkSize);
+        bool good = seek(fp, first * chunkSize);
+        for (PWP_UINT64 c = first; good && c < last; ++c) {
+            good = (buf.size() == fread(buf.data(), 1, buf.size(), fp));
+            FluentXxh64 h;
+            h.update(buf.data(), buf.size());
+            chunks[size_t(c)] = h.digest();
+        }
+        if (good && 0 == t) {
+            const size_t tail = size_t(length - nChunks * chunkSize);
+            good = seek(fp, nChunks * chunkSize) &&
+                (tail == fread(buf.data(), 1, tail, fp));
+            tailBytes.assign(buf.data(), buf.data() + tail);
+        }
+        fclose(fp);
+        ok[size_t(t)] = good;
+    };
+    std::vector<std::thread> workers;
+    for (PWP_UINT64 t = 1; t < nThreads; ++t) {
+        workers.push_back(std::thread(hashRange, t));
+    }
+    hashRange(0);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        return false;
+    }
+    hash.appendChunks(chunks);
+    hash.append(tailBytes.data(), tailBytes.size());
+    return true;
+}
+
+#endif /* _FLUENTHASH_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
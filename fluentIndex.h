@@ -0,0 +1,103 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT case file section index
+ *
+ * Records where each data section of the case file starts and how long it
+ * is, and writes that as a sidecar text file. Readers can seek straight to a
+ * zone instead of scanning the whole case file.
+ *
+ * The index file has one line per section:
+ *
+ *   zone section first last offset length type name
+ *
+ * zone     the zone id
+ * section  the section id (10 nodes, 12 cells, 13 faces, 40 partitions)
+ * first    first node, cell or face index of the section
+ * last     last node, cell or face index of the section
+ * offset   byte offset of the section's opening parenthesis
+ * length   byte length of the section through its closing "))\n"
+ * type     the zone's BC or VC type, "-" if none
+ * name     the zone's name, "-" if none
+ *
+ * All values are decimal. Lines starting with '#' are comments.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTINDEX_H_
+#define _FLUENTINDEX_H_
+
+#include "apiPWP.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+
+class FluentSectionIndex {
+public:
+    struct Entry {
+        PWP_UINT32  zone;
+        PWP_UINT32  section;
+        PWP_UINT32  first;
+        PWP_UINT32  last;
+        PWP_UINT64  offset;
+        PWP_UINT64  length;
+        std::string type;
+        std::string name;
+    };
+
+    void add(const Entry &entry)
+    {
+        entries_.push_back(entry);
+    }
+
+    const std::vector<Entry> & entries() const
+    {
+        return entries_;
+    }
+
+    bool write(const char *filename) const
+    {
+        FILE *fp = fopen(filename, "w");
+        if (nullptr == fp) {
+            return false;
+        }
+        fprintf(fp, "# CaeUnsFluent section index 1\n"
+            "# zone section first last offset length type name\n");
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            const Entry &e = entries_[i];
+            fprintf(fp, "%u %u %u %u %llu %llu %s %s\n", e.zone, e.section,
+                e.first, e.last, (unsigned long long)e.offset,
+                (unsigned long long)e.length,
+                (e.type.empty() ? "-" : e.type.c_str()),
+                (e.name.empty() ? "-" : e.name.c_str()));
+        }
+        const bool ret = !ferror(fp);
+        return (0 == fclose(fp)) && ret;
+    }
+
+private:
+    std::vector<Entry>  entries_;
+};
+
+#endif /* _FLUENTINDEX_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,231 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export mesh cache
+ *
+ * A MeshCache export writes the grid of a model to a mesh file named by its
+ * fingerprint. Later exports of the same grid leave the mesh file alone and
+ * write only the zone sections (45), which name and type the zones by the
+ * current conditions. FluentMeshZones records the zones of a mesh file so
+ * that those sections can be written without streaming the grid again. It is
+ * kept next to the mesh file as a small text file:
+ *
+ *      fluent-mesh-zones 1
+ *      fingerprint <grid fingerprint, hex>
+ *      zones <count>
+ *      <zone> <kind> <id> <id2>                            (count lines)
+ *      end
+ *
+ * kind is c for a cell zone of the VC id, b for a BC face zone of the domain
+ * index id and i for an interior face zone between the VCs id and id2 (id2
+ * is PWP_BADID for the faces inside one VC). The record is written once the
+ * mesh file is complete, so a mesh file without one is not used.
+ *
+ * The folder of the mesh files is created with fluentCreateFolder() if it
+ * does not exist. Exports of the same grid may write the mesh file at the
+ * same time. Each writes its mesh file and record to temporary files of its
+ * own, made with fluentCreateTempFile(), and renames them into place.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTMESHCACHE_H_
+#define _FLUENTMESHCACHE_H_
+
+#include "apiPWP.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <sys/stat.h>
+
+#if defined(WINDOWS)
+#   include <atomic>
+#   include <direct.h>
+#   include <process.h>
+#else
+#   include <unistd.h>
+#endif
+
+
+// true if path is an existing folder
+static inline bool
+fluentIsFolder(const std::string &path)
+{
+    struct stat st;
+    return 0 == stat(path.c_str(), &st) && 0 != (st.st_mode & S_IFDIR);
+}
+
+
+// Creates the folder path and its missing parent folders, like mkdir -p.
+// Returns true if the folder exists afterwards.
+static inline bool
+fluentCreateFolder(const std::string &path)
+{
+    size_t sep = path.find_first_of("/\\", 1);
+    while (true) {
+        const std::string dir = path.substr(0, sep);
+        if (!fluentIsFolder(dir)) {
+#if defined(WINDOWS)
+            const int ret = _mkdir(dir.c_str());
+#else
+            const int ret = mkdir(dir.c_str(), 0755);
+#endif
+            // another export may have created it meanwhile
+            if (0 != ret && EEXIST != errno) {
+                return false;
+            }
+        }
+        if (std::string::npos == sep) {
+            break;
+        }
+        sep = path.find_first_of("/\\", sep + 1);
+    }
+    return fluentIsFolder(path);
+}
+
+
+// Creates a file with a unique name next to path, to be renamed to path once
+// it is written, and opens it with mode ("w" or "wb"). Sets tmp to its name.
+// Returns null on failure.
+static inline FILE *
+fluentCreateTempFile(const std::string &path, std::string &tmp,
+    const char *mode)
+{
+#if !defined(WINDOWS)
+    tmp = path + ".tmp.XXXXXX";
+    const int fd = mkstemp(&tmp[0]);
+    if (fd < 0) {
+        return nullptr;
+    }
+    // mkstemp() makes the file private, but the cache is shared
+    fchmod(fd, 0644);
+    FILE *fp = fdopen(fd, mode);
+    if (nullptr == fp) {
+        ::close(fd);
+        remove(tmp.c_str());
+    }
+    return fp;
+#else
+    static std::atomic<unsigned> serial(0);
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", _getpid(), serial++);
+    tmp = path + suffix;
+    // "x" fails if the file exists
+    return fopen(tmp.c_str(), (std::string(mode) + "x").c_str());
+#endif
+}
+
+
+struct FluentMeshZones {
+    enum Kind {
+        Cell = 'c',
+        Boundary = 'b',
+        Interior = 'i'
+    };
+
+    struct Zone {
+        PWP_UINT32  zone;
+        char        kind;
+        PWP_UINT32  id;
+        PWP_UINT32  id2;
+    };
+
+    FluentMeshZones() :
+        fingerprint(0)
+    {
+    }
+
+    void add(const PWP_UINT32 zone, const Kind kind, const PWP_UINT32 id,
+        const PWP_UINT32 id2 = PWP_BADID)
+    {
+        const Zone z = { zone, char(kind), id, id2 };
+        zones.push_back(z);
+    }
+
+    bool write(const char *filename) const
+    {
+        std::string tmp;
+        FILE *fp = fluentCreateTempFile(filename, tmp, "w");
+        if (nullptr == fp) {
+            return false;
+        }
+        fprintf(fp, "fluent-mesh-zones 1\n");
+        fprintf(fp, "fingerprint %016llx\n", (unsigned long long)fingerprint);
+        fprintf(fp, "zones %u\n", PWP_UINT32(zones.size()));
+        for (size_t i = 0; i < zones.size(); ++i) {
+            fprintf(fp, "%u %c %u %u\n", zones[i].zone, zones[i].kind,
+                zones[i].id, zones[i].id2);
+        }
+        fprintf(fp, "end\n");
+        const bool ok = !ferror(fp);
+        if (0 != fclose(fp) || !ok) {
+            remove(tmp.c_str());
+            return false;
+        }
+#if defined(WINDOWS)
+        remove(filename);
+#endif
+        if (0 != rename(tmp.c_str(), filename)) {
+            remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool read(const char *filename)
+    {
+        FILE *fp = fopen(filename, "r");
+        if (nullptr == fp) {
+            return false;
+        }
+        unsigned version = 0;
+        unsigned long long fp64 = 0;
+        PWP_UINT32 nZones = 0;
+        bool ok = 1 == fscanf(fp, " fluent-mesh-zones %u", &version) &&
+            1 == version &&
+            1 == fscanf(fp, " fingerprint %llx", &fp64) &&
+            1 == fscanf(fp, " zones %u", &nZones);
+        zones.clear();
+        for (PWP_UINT32 i = 0; ok && i < nZones; ++i) {
+            Zone z;
+            ok = 4 == fscanf(fp, " %u %c %u %u", &z.zone, &z.kind, &z.id,
+                &z.id2) && (Cell == z.kind || Boundary == z.kind ||
+                    Interior == z.kind);
+            zones.push_back(z);
+        }
+        char end[8] = "";
+        ok = ok && 1 == fscanf(fp, " %7s", end) && 0 == strcmp(end, "end");
+        fclose(fp);
+        fingerprint = fp64;
+        return ok;
+    }
+
+    PWP_UINT64          fingerprint;
+    std::vector<Zone>   zones;
+};
+
+#endif /* _FLUENTMESHCACHE_H_ */
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
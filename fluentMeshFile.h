@@ -0,0 +1,599 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT batch mesh file
+ *
+ * The mesh interchange file read by the fluentBatch converter. It holds the
+ * vertices, the cells of each block with its volume condition and the
+ * boundary elements of each domain with its boundary condition. All data is
+ * stored as the arrays the converter uses, so FluentMeshFile maps the file
+ * into memory and reads it in place.
+ *
+ * All values are little endian. Every array starts at a multiple of 8
+ * bytes. Offsets are bytes from the start of the file.
+ *
+ *   header      128 bytes
+ *     char[8]   magic "FMSH\r\n\032\n"
+ *     uint32    version, 1
+ *     uint32    dimension, 2 or 3
+ *     uint64    vertex count
+ *     uint32    block count
+ *     uint32    domain count
+ *     uint64    offset of the vertices
+ *     uint64    offset of the entity table
+ *     uint64    offset of the string table
+ *     uint64    size of the string table
+ *     uint64    size of the file
+ *     uint64[7] reserved, 0
+ *   vertices    double[vertex count][3], x y z. z is 0 in 2D.
+ *   entities    the blocks, then the domains, 48 bytes each
+ *     uint32    string table offset of the condition name
+ *     uint32    condition id, 0xffffffff for an unspecified condition
+ *     uint32    string table offset of the condition type, e.g. "Wall"
+ *     uint32    solver id of the condition type, e.g. 3
+ *     uint64    element count
+ *     uint64    offset of the element types, uint8[element count]
+ *     uint64    offset of the element starts, uint64[element count + 1]
+ *     uint64    offset of the element vertices, uint32[last element start]
+ *   strings     NUL terminated UTF-8 strings
+ *
+ * Element i of an entity has the type types[i] and the 0-based vertices
+ * verts[start[i]] .. verts[start[i + 1] - 1]. start[0] is 0.
+ *
+ *   type        vertices    3D          2D
+ *   1 bar       2                       domains
+ *   2 tri       3           domains     blocks
+ *   3 quad      4           domains     blocks
+ *   4 tet       4           blocks
+ *   5 pyramid   5           blocks
+ *   6 wedge     6           blocks
+ *   7 hex       8           blocks
+ *
+ * Cell vertices are in the CGNS order. The base of a tet or pyramid and the
+ * bottom of a wedge or hex (vertices 0, 1, 2, ...) are ordered so that the
+ * right-hand rule points into the cell, and top vertex i + 3 of a wedge or
+ * i + 4 of a hex is above bottom vertex i. 2D cells are counterclockwise
+ * seen from +z. The vertices of a domain element may be in any order.
+ *
+ * A file can describe up to 2^32 - 2 vertices and elements per entity.
+ * FluentMeshWriter builds a file in memory.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTMESHFILE_H_
+#define _FLUENTMESHFILE_H_
+
+#include "apiPWP.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if !defined(WINDOWS)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/types.h>
+#   include <unistd.h>
+#endif
+
+
+class FluentMeshFile {
+public:
+    enum ElemType {
+        Bar = 1,
+        Tri,
+        Quad,
+        Tet,
+        Pyramid,
+        Wedge,
+        Hex,
+        TypeEnd
+    };
+
+    struct Header {
+        char        magic[8];
+        PWP_UINT32  version;
+        PWP_UINT32  dimension;
+        PWP_UINT64  vertexCount;
+        PWP_UINT32  blockCount;
+        PWP_UINT32  domainCount;
+        PWP_UINT64  vertexOffset;
+        PWP_UINT64  entityOffset;
+        PWP_UINT64  stringOffset;
+        PWP_UINT64  stringSize;
+        PWP_UINT64  fileSize;
+        PWP_UINT64  reserved[7];
+    };
+
+    struct Entity {
+        PWP_UINT32  name;
+        PWP_UINT32  id;
+        PWP_UINT32  type;
+        PWP_UINT32  typeId;
+        PWP_UINT64  elemCount;
+        PWP_UINT64  typesOffset;
+        PWP_UINT64  startOffset;
+        PWP_UINT64  vertsOffset;
+    };
+
+    static const char *magic()
+    {
+        return "FMSH\r\n\032\n";
+    }
+
+    static PWP_UINT32 typeVertexCount(const PWP_UINT32 type)
+    {
+        static const PWP_UINT32 counts[TypeEnd] = { 0, 2, 3, 4, 4, 5, 6, 8 };
+        return (type < TypeEnd) ? counts[type] : 0;
+    }
+
+    FluentMeshFile() :
+        base_(nullptr),
+        size_(0),
+        mapped_(false)
+    {
+    }
+
+    ~FluentMeshFile()
+    {
+        close();
+    }
+
+    // Maps the file and checks all of it. error() tells why it failed.
+    bool open(const char *filename)
+    {
+        close();
+        if (!load(filename)) {
+            close();
+            return false;
+        }
+        if (!validate()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+#if !defined(WINDOWS)
+        if (mapped_) {
+            munmap(const_cast<char*>(base_), size_t(size_));
+        }
+#endif
+        buf_.clear();
+        buf_.shrink_to_fit();
+        base_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+    }
+
+    const std::string & error() const
+    {
+        return error_;
+    }
+
+    PWP_UINT32 dimension() const
+    {
+        return header().dimension;
+    }
+
+    PWP_UINT32 vertexCount() const
+    {
+        return PWP_UINT32(header().vertexCount);
+    }
+
+    // The x, y and z of vertex ndx
+    const double *vertex(const PWP_UINT32 ndx) const
+    {
+        return at<double>(header().vertexOffset) + 3 * size_t(ndx);
+    }
+
+    PWP_UINT32 blockCount() const
+    {
+        return header().blockCount;
+    }
+
+    PWP_UINT32 domainCount() const
+    {
+        return header().domainCount;
+    }
+
+    const Entity & block(const PWP_UINT32 ndx) const
+    {
+        return at<Entity>(header().entityOffset)[ndx];
+    }
+
+    const Entity & domain(const PWP_UINT32 ndx) const
+    {
+        return at<Entity>(header().entityOffset)[blockCount() + ndx];
+    }
+
+    const char *string(const PWP_UINT32 offset) const
+    {
+        return at<char>(header().stringOffset) + offset;
+    }
+
+    PWP_UINT32 elementType(const Entity &ent, const PWP_UINT32 ndx) const
+    {
+        return at<PWP_UINT8>(ent.typesOffset)[ndx];
+    }
+
+    // The typeVertexCount() vertices of element ndx
+    const PWP_UINT32 *elementVerts(const Entity &ent,
+        const PWP_UINT32 ndx) const
+    {
+        return at<PWP_UINT32>(ent.vertsOffset) +
+            at<PWP_UINT64>(ent.startOffset)[ndx];
+    }
+
+private:
+    const Header & header() const
+    {
+        return *at<Header>(0);
+    }
+
+    template<typename T>
+    const T *at(const PWP_UINT64 offset) const
+    {
+        return reinterpret_cast<const T*>(base_ + offset);
+    }
+
+    bool fail(const char *fmt, ...)
+    {
+        char msg[256];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(msg, sizeof(msg), fmt, args);
+        va_end(args);
+        error_ = msg;
+        return false;
+    }
+
+    // true if cnt items of itemSize bytes at offset are in the file and
+    // aligned to align bytes
+    bool fits(const PWP_UINT64 offset, const PWP_UINT64 cnt,
+        const PWP_UINT64 itemSize, const PWP_UINT64 align) const
+    {
+        return 0 == offset % align && offset <= size_ &&
+            cnt <= (size_ - offset) / itemSize;
+    }
+
+    bool load(const char *filename)
+    {
+#if !defined(WINDOWS)
+        const int fd = ::open(filename, O_RDONLY);
+        if (fd < 0) {
+            return fail("cannot open %s", filename);
+        }
+        struct stat st;
+        if (0 != fstat(fd, &st) || st.st_size < PWP_INT64(sizeof(Header))) {
+            ::close(fd);
+            return fail("%s is not a mesh file", filename);
+        }
+        void *p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE,
+            fd, 0);
+        ::close(fd);
+        if (MAP_FAILED == p) {
+            return fail("cannot map %s", filename);
+        }
+        base_ = static_cast<const char*>(p);
+        size_ = PWP_UINT64(st.st_size);
+        mapped_ = true;
+#else
+        // Read the whole file. The vector's storage is aligned for doubles.
+        FILE *fp = fopen(filename, "rb");
+        if (nullptr == fp) {
+            return fail("cannot open %s", filename);
+        }
+        char chunk[65536];
+        size_t n;
+        while (0 < (n = fread(chunk, 1, sizeof(chunk), fp))) {
+            buf_.insert(buf_.end(), chunk, chunk + n);
+        }
+        const bool ok = !ferror(fp);
+        fclose(fp);
+        if (!ok || buf_.size() < sizeof(Header)) {
+            return fail("%s is not a mesh file", filename);
+        }
+        base_ = buf_.data();
+        size_ = PWP_UINT64(buf_.size());
+#endif
+        return true;
+    }
+
+    bool validate()
+    {
+        const Header &h = header();
+        if (0 != memcmp(h.magic, magic(), sizeof(h.magic))) {
+            return fail("not a mesh file");
+        }
+        if (1 != h.version) {
+            return fail("unsupported mesh file version %u", h.version);
+        }
+        if (2 != h.dimension && 3 != h.dimension) {
+            return fail("bad dimension %u", h.dimension);
+        }
+        if (h.fileSize != size_) {
+            return fail("file is %llu bytes, expected %llu",
+                (unsigned long long)size_, (unsigned long long)h.fileSize);
+        }
+        if (h.vertexCount >= PWP_BADID ||
+                !fits(h.vertexOffset, 3 * h.vertexCount, sizeof(double), 8)) {
+            return fail("bad vertex array");
+        }
+        const PWP_UINT64 nEnt = PWP_UINT64(h.blockCount) + h.domainCount;
+        if (!fits(h.entityOffset, nEnt, sizeof(Entity), 8)) {
+            return fail("bad entity table");
+        }
+        if (0 == h.stringSize || !fits(h.stringOffset, h.stringSize, 1, 8) ||
+                '\0' != *at<char>(h.stringOffset + h.stringSize - 1)) {
+            return fail("bad string table");
+        }
+        for (PWP_UINT32 i = 0; i < nEnt; ++i) {
+            const bool isBlock = (i < h.blockCount);
+            const PWP_UINT32 ndx = (isBlock ? i : i - h.blockCount);
+            if (!validateEntity(at<Entity>(h.entityOffset)[i], isBlock)) {
+                const std::string why = error_;
+                return fail("%s %u: %s", (isBlock ? "block" : "domain"), ndx,
+                    why.c_str());
+            }
+        }
+        return true;
+    }
+
+    bool validateEntity(const Entity &ent, const bool isBlock)
+    {
+        const Header &h = header();
+        if (ent.name >= h.stringSize || ent.type >= h.stringSize) {
+            return fail("bad condition string");
+        }
+        if (ent.elemCount >= PWP_BADID ||
+                !fits(ent.typesOffset, ent.elemCount, 1, 8) ||
+                !fits(ent.startOffset, ent.elemCount + 1, 8, 8)) {
+            return fail("bad element arrays");
+        }
+        const PWP_UINT8 *types = at<PWP_UINT8>(ent.typesOffset);
+        const PWP_UINT64 *start = at<PWP_UINT64>(ent.startOffset);
+        if (0 != start[0] ||
+                !fits(ent.vertsOffset, start[ent.elemCount], 4, 8)) {
+            return fail("bad element vertex array");
+        }
+        const PWP_UINT32 *verts = at<PWP_UINT32>(ent.vertsOffset);
+        // The element types allowed in the entity are lo..hi
+        PWP_UINT32 lo = Tri;
+        PWP_UINT32 hi = Quad;
+        if (isBlock && 3 == h.dimension) {
+            lo = Tet;
+            hi = Hex;
+        }
+        else if (!isBlock && 2 == h.dimension) {
+            lo = hi = Bar;
+        }
+        for (PWP_UINT64 e = 0; e < ent.elemCount; ++e) {
+            const PWP_UINT32 type = types[e];
+            if (type < lo || type > hi) {
+                return fail("element %llu has type %u", (unsigned long long)e,
+                    type);
+            }
+            if (start[e + 1] < start[e] ||
+                    start[e + 1] - start[e] != typeVertexCount(type)) {
+                return fail("element %llu has a bad start",
+                    (unsigned long long)e);
+            }
+            for (PWP_UINT64 v = start[e]; v < start[e + 1]; ++v) {
+                if (verts[v] >= h.vertexCount) {
+                    return fail("element %llu has a bad vertex",
+                        (unsigned long long)e);
+                }
+            }
+        }
+        return true;
+    }
+
+    FluentMeshFile(const FluentMeshFile&) = delete;
+    FluentMeshFile& operator=(const FluentMeshFile&) = delete;
+
+private:
+    const char         *base_;
+    PWP_UINT64          size_;
+    bool                mapped_;
+    std::vector<char>   buf_;       // the file if it is not mapped
+    std::string         error_;
+};
+
+
+// Collects a mesh and writes it as a FluentMeshFile
+class FluentMeshWriter {
+public:
+    explicit FluentMeshWriter(const PWP_UINT32 dimension) :
+        dimension_(dimension)
+    {
+    }
+
+    void addVertex(const double x, const double y, const double z)
+    {
+        xyz_.push_back(x);
+        xyz_.push_back(y);
+        xyz_.push_back(z);
+    }
+
+    // Returns the index of the new block
+    PWP_UINT32 addBlock(const char *name, const PWP_UINT32 id,
+        const char *type, const PWP_UINT32 typeId)
+    {
+        blocks_.push_back(Entity(name, id, type, typeId));
+        return PWP_UINT32(blocks_.size() - 1);
+    }
+
+    // Returns the index of the new domain
+    PWP_UINT32 addDomain(const char *name, const PWP_UINT32 id,
+        const char *type, const PWP_UINT32 typeId)
+    {
+        domains_.push_back(Entity(name, id, type, typeId));
+        return PWP_UINT32(domains_.size() - 1);
+    }
+
+    // Adds a cell with FluentMeshFile::typeVertexCount(type) vertices
+    void addBlockElement(const PWP_UINT32 block, const PWP_UINT32 type,
+        const PWP_UINT32 *verts)
+    {
+        blocks_[block].add(type, verts);
+    }
+
+    void addDomainElement(const PWP_UINT32 domain, const PWP_UINT32 type,
+        const PWP_UINT32 *verts)
+    {
+        domains_[domain].add(type, verts);
+    }
+
+    bool write(const char *filename) const
+    {
+        // Lay out the file
+        std::vector<const Entity*> ents;
+        for (size_t i = 0; i < blocks_.size(); ++i) {
+            ents.push_back(&blocks_[i]);
+        }
+        for (size_t i = 0; i < domains_.size(); ++i) {
+            ents.push_back(&domains_[i]);
+        }
+        std::string strings(1, '\0');
+        std::vector<FluentMeshFile::Entity> table(ents.size());
+        FluentMeshFile::Header h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, FluentMeshFile::magic(), sizeof(h.magic));
+        h.version = 1;
+        h.dimension = dimension_;
+        h.vertexCount = xyz_.size() / 3;
+        h.blockCount = PWP_UINT32(blocks_.size());
+        h.domainCount = PWP_UINT32(domains_.size());
+        h.vertexOffset = sizeof(h);
+        h.entityOffset = h.vertexOffset + xyz_.size() * sizeof(double);
+        PWP_UINT64 pos = h.entityOffset + table.size() * sizeof(table[0]);
+        for (size_t i = 0; i < ents.size(); ++i) {
+            const Entity &ent = *ents[i];
+            FluentMeshFile::Entity &rec = table[i];
+            rec.name = addString(strings, ent.name);
+            rec.id = ent.id;
+            rec.type = addString(strings, ent.type);
+            rec.typeId = ent.typeId;
+            rec.elemCount = ent.types.size();
+            rec.startOffset = pos;
+            pos += ent.start.size() * sizeof(PWP_UINT64);
+            rec.vertsOffset = pos;
+            pos = pad8(pos + ent.verts.size() * sizeof(PWP_UINT32));
+            rec.typesOffset = pos;
+            pos = pad8(pos + ent.types.size());
+        }
+        h.stringOffset = pos;
+        h.stringSize = strings.size();
+        h.fileSize = pad8(pos + strings.size());
+
+        // Write it in that order
+        FILE *fp = fopen(filename, "wb");
+        if (nullptr == fp) {
+            return false;
+        }
+        PWP_UINT64 at = 0;
+        bool ok = put(fp, at, &h, sizeof(h)) &&
+            put(fp, at, xyz_.data(), xyz_.size() * sizeof(double)) &&
+            put(fp, at, table.data(), table.size() * sizeof(table[0]));
+        for (size_t i = 0; ok && i < ents.size(); ++i) {
+            const Entity &ent = *ents[i];
+            ok = put(fp, at, ent.start.data(),
+                    ent.start.size() * sizeof(PWP_UINT64)) &&
+                put(fp, at, ent.verts.data(),
+                    ent.verts.size() * sizeof(PWP_UINT32)) &&
+                padTo(fp, at, table[i].typesOffset) &&
+                put(fp, at, ent.types.data(), ent.types.size()) &&
+                padTo(fp, at, pad8(at));
+        }
+        ok = ok && put(fp, at, strings.data(), strings.size()) &&
+            padTo(fp, at, h.fileSize);
+        ok = ok && !ferror(fp);
+        return (0 == fclose(fp)) && ok;
+    }
+
+private:
+    struct Entity {
+        Entity(const char *nm, const PWP_UINT32 cid, const char *tp,
+                const PWP_UINT32 tid) :
+            name(nm),
+            id(cid),
+            type(tp),
+            typeId(tid),
+            start(1, 0)
+        {
+        }
+
+        void add(const PWP_UINT32 type, const PWP_UINT32 *v)
+        {
+            const PWP_UINT32 n = FluentMeshFile::typeVertexCount(type);
+            types.push_back(PWP_UINT8(type));
+            verts.insert(verts.end(), v, v + n);
+            start.push_back(verts.size());
+        }
+
+        std::string             name;
+        PWP_UINT32              id;
+        std::string             type;
+        PWP_UINT32              typeId;
+        std::vector<PWP_UINT8>  types;
+        std::vector<PWP_UINT64> start;
+        std::vector<PWP_UINT32> verts;
+    };
+
+    static PWP_UINT64 pad8(const PWP_UINT64 pos)
+    {
+        return (pos + 7) & ~PWP_UINT64(7);
+    }
+
+    static PWP_UINT32 addString(std::string &strings, const std::string &s)
+    {
+        const PWP_UINT32 ret = PWP_UINT32(strings.size());
+        strings.append(s.c_str(), s.size() + 1);
+        return ret;
+    }
+
+    static bool put(FILE *fp, PWP_UINT64 &at, const void *buf, size_t len)
+    {
+        at += len;
+        return 0 == len || len == fwrite(buf, 1, len, fp);
+    }
+
+    static bool padTo(FILE *fp, PWP_UINT64 &at, const PWP_UINT64 pos)
+    {
+        static const char zeros[8] = { 0 };
+        return put(fp, at, zeros, size_t(pos - at));
+    }
+
+private:
+    PWP_UINT32              dimension_;
+    std::vector<double>     xyz_;
+    std::vector<Entity>     blocks_;
+    std::vector<Entity>     domains_;
+};
+
+#endif /* _FLUENTMESHFILE_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,153 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export node writer
+ *
+ * FluentNodeWriter writes the node section on a worker thread while the
+ * faces are streamed. The section goes to its own sink, typically a
+ * FluentPwriteSink over a range of the case file that the export reserved
+ * for it. wait() hands the result back to the export thread.
+ *
+ * The producer typically reads the vertices through the grid model API while
+ * the export thread streams the faces, so the export uses it only on request
+ * (PipelineNodes), with a host whose grid model API is thread safe.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTNODEWRITER_H_
+#define _FLUENTNODEWRITER_H_
+
+#include "fluentSink.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+
+class FluentNodeWriter {
+public:
+    // Writes the section to out. Returns false if it failed or stopped early
+    // because cancelled became true.
+    typedef std::function<bool(FluentSink &out,
+        const std::atomic<bool> &cancelled)> Producer;
+
+    // Returns true if the export was aborted
+    typedef std::function<bool()> AbortPoll;
+
+    FluentNodeWriter() :
+        cancelled_(false),
+        done_(false),
+        ok_(false)
+    {
+    }
+
+    ~FluentNodeWriter()
+    {
+        stop();
+    }
+
+    // Starts writing the section to out, which the writer then owns
+    void start(FluentSink *out, Producer produce)
+    {
+        stop();
+        out_.reset(out);
+        produce_ = produce;
+        cancelled_ = false;
+        done_ = false;
+        ok_ = false;
+        worker_ = std::thread([this]() { run(); });
+    }
+
+    bool started() const
+    {
+        return worker_.joinable();
+    }
+
+    // Waits for the section, calling aborted() about every pollMs ms. The
+    // section is cancelled once aborted() returns true. Returns true if the
+    // section was written in full.
+    bool wait(const AbortPoll &aborted, const unsigned pollMs = 100)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!done_) {
+            if (!ready_.wait_for(lock, std::chrono::milliseconds(pollMs),
+                    [this]() { return done_; })) {
+                lock.unlock();
+                if (aborted()) {
+                    cancelled_ = true;
+                }
+                lock.lock();
+            }
+        }
+        lock.unlock();
+        stop();
+        return ok_;
+    }
+
+    // Cancels the section if it is not written yet and waits for the worker
+    void stop()
+    {
+        cancelled_ = true;
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        out_.reset();
+    }
+
+private:
+    void run()
+    {
+        bool ok = false;
+        try {
+            ok = produce_(*out_, cancelled_);
+        }
+        catch (const std::bad_alloc &) {
+            ok = false;
+        }
+        ok = out_->flush() && ok;
+        std::lock_guard<std::mutex> lock(mutex_);
+        ok_ = ok;
+        done_ = true;
+        ready_.notify_all();
+    }
+
+    FluentNodeWriter(const FluentNodeWriter&) = delete;
+    FluentNodeWriter& operator=(const FluentNodeWriter&) = delete;
+
+private:
+    std::unique_ptr<FluentSink> out_;
+    Producer                    produce_;
+    std::atomic<bool>           cancelled_;
+    std::mutex                  mutex_;
+    std::condition_variable     ready_;
+    bool                        done_;
+    bool                        ok_;
+    std::thread                 worker_;
+};
+
+#endif /* _FLUENTNODEWRITER_H_ */
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
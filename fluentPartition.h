@@ -0,0 +1,622 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT cell partitioning
+ *
+ * FluentCellGraph collects the cell adjacency from the streamed faces.
+ * FluentPartitioner splits a weighted graph into k parts by recursive
+ * multilevel bisection: heavy-edge matching coarsens the graph, a greedy
+ * graph-growing bisection splits the coarsest graph, and a boundary
+ * refinement pass improves the cut at each level on the way back up.
+ * Independent sub-problems run on separate threads.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTPARTITION_H_
+#define _FLUENTPARTITION_H_
+
+#include "apiPWP.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+class FluentPartitioner {
+public:
+    // Weighted graph in compressed row format
+    struct Graph {
+        std::vector<PWP_UINT32> xadj;   // size() + 1 offsets into adj
+        std::vector<PWP_UINT32> adj;    // neighbor vertices
+        std::vector<PWP_UINT32> ewgt;   // edge weights, parallel to adj
+        std::vector<PWP_UINT32> vwgt;   // vertex weights
+
+        PWP_UINT32 size() const
+        {
+            return xadj.empty() ? 0 : PWP_UINT32(xadj.size() - 1);
+        }
+
+        PWP_UINT64 weight() const
+        {
+            PWP_UINT64 ret = 0;
+            for (size_t i = 0; i < vwgt.size(); ++i) {
+                ret += vwgt[i];
+            }
+            return ret;
+        }
+
+        void clear()
+        {
+            Graph().swap(*this);
+        }
+
+        void swap(Graph &other)
+        {
+            xadj.swap(other.xadj);
+            adj.swap(other.adj);
+            ewgt.swap(other.ewgt);
+            vwgt.swap(other.vwgt);
+        }
+    };
+
+    // imbalance is the allowed relative overweight of a part, e.g. 0.05.
+    // threads is the maximum number of threads to use.
+    FluentPartitioner(PWP_REAL imbalance, PWP_UINT32 threads) :
+        imbalance_(std::max(imbalance, 0.001)),
+        spareThreads_(int(std::max(threads, 1u)) - 1),
+        cut_(0),
+        cancelled_(false)
+    {
+    }
+
+    // Makes a running partition() return early, from any thread. The parts
+    // are then incomplete. Checked every CancelStride vertices of a
+    // coarsening level or refinement pass, after each bisection and once per
+    // initial bisection step.
+    void cancel()
+    {
+        cancelled_ = true;
+    }
+
+    // Sets part[v] to the part, 0..nParts-1, of each vertex v of g. The graph
+    // is consumed. Returns the total weight of the cut edges.
+    PWP_UINT64 partition(Graph &g, PWP_UINT32 nParts,
+        std::vector<PWP_UINT32> &part)
+    {
+        const PWP_UINT32 n = g.size();
+        part.assign(n, 0);
+        std::vector<PWP_UINT32> ids(n);
+        for (PWP_UINT32 v = 0; v < n; ++v) {
+            ids[v] = v;
+        }
+        cut_ = 0;
+        recurse(g, ids, std::max(nParts, 1u), 0, part, 1);
+        return cut_;
+    }
+
+private:
+    typedef std::vector<PWP_UINT8> Sides;
+
+    // Stop coarsening at this many vertices
+    enum { CoarsestSize = 128 };
+
+    // Number of graph-growing attempts for the initial bisection
+    enum { InitialTries = 4 };
+
+    // Maximum number of refinement passes per level
+    enum { RefinePasses = 8 };
+
+    // Side of a vertex the initial bisection could not add to side 0
+    enum { Rejected = 2 };
+
+    // Vertices coarsened between two checks of cancel()
+    enum { CancelStride = 65536 };
+
+    static PWP_UINT32 nextRand(PWP_UINT32 &state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    bool acquireThread()
+    {
+        if (spareThreads_.fetch_sub(1) > 0) {
+            return true;
+        }
+        ++spareThreads_;
+        return false;
+    }
+
+    void releaseThread()
+    {
+        ++spareThreads_;
+    }
+
+    void recurse(Graph &g, std::vector<PWP_UINT32> &ids, PWP_UINT32 nParts,
+        PWP_UINT32 firstPart, std::vector<PWP_UINT32> &part, PWP_UINT32 seed)
+    {
+        if (cancelled_) {
+            return;
+        }
+        if (nParts <= 1 || g.size() <= 1) {
+            for (size_t i = 0; i < ids.size(); ++i) {
+                part[ids[i]] = firstPart;
+            }
+            return;
+        }
+        const PWP_UINT32 parts0 = nParts / 2;
+        Sides side;
+        bisect(g, double(parts0) / double(nParts), side, seed);
+        if (cancelled_) {
+            return;
+        }
+        // Every cut edge is cut by exactly one bisection
+        cut_ += cutWeight(g, side);
+
+        Graph g0;
+        Graph g1;
+        std::vector<PWP_UINT32> ids0;
+        std::vector<PWP_UINT32> ids1;
+        extract(g, side, ids, 0, g0, ids0);
+        extract(g, side, ids, 1, g1, ids1);
+        g.clear();
+        std::vector<PWP_UINT32>().swap(ids);
+        Sides().swap(side);
+
+        // Each half is independent. Split the work if a thread is free.
+        std::thread worker;
+        if (acquireThread()) {
+            worker = std::thread([&]() {
+                recurse(g0, ids0, parts0, firstPart, part, 2 * seed);
+                releaseThread();
+            });
+        }
+        else {
+            recurse(g0, ids0, parts0, firstPart, part, 2 * seed);
+        }
+        recurse(g1, ids1, nParts - parts0, firstPart + parts0, part,
+            2 * seed + 1);
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    // Splits g into side 0 holding about frac0 of the weight and side 1.
+    void bisect(const Graph &g, double frac0, Sides &side, PWP_UINT32 seed)
+    {
+        const PWP_UINT64 total = g.weight();
+        const PWP_UINT64 target0 = PWP_UINT64(double(total) * frac0);
+        const PWP_UINT64 maxW[2] = {
+            PWP_UINT64(double(target0) * (1.0 + imbalance_)) + 1,
+            PWP_UINT64(double(total - target0) * (1.0 + imbalance_)) + 1
+        };
+        const PWP_UINT32 maxVwgt =
+            PWP_UINT32(std::min<PWP_UINT64>(0xFFFFFFFFu,
+                std::max<PWP_UINT64>(1, 3 * total / (2 * CoarsestSize))));
+
+        // Coarsen until the graph is small or stops shrinking
+        std::deque<Graph> levels;
+        std::deque<std::vector<PWP_UINT32> > cmaps;
+        const Graph *cur = &g;
+        while (cur->size() > CoarsestSize && !cancelled_) {
+            Graph cg;
+            std::vector<PWP_UINT32> cmap;
+            coarsen(*cur, cg, cmap, seed + PWP_UINT32(levels.size()), maxVwgt);
+            if (cancelled_ || cg.size() > cur->size() - cur->size() / 20) {
+                break;
+            }
+            levels.push_back(Graph());
+            levels.back().swap(cg);
+            cmaps.push_back(std::vector<PWP_UINT32>());
+            cmaps.back().swap(cmap);
+            cur = &levels.back();
+        }
+
+        initialBisect(*cur, target0, maxW, side, seed);
+
+        // Project back to the original graph, refining each level
+        for (size_t i = levels.size(); i > 0; --i) {
+            const Graph &fine = (1 == i) ? g : levels[i - 2];
+            const std::vector<PWP_UINT32> &cmap = cmaps[i - 1];
+            Sides fside(fine.size());
+            for (PWP_UINT32 v = 0; v < fine.size(); ++v) {
+                fside[v] = side[cmap[v]];
+            }
+            side.swap(fside);
+            levels.pop_back();
+            cmaps.pop_back();
+            if (!cancelled_) {
+                refine(fine, maxW, side);
+            }
+        }
+    }
+
+    // Heavy-edge matching. cmap maps each vertex of g to its vertex in cg.
+    // cg is incomplete after a cancel().
+    void coarsen(const Graph &g, Graph &cg, std::vector<PWP_UINT32> &cmap,
+        PWP_UINT32 seed, PWP_UINT32 maxVwgt)
+    {
+        const PWP_UINT32 n = g.size();
+        std::vector<PWP_UINT32> order(n);
+        for (PWP_UINT32 v = 0; v < n; ++v) {
+            order[v] = v;
+        }
+        PWP_UINT32 rng = seed;
+        for (PWP_UINT32 v = n; v > 1; --v) {
+            std::swap(order[v - 1], order[nextRand(rng) % v]);
+        }
+
+        std::vector<PWP_UINT32> match(n, PWP_BADID);
+        for (PWP_UINT32 k = 0; k < n; ++k) {
+            if (0 == k % CancelStride && cancelled_) {
+                return;
+            }
+            const PWP_UINT32 v = order[k];
+            if (PWP_BADID != match[v]) {
+                continue;
+            }
+            PWP_UINT32 best = v;
+            PWP_UINT32 bestW = 0;
+            for (PWP_UINT32 e = g.xadj[v]; e < g.xadj[v + 1]; ++e) {
+                const PWP_UINT32 u = g.adj[e];
+                if (PWP_BADID == match[u] && u != v && g.ewgt[e] > bestW &&
+                        g.vwgt[v] + g.vwgt[u] <= maxVwgt) {
+                    best = u;
+                    bestW = g.ewgt[e];
+                }
+            }
+            match[v] = best;
+            match[best] = v;
+        }
+
+        cmap.assign(n, PWP_BADID);
+        PWP_UINT32 cn = 0;
+        for (PWP_UINT32 v = 0; v < n; ++v) {
+            if (PWP_BADID == cmap[v]) {
+                cmap[v] = cn;
+                cmap[match[v]] = cn;
+                ++cn;
+            }
+        }
+
+        cg.clear();
+        cg.xadj.reserve(cn + 1);
+        cg.xadj.push_back(0);
+        cg.vwgt.reserve(cn);
+        cg.adj.reserve(g.adj.size() / 2);
+        cg.ewgt.reserve(g.adj.size() / 2);
+        // where[c] is the position of coarse neighbor c in the current list
+        std::vector<size_t> where(cn, size_t(-1));
+        for (PWP_UINT32 v = 0; v < n; ++v) {
+            if (0 == v % CancelStride && cancelled_) {
+                return;
+            }
+            const PWP_UINT32 u = match[v];
+            if (u < v) {
+                continue;   // added with u
+            }
+            const PWP_UINT32 c = cmap[v];
+            const size_t start = cg.adj.size();
+            const PWP_UINT32 fine[2] = { v, u };
+            for (int f = 0; f < ((u == v) ? 1 : 2); ++f) {
+                const PWP_UINT32 fv = fine[f];
+                for (PWP_UINT32 e = g.xadj[fv]; e < g.xadj[fv + 1]; ++e) {
+                    const PWP_UINT32 cu = cmap[g.adj[e]];
+                    if (cu == c) {
+                        continue;
+                    }
+                    if (size_t(-1) != where[cu] && where[cu] >= start) {
+                        cg.ewgt[where[cu]] += g.ewgt[e];
+                    }
+                    else {
+                        where[cu] = cg.adj.size();
+                        cg.adj.push_back(cu);
+                        cg.ewgt.push_back(g.ewgt[e]);
+                    }
+                }
+            }
+            cg.xadj.push_back(PWP_UINT32(cg.adj.size()));
+            cg.vwgt.push_back(g.vwgt[v] + ((u == v) ? 0 : g.vwgt[u]));
+        }
+    }
+
+    // Greedy graph growing from a few random seeds. Keeps the best cut.
+    void initialBisect(const Graph &g, PWP_UINT64 target0,
+        const PWP_UINT64 maxW[2], Sides &side, PWP_UINT32 seed)
+    {
+        const PWP_UINT32 n = g.size();
+        PWP_UINT32 rng = seed ^ 0x9E3779B9u;
+        PWP_UINT64 bestCut = ~PWP_UINT64(0);
+        bool bestBalanced = false;
+        side.assign(n, 1);
+        for (int t = 0; t < InitialTries && 0 != n; ++t) {
+            Sides s(n, 1);
+            std::vector<PWP_INT64> gain(n);
+            for (PWP_UINT32 v = 0; v < n; ++v) {
+                gain[v] = 0;
+                for (PWP_UINT32 e = g.xadj[v]; e < g.xadj[v + 1]; ++e) {
+                    gain[v] -= g.ewgt[e];
+                }
+            }
+            typedef std::pair<PWP_INT64, PWP_UINT32> Item;
+            std::priority_queue<Item> pq;
+            const PWP_UINT32 start = nextRand(rng) % n;
+            pq.push(Item(gain[start], start));
+            PWP_UINT32 scan = 0;
+            PWP_UINT64 w0 = 0;
+            // A vertex too heavy for side 0 is marked Rejected. It stays too
+            // heavy as w0 grows, so the pass ends once none is left to try.
+            while (w0 < target0 && !cancelled_) {
+                if (pq.empty()) {
+                    // region is disconnected from the rest; jump
+                    while (scan < n && 1 != s[scan]) {
+                        ++scan;
+                    }
+                    if (scan == n) {
+                        break;
+                    }
+                    pq.push(Item(gain[scan], scan));
+                }
+                const Item top = pq.top();
+                pq.pop();
+                const PWP_UINT32 v = top.second;
+                if (1 != s[v] || top.first != gain[v]) {
+                    continue;
+                }
+                if (0 != w0 && w0 + g.vwgt[v] > maxW[0]) {
+                    s[v] = Rejected;
+                    continue;
+                }
+                s[v] = 0;
+                w0 += g.vwgt[v];
+                for (PWP_UINT32 e = g.xadj[v]; e < g.xadj[v + 1]; ++e) {
+                    const PWP_UINT32 u = g.adj[e];
+                    gain[u] += 2 * PWP_INT64(g.ewgt[e]);
+                    if (1 == s[u]) {
+                        pq.push(Item(gain[u], u));
+                    }
+                }
+            }
+            std::replace(s.begin(), s.end(), PWP_UINT8(Rejected),
+                PWP_UINT8(1));
+            refine(g, maxW, s);
+
+            PWP_UINT64 w[2] = { 0, 0 };
+            PWP_UINT64 cut = 0;
+            for (PWP_UINT32 v = 0; v < n; ++v) {
+                w[s[v]] += g.vwgt[v];
+                for (PWP_UINT32 e = g.xadj[v]; e < g.xadj[v + 1]; ++e) {
+                    if (s[v] != s[g.adj[e]]) {
+                        cut += g.ewgt[e];
+                    }
+                }
+            }
+            const bool balanced = w[0] <= maxW[0] && w[1] <= maxW[1];
+            if ((balanced && !bestBalanced) ||
+                    (balanced == bestBalanced && cut < bestCut)) {
+                bestCut = cut;
+                bestBalanced = balanced;
+                side.swap(s);
+            }
+        }
+    }
+
+    // Greedy boundary refinement. Moves vertices that reduce the cut, and
+    // any vertex of an overweight side, best gain first.
+    void refine(const Graph &g, const PWP_UINT64 maxW[2], Sides &side)
+    {
+        const PWP_UINT32 n = g.size();
+        PWP_UINT64 w[2] = { 0, 0 };
+        for (PWP_UINT32 v = 0; v < n; ++v) {
+            w[side[v]] += g.vwgt[v];
+        }
+        typedef std::pair<PWP_INT64, PWP_UINT32> Item;
+        std::vector<Item> cand;
+        for (int pass = 0; pass < RefinePasses && !cancelled_; ++pass) {
+            const bool over[2] = { w[0] > maxW[0], w[1] > maxW[1] };
+            cand.clear();
+            for (PWP_UINT32 v = 0; v < n; ++v) {
+                if (0 == v % CancelStride && cancelled_) {
+                    return;
+                }
+                const PWP_INT64 gv = gain(g, side, v);
+                if ((gv > 0 && !over[1 - side[v]]) || over[side[v]]) {
+                    cand.push_back(Item(-gv, v));
+                }
+            }
+            if (cand.empty()) {
+                break;
+            }
+            std::sort(cand.begin(), cand.end());
+            PWP_UINT32 moved = 0;
+            for (size_t i = 0; i < cand.size(); ++i) {
+                if (0 == i % CancelStride && cancelled_) {
+                    return;
+                }
+                const PWP_UINT32 v = cand[i].second;
+                const PWP_UINT8 from = side[v];
+                const PWP_UINT8 to = PWP_UINT8(1 - from);
+                if (w[to] + g.vwgt[v] > maxW[to]) {
+                    continue;
+                }
+                // neighbors may have moved since the gain was computed
+                const PWP_INT64 gv = gain(g, side, v);
+                if (gv > 0 || w[from] > maxW[from]) {
+                    side[v] = to;
+                    w[from] -= g.vwgt[v];
+                    w[to] += g.vwgt[v];
+                    ++moved;
+                }
+            }
+            if (0 == moved) {
+                break;
+            }
+        }
+    }
+
+    static PWP_UINT64 cutWeight(const Graph &g, const Sides &side)
+    {
+        PWP_UINT64 cut = 0;
+        for (PWP_UINT32 v = 0; v < g.size(); ++v) {
+            for (PWP_UINT32 e = g.xadj[v]; e < g.xadj[v + 1]; ++e) {
+                if (side[v] != side[g.adj[e]]) {
+                    cut += g.ewgt[e];
+                }
+            }
+        }
+        return cut / 2;
+    }
+
+    // Cut reduction if v changes sides
+    static PWP_INT64 gain(const Graph &g, const Sides &side, PWP_UINT32 v)
+    {
+        PWP_INT64 ret = 0;
+        for (PWP_UINT32 e = g.xadj[v]; e < g.xadj[v + 1]; ++e) {
+            ret += (side[g.adj[e]] == side[v]) ? -PWP_INT64(g.ewgt[e]) :
+                PWP_INT64(g.ewgt[e]);
+        }
+        return ret;
+    }
+
+    // Builds the subgraph of the vertices on side which
+    static void extract(const Graph &g, const Sides &side,
+        const std::vector<PWP_UINT32> &ids, PWP_UINT8 which, Graph &sub,
+        std::vector<PWP_UINT32> &subIds)
+    {
+        const PWP_UINT32 n = g.size();
+        std::vector<PWP_UINT32> local(n, PWP_BADID);
+        PWP_UINT32 k = 0;
+        for (PWP_UINT32 v = 0; v < n; ++v) {
+            if (which == side[v]) {
+                local[v] = k++;
+            }
+        }
+        sub.clear();
+        sub.xadj.reserve(k + 1);
+        sub.xadj.push_back(0);
+        sub.vwgt.reserve(k);
+        subIds.clear();
+        subIds.reserve(k);
+        for (PWP_UINT32 v = 0; v < n; ++v) {
+            if (which != side[v]) {
+                continue;
+            }
+            for (PWP_UINT32 e = g.xadj[v]; e < g.xadj[v + 1]; ++e) {
+                const PWP_UINT32 u = g.adj[e];
+                if (which == side[u]) {
+                    sub.adj.push_back(local[u]);
+                    sub.ewgt.push_back(g.ewgt[e]);
+                }
+            }
+            sub.xadj.push_back(PWP_UINT32(sub.adj.size()));
+            sub.vwgt.push_back(g.vwgt[v]);
+            subIds.push_back(ids[v]);
+        }
+    }
+
+private:
+    PWP_REAL                imbalance_;
+    std::atomic<int>        spareThreads_;
+    std::atomic<PWP_UINT64> cut_;
+    std::atomic<bool>       cancelled_;
+};
+
+
+// Collects the cell adjacency graph from the streamed faces
+class FluentCellGraph {
+public:
+    FluentCellGraph() :
+        nCells_(0)
+    {
+    }
+
+    void init(PWP_UINT32 nCells)
+    {
+        nCells_ = nCells;
+        faceCnt_.assign(nCells, 0);
+        edges_.clear();
+    }
+
+    PWP_UINT32 cellCount() const
+    {
+        return nCells_;
+    }
+
+    // Adds a face between cells c0 and c1. c1 is PWP_BADID for boundary
+    // faces. Cell indices are 0 based.
+    void addFace(PWP_UINT32 c0, PWP_UINT32 c1)
+    {
+        if (c0 < nCells_ && faceCnt_[c0] < 255) {
+            ++faceCnt_[c0];
+        }
+        if (c1 < nCells_) {
+            if (faceCnt_[c1] < 255) {
+                ++faceCnt_[c1];
+            }
+            if (c0 < nCells_) {
+                edges_.push_back(std::make_pair(c0, c1));
+            }
+        }
+    }
+
+    // Moves the collected adjacency into g. The cell weights are 100 for
+    // tets (2D cells) and 100 * prismWeight for wedges, pyramids and hexes,
+    // which are told apart by their face counts.
+    void buildGraph(FluentPartitioner::Graph &g, bool is3D,
+        PWP_REAL prismWeight)
+    {
+        const PWP_UINT32 heavy = PWP_UINT32(std::max(1.0,
+            100.0 * prismWeight + 0.5));
+        g.clear();
+        g.xadj.assign(size_t(nCells_) + 1, 0);
+        for (size_t i = 0; i < edges_.size(); ++i) {
+            ++g.xadj[edges_[i].first + 1];
+            ++g.xadj[edges_[i].second + 1];
+        }
+        for (PWP_UINT32 v = 0; v < nCells_; ++v) {
+            g.xadj[v + 1] += g.xadj[v];
+        }
+        g.adj.resize(g.xadj[nCells_]);
+        g.ewgt.assign(g.xadj[nCells_], 1);
+        std::vector<PWP_UINT32> fill(g.xadj.begin(), g.xadj.end() - 1);
+        for (size_t i = 0; i < edges_.size(); ++i) {
+            g.adj[fill[edges_[i].first]++] = edges_[i].second;
+            g.adj[fill[edges_[i].second]++] = edges_[i].first;
+        }
+        std::vector<std::pair<PWP_UINT32, PWP_UINT32> >().swap(edges_);
+        g.vwgt.resize(nCells_);
+        for (PWP_UINT32 v = 0; v < nCells_; ++v) {
+            g.vwgt[v] = (is3D && faceCnt_[v] > 4) ? heavy : 100;
+        }
+    }
+
+private:
+    PWP_UINT32                                      nCells_;
+    std::vector<PWP_UINT8>                          faceCnt_;
+    std::vector<std::pair<PWP_UINT32, PWP_UINT32> > edges_;
+};
+
+#endif /* _FLUENTPARTITION_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,384 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export hardware performance counters
+ *
+ * FluentPerf counts cycles, instructions, last level cache misses, branch
+ * mispredictions and page faults per export phase with perf_event_open()
+ * (Linux). Phases nest. Counts are exclusive, so a phase started inside
+ * another one is not also charged to the outer phase. Only the export thread
+ * is counted.
+ *
+ * Counters the kernel refuses (containers, VMs, perf_event_paranoid) are
+ * reported as unavailable. The wall time of every phase is always reported.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTPERF_H_
+#define _FLUENTPERF_H_
+
+#include "apiPWP.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#   include <errno.h>
+#   include <linux/perf_event.h>
+#   include <string.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+
+class FluentPerf {
+public:
+    enum Phase {
+        Verts,      // writeVerts()
+        Cells,      // writeVCZone() cell lists
+        Faces,      // the face stream, faceCB() calls and the grid model
+        End,        // endCB() shadow sort and write
+        PhaseCount
+    };
+
+    enum Counter {
+        Cycles,
+        Instructions,
+        LlcMisses,
+        BranchMisses,
+        PageFaults,
+        CounterCount
+    };
+
+    FluentPerf() :
+        open_(false)
+    {
+        for (int c = 0; c < CounterCount; ++c) {
+            fd_[c] = -1;
+        }
+        for (int p = 0; p < PhaseCount; ++p) {
+            totals_[p] = Totals();
+        }
+    }
+
+    ~FluentPerf()
+    {
+        close();
+    }
+
+    // Opens the counters. Returns false if none is available. The phase wall
+    // times are measured either way.
+    bool open()
+    {
+        close();
+        open_ = true;
+        bool ret = false;
+#if defined(__linux__)
+        static const struct {
+            PWP_UINT32  type;
+            PWP_UINT64  config;
+        } events[CounterCount] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+        };
+        for (int c = 0; c < CounterCount; ++c) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[c].type;
+            attr.config = events[c].config;
+            // user space only; allowed at perf_event_paranoid 2. Page
+            // faults are software events and count in either case.
+            attr.exclude_kernel = (PERF_TYPE_HARDWARE == attr.type);
+            attr.exclude_hv = 1;
+            fd_[c] = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            if (0 <= fd_[c]) {
+                ret = true;
+            }
+            else if (error_.empty()) {
+                error_ = strerror(errno);
+            }
+        }
+#else
+        error_ = "not supported on this platform";
+#endif
+        return ret;
+    }
+
+    void close()
+    {
+#if defined(__linux__)
+        for (int c = 0; c < CounterCount; ++c) {
+            if (0 <= fd_[c]) {
+                ::close(fd_[c]);
+                fd_[c] = -1;
+            }
+        }
+#endif
+        stack_.clear();
+    }
+
+    bool enabled() const
+    {
+        return open_;
+    }
+
+    // Starts phase. The running phase, if any, is paused until stop().
+    void start(Phase phase)
+    {
+        Sample now;
+        sample(now);
+        if (!stack_.empty()) {
+            charge(stack_.back(), now);
+        }
+        stack_.push_back(phase);
+        last_ = now;
+        ++totals_[phase].calls;
+    }
+
+    // Stops the innermost phase and resumes the one it interrupted
+    void stop()
+    {
+        if (stack_.empty()) {
+            return;
+        }
+        Sample now;
+        sample(now);
+        charge(stack_.back(), now);
+        stack_.pop_back();
+        last_ = now;
+    }
+
+    // Adds to the number of items (vertices, cells or faces) a phase
+    // handled. The report gives the counts per item.
+    void addItems(Phase phase, PWP_UINT64 items)
+    {
+        totals_[phase].items += items;
+    }
+
+    // The counts as lines of text
+    std::vector<std::string> report() const
+    {
+        static const char *names[PhaseCount] = {
+            "writeVerts", "writeVCZone", "faceStream", "endCB"
+        };
+        static const char *units[PhaseCount] = {
+            "vertex", "cell", "face", "face"
+        };
+        std::vector<std::string> ret;
+        char line[256];
+        if (!available()) {
+            snprintf(line, sizeof(line), "Hardware counters unavailable (%s). "
+                "Reporting wall time only.", error_.c_str());
+            ret.push_back(line);
+        }
+        else if (!error_.empty()) {
+            snprintf(line, sizeof(line), "Some counters unavailable (%s). "
+                "They are shown as n/a.", error_.c_str());
+            ret.push_back(line);
+        }
+        for (int p = 0; p < PhaseCount; ++p) {
+            const Totals &t = totals_[p];
+            if (0 == t.calls) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "%-12s %8.3f s  %llu calls  %llu "
+                "items", names[p], double(t.ns) * 1e-9,
+                (unsigned long long)t.calls, (unsigned long long)t.items);
+            ret.push_back(line);
+            if (!available()) {
+                continue;
+            }
+            std::string counts("             ");
+            appendCount(counts, "cycles", Cycles, t);
+            appendCount(counts, "instr", Instructions, t);
+            appendCount(counts, "llc-miss", LlcMisses, t);
+            appendCount(counts, "br-miss", BranchMisses, t);
+            appendCount(counts, "faults", PageFaults, t);
+            ret.push_back(counts);
+            std::string ratios("             ");
+            if (valid(Cycles) && valid(Instructions) && 0 != t.value[Cycles]) {
+                snprintf(line, sizeof(line), " IPC %.2f", double(
+                    t.value[Instructions]) / double(t.value[Cycles]));
+                ratios += line;
+            }
+            if (0 != t.items) {
+                const double n = double(t.items);
+                if (valid(Cycles)) {
+                    snprintf(line, sizeof(line), "  cycles/%s %.1f", units[p],
+                        double(t.value[Cycles]) / n);
+                    ratios += line;
+                }
+                if (valid(LlcMisses)) {
+                    snprintf(line, sizeof(line), "  llc-miss/%s %.3f",
+                        units[p], double(t.value[LlcMisses]) / n);
+                    ratios += line;
+                }
+                if (valid(BranchMisses)) {
+                    snprintf(line, sizeof(line), "  br-miss/%s %.3f",
+                        units[p], double(t.value[BranchMisses]) / n);
+                    ratios += line;
+                }
+            }
+            if (ratios.find_first_not_of(' ') != std::string::npos) {
+                ret.push_back(ratios);
+            }
+        }
+        return ret;
+    }
+
+    // Writes report() to filename
+    bool write(const char *filename) const
+    {
+        FILE *fp = fopen(filename, "w");
+        if (nullptr == fp) {
+            return false;
+        }
+        const std::vector<std::string> lines = report();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            fprintf(fp, "%s\n", lines[i].c_str());
+        }
+        const bool ret = !ferror(fp);
+        return (0 == fclose(fp)) && ret;
+    }
+
+private:
+    struct Sample {
+        std::chrono::steady_clock::time_point   time;
+        PWP_UINT64                              value[CounterCount];
+    };
+
+    struct Totals {
+        Totals() :
+            ns(0),
+            calls(0),
+            items(0)
+        {
+            for (int c = 0; c < CounterCount; ++c) {
+                value[c] = 0;
+            }
+        }
+
+        PWP_UINT64  ns;
+        PWP_UINT64  calls;
+        PWP_UINT64  items;
+        PWP_UINT64  value[CounterCount];
+    };
+
+    bool valid(Counter c) const
+    {
+        return 0 <= fd_[c];
+    }
+
+    bool available() const
+    {
+        for (int c = 0; c < CounterCount; ++c) {
+            if (valid(Counter(c))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void sample(Sample &s) const
+    {
+        s.time = std::chrono::steady_clock::now();
+        for (int c = 0; c < CounterCount; ++c) {
+            s.value[c] = 0;
+#if defined(__linux__)
+            if (0 <= fd_[c] && sizeof(s.value[c]) != ::read(fd_[c],
+                    &s.value[c], sizeof(s.value[c]))) {
+                s.value[c] = 0;
+            }
+#endif
+        }
+    }
+
+    void charge(Phase phase, const Sample &now)
+    {
+        Totals &t = totals_[phase];
+        t.ns += PWP_UINT64(std::chrono::duration_cast<
+            std::chrono::nanoseconds>(now.time - last_.time).count());
+        for (int c = 0; c < CounterCount; ++c) {
+            t.value[c] += now.value[c] - last_.value[c];
+        }
+    }
+
+    void appendCount(std::string &s, const char *name, Counter c,
+        const Totals &t) const
+    {
+        char buf[64];
+        if (valid(c)) {
+            snprintf(buf, sizeof(buf), " %s %llu", name,
+                (unsigned long long)t.value[c]);
+        }
+        else {
+            snprintf(buf, sizeof(buf), " %s n/a", name);
+        }
+        s += buf;
+    }
+
+    FluentPerf(const FluentPerf&) = delete;
+    FluentPerf& operator=(const FluentPerf&) = delete;
+
+private:
+    bool                open_;
+    int                 fd_[CounterCount];
+    std::string         error_;
+    std::vector<Phase>  stack_;
+    Sample              last_;
+    Totals              totals_[PhaseCount];
+};
+
+
+// Scoped phase. Costs a single pointer test when the counters are off.
+class FluentPerfScope {
+public:
+    FluentPerfScope(FluentPerf *perf, FluentPerf::Phase phase) :
+        perf_((perf && perf->enabled()) ? perf : nullptr)
+    {
+        if (perf_) {
+            perf_->start(phase);
+        }
+    }
+
+    ~FluentPerfScope()
+    {
+        if (perf_) {
+            perf_->stop();
+        }
+    }
+
+private:
+    FluentPerfScope(const FluentPerfScope&) = delete;
+    FluentPerfScope& operator=(const FluentPerfScope&) = delete;
+
+private:
+    FluentPerf *perf_;
+};
+
+#endif /* _FLUENTPERF_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,960 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT output sinks
+ *
+ * All case file output goes through a FluentSink. Sinks append bytes and,
+ * when isPatchable(), allow earlier bytes to be overwritten in place. The
+ * face zone headers are finalized that way.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTSINK_H_
+#define _FLUENTSINK_H_
+
+#include "apiPWP.h"
+
+#include <algorithm>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#if !defined(WINDOWS)
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <stdlib.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/types.h>
+#   include <unistd.h>
+#endif
+
+
+class FluentSink {
+public:
+    FluentSink() :
+        pos_(0),
+        failed_(false)
+    {
+    }
+
+    virtual ~FluentSink()
+    {
+    }
+
+    // Append len bytes
+    virtual bool write(const void *buf, size_t len) = 0;
+
+    // Overwrite len bytes starting at offset. The bytes must have been
+    // written before. The write position is not changed.
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len) = 0;
+
+    // true if patch() is supported
+    virtual bool isPatchable() const = 0;
+
+    // Push buffered bytes to the destination
+    virtual bool flush() = 0;
+
+    // Byte offset of the next write
+    PWP_UINT64 tell() const
+    {
+        return pos_;
+    }
+
+    // false once any operation has failed
+    bool ok() const
+    {
+        return !failed_;
+    }
+
+    bool print(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        const bool ret = vprint(format, args);
+        va_end(args);
+        return ret;
+    }
+
+    bool vprint(const char *format, va_list args)
+    {
+        char buf[512];
+        va_list args2;
+        va_copy(args2, args);
+        const int len = vsnprintf(buf, sizeof(buf), format, args2);
+        va_end(args2);
+        bool ret = false;
+        if (len < 0) {
+            failed_ = true;
+        }
+        else if (size_t(len) < sizeof(buf)) {
+            ret = write(buf, size_t(len));
+        }
+        else {
+            std::vector<char> big(size_t(len) + 1);
+            vsnprintf(big.data(), big.size(), format, args);
+            ret = write(big.data(), size_t(len));
+        }
+        return ret;
+    }
+
+protected:
+    bool fail()
+    {
+        failed_ = true;
+        return false;
+    }
+
+protected:
+    PWP_UINT64  pos_;
+    bool        failed_;
+
+private:
+    FluentSink(const FluentSink&) = delete;
+    FluentSink& operator=(const FluentSink&) = delete;
+};
+
+
+// Writes through a stdio FILE. Portable default for the export file. The
+// sink's offsets are those of the file, starting at the stream's position.
+class FluentFileSink : public FluentSink {
+public:
+    explicit FluentFileSink(FILE *fp) :
+        fp_(fp)
+    {
+#if defined(WINDOWS)
+        const __int64 pos = _ftelli64(fp_);
+#else
+        const off_t pos = ftello(fp_);
+#endif
+        if (0 < pos) {
+            pos_ = PWP_UINT64(pos);
+        }
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        if (len != fwrite(buf, 1, len, fp_)) {
+            return fail();
+        }
+        pos_ += len;
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        bool ret = 0 == seek(offset) && len == fwrite(buf, 1, len, fp_);
+        ret = (0 == seek(pos_)) && ret;
+        return ret || fail();
+    }
+
+    virtual bool isPatchable() const
+    {
+        return true;
+    }
+
+    virtual bool flush()
+    {
+        return (0 == fflush(fp_) || fail()) && ok();
+    }
+
+private:
+    int seek(PWP_UINT64 offset)
+    {
+#if defined(WINDOWS)
+        return _fseeki64(fp_, (__int64)offset, SEEK_SET);
+#else
+        return fseeko(fp_, (off_t)offset, SEEK_SET);
+#endif
+    }
+
+private:
+    FILE   *fp_;
+};
+
+
+// Growable in-memory buffer. release() hands the bytes to the caller without
+// copying them. A write that would grow the buffer past its limit fails.
+class FluentMemorySink : public FluentSink {
+public:
+    FluentMemorySink() :
+        limit_(0)
+    {
+    }
+
+    // Maximum size of the buffer in bytes. 0 is unlimited.
+    void setLimit(size_t limit)
+    {
+        limit_ = limit;
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        if (0 != limit_ && buf_.size() + len > limit_) {
+            return fail();
+        }
+        const char *p = static_cast<const char*>(buf);
+        buf_.insert(buf_.end(), p, p + len);
+        pos_ += len;
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        if (offset + len > buf_.size()) {
+            return fail();
+        }
+        memcpy(&buf_[size_t(offset)], buf, len);
+        return true;
+    }
+
+    virtual bool isPatchable() const
+    {
+        return true;
+    }
+
+    virtual bool flush()
+    {
+        return ok();
+    }
+
+    const char * data() const
+    {
+        return buf_.data();
+    }
+
+    size_t size() const
+    {
+        return buf_.size();
+    }
+
+    void clear()
+    {
+        buf_.clear();
+        pos_ = 0;
+    }
+
+    // Moves the bytes out of the sink. The sink is empty afterwards.
+    std::vector<char> release()
+    {
+        std::vector<char> ret;
+        ret.swap(buf_);
+        pos_ = 0;
+        return ret;
+    }
+
+private:
+    std::vector<char>   buf_;
+    size_t              limit_;
+};
+
+
+// Discards the bytes and only counts them. Used by the dry run to size the
+// case file.
+class FluentCountingSink : public FluentSink {
+public:
+    FluentCountingSink()
+    {
+    }
+
+    virtual bool write(const void * /*buf*/, size_t len)
+    {
+        pos_ += len;
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void * /*buf*/, size_t len)
+    {
+        return offset + len <= pos_ || fail();
+    }
+
+    virtual bool isPatchable() const
+    {
+        return true;
+    }
+
+    virtual bool flush()
+    {
+        return ok();
+    }
+
+    // Counts len bytes without formatting them
+    void skip(PWP_UINT64 len)
+    {
+        pos_ += len;
+    }
+};
+
+
+#if !defined(WINDOWS)
+
+// Writes len bytes at offset of fd with pwrite(), retrying short writes
+static inline bool
+fluentPwriteAll(int fd, const char *p, size_t len, PWP_UINT64 offset)
+{
+    while (0 != len) {
+        const ssize_t n = ::pwrite(fd, p, len, (off_t)offset);
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        len -= size_t(n);
+        offset += PWP_UINT64(n);
+    }
+    return true;
+}
+
+
+// Buffered writes to a file descriptor. If seekable, patch() uses pwrite().
+// Otherwise the descriptor is treated as a stream (pipe or socket) that only
+// accepts appends.
+class FluentFdSink : public FluentSink {
+public:
+    enum { DefaultBufferSize = 1024 * 1024 };
+
+    FluentFdSink(int fd, bool seekable, size_t bufSize = DefaultBufferSize) :
+        fd_(fd),
+        seekable_(seekable),
+        buf_(bufSize ? bufSize : size_t(DefaultBufferSize)),
+        used_(0)
+    {
+        if (seekable_) {
+            // The sink's offsets are those of the file. patch() writes at
+            // them.
+            const off_t pos = lseek(fd_, 0, SEEK_CUR);
+            if (0 <= pos) {
+                pos_ = PWP_UINT64(pos);
+            }
+            else {
+                seekable_ = false;
+            }
+        }
+    }
+
+    virtual ~FluentFdSink()
+    {
+        flush();
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        const char *p = static_cast<const char*>(buf);
+        if (used_ + len > buf_.size()) {
+            if (!flush()) {
+                return false;
+            }
+            if (len >= buf_.size()) {
+                // too big to buffer
+                if (!writeAll(p, len)) {
+                    return fail();
+                }
+                pos_ += len;
+                return true;
+            }
+        }
+        memcpy(&buf_[used_], p, len);
+        used_ += len;
+        pos_ += len;
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        if (!seekable_ || offset + len > pos_) {
+            return fail();
+        }
+        const PWP_UINT64 bufStart = pos_ - used_;
+        const char *p = static_cast<const char*>(buf);
+        if (offset < bufStart) {
+            // part or all of the range is already on disk
+            const size_t onDisk = size_t(std::min<PWP_UINT64>(len,
+                bufStart - offset));
+            if (!fluentPwriteAll(fd_, p, onDisk, offset)) {
+                return fail();
+            }
+            p += onDisk;
+            len -= onDisk;
+            offset += onDisk;
+        }
+        if (0 != len) {
+            memcpy(&buf_[size_t(offset - bufStart)], p, len);
+        }
+        return true;
+    }
+
+    virtual bool isPatchable() const
+    {
+        return seekable_;
+    }
+
+    int fd() const
+    {
+        return fd_;
+    }
+
+    // Continues a file whose first offset bytes are already written. The
+    // descriptor must be positioned at offset.
+    bool resumeAt(PWP_UINT64 offset)
+    {
+        const bool ret = flush();
+        pos_ = offset;
+        return ret;
+    }
+
+    virtual bool flush()
+    {
+        if (0 != used_) {
+            if (!writeAll(buf_.data(), used_)) {
+                used_ = 0;
+                return fail();
+            }
+            used_ = 0;
+        }
+        return ok();
+    }
+
+private:
+    bool writeAll(const char *p, size_t len)
+    {
+        while (0 != len) {
+            const ssize_t n = ::write(fd_, p, len);
+            if (n < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                return false;
+            }
+            p += n;
+            len -= size_t(n);
+        }
+        return true;
+    }
+
+private:
+    int                 fd_;
+    bool                seekable_;
+    std::vector<char>   buf_;
+    size_t              used_;
+};
+
+
+// Buffered writes with pwrite() to a seekable file descriptor, starting at
+// byte base of the file. The offset of the descriptor is left alone, so
+// another sink can append to the same file meanwhile. Used to fill a range
+// of the case file reserved ahead of time. Not patchable.
+class FluentPwriteSink : public FluentSink {
+public:
+    enum { DefaultBufferSize = 1024 * 1024 };
+
+    FluentPwriteSink(int fd, PWP_UINT64 base,
+            size_t bufSize = DefaultBufferSize) :
+        fd_(fd),
+        base_(base),
+        buf_(bufSize ? bufSize : size_t(DefaultBufferSize)),
+        used_(0)
+    {
+    }
+
+    virtual ~FluentPwriteSink()
+    {
+        flush();
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        const char *p = static_cast<const char*>(buf);
+        if (used_ + len > buf_.size()) {
+            if (!flush()) {
+                return false;
+            }
+            if (len >= buf_.size()) {
+                // too big to buffer
+                if (!fluentPwriteAll(fd_, p, len, base_ + pos_)) {
+                    return fail();
+                }
+                pos_ += len;
+                return true;
+            }
+        }
+        memcpy(&buf_[used_], p, len);
+        used_ += len;
+        pos_ += len;
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64, const void *, size_t)
+    {
+        return fail();
+    }
+
+    virtual bool isPatchable() const
+    {
+        return false;
+    }
+
+    virtual bool flush()
+    {
+        if (0 != used_) {
+            const size_t used = used_;
+            used_ = 0;
+            if (!fluentPwriteAll(fd_, buf_.data(), used,
+                    base_ + pos_ - used)) {
+                return fail();
+            }
+        }
+        return ok();
+    }
+
+private:
+    int                 fd_;
+    PWP_UINT64          base_;
+    std::vector<char>   buf_;
+    size_t              used_;
+};
+
+
+
+// Writes through large aligned buffers with O_DIRECT (F_NOCACHE on macOS) so
+// that big exports bypass the page cache. Only whole Alignment blocks are
+// written. flush() writes the partial last block zero padded and truncates
+// the file to its logical size. patch() updates bytes that are already on
+// disk with an aligned read-modify-write of the blocks they are in.
+class FluentDirectSink : public FluentSink {
+public:
+    enum {
+        Alignment = 4096,
+        DefaultBufferSize = 8 * 1024 * 1024
+    };
+
+    FluentDirectSink() :
+        fd_(-1),
+        base_(0),
+        bufStart_(0),
+        buf_(nullptr),
+        block_(nullptr),
+        size_(0),
+        used_(0)
+    {
+    }
+
+    virtual ~FluentDirectSink()
+    {
+        close();
+    }
+
+    // Opens filename for direct writes starting at byte base, which must be
+    // a multiple of Alignment. Returns false if the file system does not
+    // support direct I/O.
+    bool open(const char *filename, PWP_UINT64 base,
+        size_t bufSize = DefaultBufferSize)
+    {
+        close();
+        if (0 != base % Alignment) {
+            return false;
+        }
+        int flags = O_RDWR;
+#if defined(O_DIRECT)
+        flags |= O_DIRECT;
+#endif
+        fd_ = ::open(filename, flags);
+        if (fd_ < 0) {
+            return false;
+        }
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+        fcntl(fd_, F_NOCACHE, 1);
+#endif
+        size_ = std::max(size_t(Alignment), (bufSize + Alignment - 1) /
+            Alignment * Alignment);
+        void *buf = nullptr;
+        void *block = nullptr;
+        if (0 != posix_memalign(&buf, Alignment, size_) ||
+                0 != posix_memalign(&block, Alignment, Alignment)) {
+            free(buf);
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        buf_ = static_cast<char*>(buf);
+        block_ = static_cast<char*>(block);
+        base_ = base;
+        bufStart_ = base;
+        used_ = 0;
+        pos_ = 0;
+        failed_ = false;
+        return true;
+    }
+
+    // Flushes and closes the file
+    bool close()
+    {
+        bool ret = true;
+        if (fd_ >= 0) {
+            ret = flush();
+            ret = (0 == ::close(fd_)) && ret;
+            fd_ = -1;
+        }
+        free(buf_);
+        free(block_);
+        buf_ = nullptr;
+        block_ = nullptr;
+        return ret;
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        const char *p = static_cast<const char*>(buf);
+        while (0 != len) {
+            const size_t n = std::min(len, size_ - used_);
+            memcpy(buf_ + used_, p, n);
+            used_ += n;
+            pos_ += n;
+            p += n;
+            len -= n;
+            if (used_ == size_) {
+                if (!pwriteAll(buf_, size_, bufStart_)) {
+                    return fail();
+                }
+                bufStart_ += size_;
+                used_ = 0;
+            }
+        }
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        if (offset + len > pos_) {
+            return fail();
+        }
+        const char *p = static_cast<const char*>(buf);
+        PWP_UINT64 at = base_ + offset;
+        while (0 != len) {
+            if (at >= bufStart_) {
+                // still in the buffer
+                memcpy(buf_ + size_t(at - bufStart_), p, len);
+                break;
+            }
+            // on disk, in a whole block before bufStart_
+            const PWP_UINT64 blockStart = at / Alignment * Alignment;
+            const size_t skip = size_t(at - blockStart);
+            const size_t n = size_t(std::min<PWP_UINT64>(len,
+                std::min<PWP_UINT64>(Alignment - skip, bufStart_ - at)));
+            if (!preadAll(block_, Alignment, blockStart)) {
+                return fail();
+            }
+            memcpy(block_ + skip, p, n);
+            if (!pwriteAll(block_, Alignment, blockStart)) {
+                return fail();
+            }
+            p += n;
+            len -= n;
+            at += n;
+        }
+        return true;
+    }
+
+    virtual bool isPatchable() const
+    {
+        return true;
+    }
+
+    virtual bool flush()
+    {
+        if (fd_ < 0 || !ok()) {
+            return ok();
+        }
+        if (0 != used_) {
+            // Write the buffer through its last, partial block. Keep the
+            // partial block buffered; later writes will complete it.
+            const size_t whole = used_ / Alignment * Alignment;
+            const size_t padded = (used_ + Alignment - 1) / Alignment *
+                Alignment;
+            memset(buf_ + used_, 0, padded - used_);
+            if (!pwriteAll(buf_, padded, bufStart_)) {
+                return fail();
+            }
+            if (whole != 0) {
+                memmove(buf_, buf_ + whole, used_ - whole);
+                bufStart_ += whole;
+                used_ -= whole;
+            }
+        }
+        // Drop the padding
+        if (0 != ftruncate(fd_, (off_t)(base_ + pos_))) {
+            return fail();
+        }
+        return true;
+    }
+
+private:
+    bool pwriteAll(const char *p, size_t len, PWP_UINT64 offset)
+    {
+        while (0 != len) {
+            const ssize_t n = ::pwrite(fd_, p, len, (off_t)offset);
+            if (n < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                return false;
+            }
+            p += n;
+            len -= size_t(n);
+            offset += PWP_UINT64(n);
+        }
+        return true;
+    }
+
+    bool preadAll(char *p, size_t len, PWP_UINT64 offset)
+    {
+        while (0 != len) {
+            const ssize_t n = ::pread(fd_, p, len, (off_t)offset);
+            if (n < 0 && EINTR == errno) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            len -= size_t(n);
+            offset += PWP_UINT64(n);
+        }
+        return true;
+    }
+
+    FluentDirectSink(const FluentDirectSink&) = delete;
+    FluentDirectSink& operator=(const FluentDirectSink&) = delete;
+
+private:
+    int         fd_;
+    PWP_UINT64  base_;      // file offset of sink offset 0
+    PWP_UINT64  bufStart_;  // file offset of buf_[0], a multiple of Alignment
+    char       *buf_;
+    char       *block_;     // read-modify-write block for patch()
+    size_t      size_;
+    size_t      used_;
+};
+
+
+
+// Writes through a sliding shared memory map of the file. The file is grown
+// one window at a time with posix_fallocate(), so that a full disk fails the
+// write instead of raising SIGBUS on a store into a page the file system
+// cannot back, and the bytes are copied into the map. patch() copies
+// into the map too, or uses pwrite() for bytes before the current window;
+// both go through the same page cache. flush() unmaps the window and
+// truncates the file to its logical size. macOS has no posix_fallocate();
+// open() fails there.
+class FluentMmapSink : public FluentSink {
+public:
+    enum { DefaultWindowSize = 64 * 1024 * 1024 };
+
+    FluentMmapSink() :
+        fd_(-1),
+        base_(0),
+        winStart_(0),
+        win_(nullptr),
+        winSize_(0),
+        mapped_(false)
+    {
+    }
+
+    virtual ~FluentMmapSink()
+    {
+        close();
+    }
+
+    // Opens filename for mapped writes starting at byte base
+    bool open(const char *filename, PWP_UINT64 base,
+        size_t windowSize = DefaultWindowSize)
+    {
+        close();
+        fd_ = ::open(filename, O_RDWR);
+        if (fd_ < 0) {
+            return false;
+        }
+        const size_t page = size_t(sysconf(_SC_PAGESIZE));
+        winSize_ = std::max(page, (windowSize + page - 1) / page * page);
+        base_ = base;
+        winStart_ = base - base % page;
+        pos_ = 0;
+        failed_ = false;
+        if (!map(winStart_)) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // Flushes and closes the file
+    bool close()
+    {
+        bool ret = true;
+        if (fd_ >= 0) {
+            ret = flush();
+            ret = (0 == ::close(fd_)) && ret;
+            fd_ = -1;
+        }
+        return ret;
+    }
+
+    virtual bool write(const void *buf, size_t len)
+    {
+        const char *p = static_cast<const char*>(buf);
+        while (0 != len) {
+            const PWP_UINT64 off = base_ + pos_;
+            if (!mapped_ && !map(winStart_)) {
+                return fail();
+            }
+            if (off == winStart_ + winSize_ && !map(off)) {
+                return fail();
+            }
+            const size_t n = size_t(std::min<PWP_UINT64>(len,
+                winStart_ + winSize_ - off));
+            memcpy(win_ + (off - winStart_), p, n);
+            pos_ += n;
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    virtual bool patch(PWP_UINT64 offset, const void *buf, size_t len)
+    {
+        if (fd_ < 0 || offset + len > pos_) {
+            return fail();
+        }
+        const char *p = static_cast<const char*>(buf);
+        PWP_UINT64 off = base_ + offset;
+        if (off < winStart_ || !mapped_) {
+            // part or all of the range is before the window
+            const size_t before = mapped_ ? size_t(std::min<PWP_UINT64>(len,
+                winStart_ - off)) : len;
+            size_t done = 0;
+            while (done < before) {
+                const ssize_t n = ::pwrite(fd_, p + done, before - done,
+                    (off_t)(off + done));
+                if (n < 0 && EINTR == errno) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return fail();
+                }
+                done += size_t(n);
+            }
+            p += before;
+            len -= before;
+            off += before;
+        }
+        if (0 != len) {
+            memcpy(win_ + (off - winStart_), p, len);
+        }
+        return true;
+    }
+
+    virtual bool isPatchable() const
+    {
+        return true;
+    }
+
+    virtual bool flush()
+    {
+        if (fd_ < 0 || !ok()) {
+            return ok();
+        }
+        // The window must not outlive the truncation; the next write maps
+        // it again.
+        unmap();
+        if (0 != ftruncate(fd_, (off_t)(base_ + pos_))) {
+            return fail();
+        }
+        return true;
+    }
+
+private:
+    // Maps the window starting at start, a multiple of the page size,
+    // growing the file to cover it. The blocks of the window are allocated
+    // before it is mapped.
+    bool map(PWP_UINT64 start)
+    {
+        unmap();
+        struct stat st;
+        if (0 != fstat(fd_, &st)) {
+            return false;
+        }
+        if (PWP_UINT64(st.st_size) < start + winSize_) {
+#if defined(__APPLE__)
+            return false;
+#else
+            // Only the part past the end of the file needs blocks
+            const PWP_UINT64 from = std::max(start, PWP_UINT64(st.st_size));
+            if (0 != posix_fallocate(fd_, (off_t)from,
+                    (off_t)(start + winSize_ - from))) {
+                return false;
+            }
+#endif
+        }
+        void *win = mmap(nullptr, winSize_, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd_, (off_t)start);
+        if (MAP_FAILED == win) {
+            return false;
+        }
+        win_ = static_cast<char*>(win);
+        winStart_ = start;
+        mapped_ = true;
+        return true;
+    }
+
+    void unmap()
+    {
+        if (mapped_) {
+            munmap(win_, winSize_);
+            win_ = nullptr;
+            mapped_ = false;
+        }
+    }
+
+    FluentMmapSink(const FluentMmapSink&) = delete;
+    FluentMmapSink& operator=(const FluentMmapSink&) = delete;
+
+private:
+    int         fd_;
+    PWP_UINT64  base_;      // file offset of sink offset 0
+    PWP_UINT64  winStart_;  // file offset of win_[0], a page multiple
+    char       *win_;
+    size_t      winSize_;
+    bool        mapped_;
+};
+
+#endif // !WINDOWS
+
+
+// Redirects the next export to sink instead of the export file. The sink
+// must outlive the export. Intended for in-process consumers and tests.
+void fluentSetOutputSink(FluentSink *sink);
+
+#endif /* _FLUENTSINK_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
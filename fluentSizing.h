@@ -0,0 +1,295 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export sizing
+ *
+ * FluentSizeEstimate holds the expected size of a case file by section and
+ * the expected peak memory of the export. It is filled from the grid model's
+ * element counts, or exactly by a dry run that streams the faces into a
+ * counting sink. The estimate is also used to preallocate the export file.
+ * fluentProbeBufferSize() picks an output buffer size for the AutoTune
+ * export attribute.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTSIZING_H_
+#define _FLUENTSIZING_H_
+
+#include "apiPWP.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(WINDOWS)
+#   include <windows.h>
+#else
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <sys/statvfs.h>
+#   include <unistd.h>
+#endif
+
+
+struct FluentSizeEstimate {
+    // Totals of one section id
+    struct Section {
+        PWP_UINT32  id;
+        PWP_UINT32  count;
+        PWP_UINT64  bytes;
+    };
+
+    typedef std::pair<std::string, PWP_UINT64> MemoryItem;
+
+    FluentSizeEstimate() :
+        otherBytes(0),
+        freeBytes(~PWP_UINT64(0)),
+        exact(false),
+        partitionsEstimated(false)
+    {
+    }
+
+    // Adds count sections of the given id totaling bytes
+    void addSection(PWP_UINT32 id, PWP_UINT32 count, PWP_UINT64 bytes)
+    {
+        for (size_t i = 0; i < sections.size(); ++i) {
+            if (id == sections[i].id) {
+                sections[i].count += count;
+                sections[i].bytes += bytes;
+                return;
+            }
+        }
+        const Section s = { id, count, bytes };
+        sections.push_back(s);
+    }
+
+    void addMemory(const char *what, PWP_UINT64 bytes)
+    {
+        memory.push_back(MemoryItem(what, bytes));
+    }
+
+    PWP_UINT64 totalBytes() const
+    {
+        PWP_UINT64 ret = otherBytes;
+        for (size_t i = 0; i < sections.size(); ++i) {
+            ret += sections[i].bytes;
+        }
+        return ret;
+    }
+
+    PWP_UINT64 peakMemory() const
+    {
+        PWP_UINT64 ret = 0;
+        for (size_t i = 0; i < memory.size(); ++i) {
+            ret += memory[i].second;
+        }
+        return ret;
+    }
+
+    // true if the free space is known and too small for the file
+    bool exceedsFreeSpace() const
+    {
+        return ~PWP_UINT64(0) != freeBytes && totalBytes() > freeBytes;
+    }
+
+    // The estimate as lines of text
+    std::vector<std::string> report() const
+    {
+        std::vector<std::string> ret;
+        char line[256];
+        snprintf(line, sizeof(line), "Case file size (%s) : %llu bytes",
+            (!exact ? "estimated" : (partitionsEstimated ?
+                "exact, partitions estimated" : "exact")),
+            (unsigned long long)totalBytes());
+        ret.push_back(line);
+        for (size_t i = 0; i < sections.size(); ++i) {
+            snprintf(line, sizeof(line), "  section %3u : %8u sections "
+                "%14llu bytes", sections[i].id, sections[i].count,
+                (unsigned long long)sections[i].bytes);
+            ret.push_back(line);
+        }
+        snprintf(line, sizeof(line), "  other       :                   "
+            "%14llu bytes", (unsigned long long)otherBytes);
+        ret.push_back(line);
+        snprintf(line, sizeof(line), "Peak memory (estimated) : %llu bytes",
+            (unsigned long long)peakMemory());
+        ret.push_back(line);
+        for (size_t i = 0; i < memory.size(); ++i) {
+            snprintf(line, sizeof(line), "  %-22s %14llu bytes",
+                memory[i].first.c_str(),
+                (unsigned long long)memory[i].second);
+            ret.push_back(line);
+        }
+        if (~PWP_UINT64(0) != freeBytes) {
+            snprintf(line, sizeof(line), "Free disk space : %llu bytes%s",
+                (unsigned long long)freeBytes,
+                (exceedsFreeSpace() ? " (NOT ENOUGH)" : ""));
+            ret.push_back(line);
+        }
+        return ret;
+    }
+
+    // Writes report() to filename
+    bool write(const char *filename) const
+    {
+        FILE *fp = fopen(filename, "w");
+        if (nullptr == fp) {
+            return false;
+        }
+        const std::vector<std::string> lines = report();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            fprintf(fp, "%s\n", lines[i].c_str());
+        }
+        const bool ret = !ferror(fp);
+        return (0 == fclose(fp)) && ret;
+    }
+
+    std::vector<Section>    sections;
+    std::vector<MemoryItem> memory;
+    PWP_UINT64              otherBytes;
+    PWP_UINT64              freeBytes;  // ~0 if unknown
+    bool                    exact;
+    bool                    partitionsEstimated;    // of an exact size
+};
+
+
+// Sum of the number of hex digits of the integers 1..n. Used to size the
+// hex indices written by the face and cell sections.
+static inline PWP_UINT64
+fluentHexDigitSum(PWP_UINT64 n)
+{
+    PWP_UINT64 ret = 0;
+    PWP_UINT64 lo = 1;
+    for (PWP_UINT64 digits = 1; lo <= n; ++digits, lo *= 16) {
+        const PWP_UINT64 hi = (lo > (~PWP_UINT64(0) / 16)) ? n :
+            std::min(n, lo * 16 - 1);
+        ret += (hi - lo + 1) * digits;
+    }
+    return ret;
+}
+
+
+// Free bytes on the file system holding path. Returns ~0 if unknown.
+static inline PWP_UINT64
+fluentFreeDiskSpace(const char *path)
+{
+    std::string dir(path ? path : ".");
+    const size_t slash = dir.find_last_of("/\\");
+    dir = (std::string::npos == slash) ? std::string(".") :
+        dir.substr(0, slash + 1);
+#if defined(WINDOWS)
+    ULARGE_INTEGER avail;
+    if (GetDiskFreeSpaceExA(dir.c_str(), &avail, NULL, NULL)) {
+        return PWP_UINT64(avail.QuadPart);
+    }
+#else
+    struct statvfs st;
+    if (0 == statvfs(dir.c_str(), &st)) {
+        return PWP_UINT64(st.f_bavail) * PWP_UINT64(st.f_frsize);
+    }
+#endif
+    return ~PWP_UINT64(0);
+}
+
+
+#if !defined(WINDOWS)
+
+// Reserves len bytes of disk space for fd starting at offset without
+// changing the file size. Returns 0 on success, ENOSPC if the disk is too
+// full, or another errno value if preallocation is not available.
+static inline int
+fluentPreallocate(int fd, PWP_UINT64 offset, PWP_UINT64 len)
+{
+#if defined(__linux__)
+    if (0 == fallocate(fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)len)) {
+        return 0;
+    }
+    return errno;
+#else
+    (void)fd;
+    (void)offset;
+    (void)len;
+    return ENOTSUP;
+#endif
+}
+
+
+// Measures the write throughput of the file system holding path for buffer
+// sizes from 64 KiB to 16 MiB. Each size writes ProbeBytes to a scratch file
+// next to path, made unique with mkstemp(), and syncs it. Returns the
+// smallest size within 10% of the best throughput and sets mbps to its rate,
+// or returns 0 if the probe could not write.
+static inline size_t
+fluentProbeBufferSize(const char *path, double &mbps)
+{
+    enum { ProbeBytes = 8 * 1024 * 1024 };
+    mbps = 0.0;
+    std::string scratch = std::string(path ? path : "fluent") +
+        ".probe.XXXXXX";
+    const int fd = mkstemp(&scratch[0]);
+    if (fd < 0) {
+        return 0;
+    }
+    std::vector<char> buf(16 * 1024 * 1024, ' ');
+    std::vector<std::pair<size_t, double> > rates;
+    for (size_t size = 64 * 1024; size <= buf.size(); size *= 4) {
+        const std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        bool ok = (0 == ftruncate(fd, 0)) && (0 == lseek(fd, 0, SEEK_SET));
+        for (size_t n = 0; ok && n < ProbeBytes; n += size) {
+            const size_t len = std::min(size, size_t(ProbeBytes) - n);
+            ok = (ssize_t(len) == ::write(fd, buf.data(), len));
+        }
+#if defined(__linux__)
+        ok = ok && (0 == fdatasync(fd));
+#else
+        ok = ok && (0 == fsync(fd));
+#endif
+        if (!ok) {
+            break;
+        }
+        const double secs = std::max(1e-6, std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count());
+        rates.push_back(std::make_pair(size, ProbeBytes / secs / 1.0e6));
+    }
+    ::close(fd);
+    remove(scratch.c_str());
+    double best = 0.0;
+    for (size_t i = 0; i < rates.size(); ++i) {
+        best = std::max(best, rates[i].second);
+    }
+    for (size_t i = 0; i < rates.size(); ++i) {
+        if (rates[i].second >= 0.9 * best) {
+            mbps = rates[i].second;
+            return rates[i].first;
+        }
+    }
+    return 0;
+}
+
+#endif // !WINDOWS
+
+#endif /* _FLUENTSIZING_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,212 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export spill file
+ *
+ * FluentSpillFile keeps sorted runs of plain data items in an anonymous
+ * temporary file and merges them back in order. The export uses it to keep
+ * the cached shadow faces within a memory budget: each time the budget is
+ * reached the faces are sorted and spilled as one run, and at the end of the
+ * stream all runs are merged with a k-way merge.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTSPILL_H_
+#define _FLUENTSPILL_H_
+
+#include "apiPWP.h"
+
+#include <algorithm>
+#include <queue>
+#include <stdio.h>
+#include <vector>
+
+
+template<typename T>
+class FluentSpillFile {
+public:
+    FluentSpillFile() :
+        fp_(nullptr),
+        end_(0)
+    {
+    }
+
+    ~FluentSpillFile()
+    {
+        if (nullptr != fp_) {
+            fclose(fp_);
+        }
+    }
+
+    // Appends a sorted run of cnt items
+    bool addRun(const T *items, size_t cnt)
+    {
+        if (nullptr == fp_) {
+            fp_ = tmpfile();
+            if (nullptr == fp_) {
+                return false;
+            }
+        }
+        if (0 != seek(end_) || cnt != fwrite(items, sizeof(T), cnt, fp_)) {
+            return false;
+        }
+        const Run run = { end_, cnt };
+        runs_.push_back(run);
+        end_ += PWP_UINT64(cnt) * sizeof(T);
+        return true;
+    }
+
+    size_t runCount() const
+    {
+        return runs_.size();
+    }
+
+    // Number of spilled items
+    PWP_UINT64 itemCount() const
+    {
+        return end_ / sizeof(T);
+    }
+
+    // Merges the spilled runs and the sorted in-memory run last[0..lastCnt).
+    // Calls emit(items, cnt) with batches of at most batchSize merged items
+    // until emit() returns false. The read buffers use about memory bytes.
+    // Returns false on a read error.
+    template<typename Less, typename Emit>
+    bool merge(const T *last, size_t lastCnt, Less less, Emit emit,
+        size_t memory, size_t batchSize)
+    {
+        const size_t nSrc = runs_.size() + 1;
+        const size_t bufItems = std::max<size_t>(1024,
+            memory / sizeof(T) / nSrc);
+        std::vector<Source> src(nSrc);
+        for (size_t i = 0; i < runs_.size(); ++i) {
+            src[i].offset = runs_[i].offset;
+            src[i].left = runs_[i].cnt;
+            if (!refill(src[i], bufItems)) {
+                return false;
+            }
+        }
+        src.back().items = last;
+        src.back().cnt = lastCnt;
+
+        // Min-heap of the sources by their current item
+        auto greater = [&](size_t a, size_t b) {
+            return less(src[b].items[src[b].pos], src[a].items[src[a].pos]);
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(greater)>
+            heap(greater);
+        for (size_t i = 0; i < nSrc; ++i) {
+            if (src[i].pos < src[i].cnt) {
+                heap.push(i);
+            }
+        }
+        std::vector<T> out;
+        out.reserve(batchSize);
+        while (!heap.empty()) {
+            const size_t i = heap.top();
+            heap.pop();
+            Source &s = src[i];
+            out.push_back(s.items[s.pos++]);
+            if (s.pos == s.cnt && !refill(s, bufItems)) {
+                return false;
+            }
+            if (s.pos < s.cnt) {
+                heap.push(i);
+            }
+            if (out.size() == batchSize) {
+                if (!emit(out.data(), out.size())) {
+                    return true;
+                }
+                out.clear();
+            }
+        }
+        if (!out.empty()) {
+            emit(out.data(), out.size());
+        }
+        return true;
+    }
+
+private:
+    struct Run {
+        PWP_UINT64  offset;
+        size_t      cnt;
+    };
+
+    // A run being merged. items points into buf for a spilled run.
+    struct Source {
+        Source() :
+            items(nullptr),
+            cnt(0),
+            pos(0),
+            offset(0),
+            left(0)
+        {
+        }
+
+        const T        *items;
+        size_t          cnt;
+        size_t          pos;
+        PWP_UINT64      offset;     // file offset of the next unread item
+        size_t          left;       // unread items in the file
+        std::vector<T>  buf;
+    };
+
+    // Reads the next items of a spilled run. Does nothing for the in-memory
+    // run or an exhausted one.
+    bool refill(Source &s, size_t bufItems)
+    {
+        if (0 == s.left) {
+            return true;
+        }
+        const size_t n = std::min(s.left, bufItems);
+        s.buf.resize(n);
+        if (0 != seek(s.offset) || n != fread(s.buf.data(), sizeof(T), n,
+                fp_)) {
+            return false;
+        }
+        s.items = s.buf.data();
+        s.cnt = n;
+        s.pos = 0;
+        s.offset += PWP_UINT64(n) * sizeof(T);
+        s.left -= n;
+        return true;
+    }
+
+    int seek(PWP_UINT64 offset)
+    {
+#if defined(WINDOWS)
+        return _fseeki64(fp_, (__int64)offset, SEEK_SET);
+#else
+        return fseeko(fp_, (off_t)offset, SEEK_SET);
+#endif
+    }
+
+    FluentSpillFile(const FluentSpillFile&) = delete;
+    FluentSpillFile& operator=(const FluentSpillFile&) = delete;
+
+private:
+    FILE               *fp_;
+    PWP_UINT64          end_;
+    std::vector<Run>    runs_;
+};
+
+#endif /* _FLUENTSPILL_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
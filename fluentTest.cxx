@@ -0,0 +1,1851 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export regression tests
+ *
+ * fluentTest builds small meshes with FluentMeshWriter, exports them through
+ * the batch converter's grid model and checks the case files. It runs all
+ * tests, or the tests named on the command line, and prints PASS or FAIL for
+ * each. The exit status is the number of failed tests. A test that has not
+ * finished after TestTimeout seconds fails the run, so a hang is reported
+ * instead of stalling it. POSIX only. See README.md for the build.
+ *
+ ***************************************************************************/
+
+#define FLUENT_BATCH_NO_MAIN
+#include "fluentBatch.cxx"
+
+#include "fluentCheckpoint.h"
+#include "fluentConstants.h"
+#include "fluentFanOut.h"
+#include "fluentHash.h"
+#include "fluentSink.h"
+
+#if defined(CAEUNSFLUENT_HAVE_HDF5)
+#   include <hdf5.h>
+#endif
+#if defined(CAEUNSFLUENT_HAVE_ZLIB)
+#   include <zlib.h>
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <dirent.h>
+#include <fcntl.h>
+#include <math.h>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unistd.h>
+
+
+/************************************************
+*   Test support
+*************************************************/
+
+// Seconds a test may take
+static const int TestTimeout = 120;
+
+// Folder of the test files
+static std::string TestDir;
+
+// Files created in TestDir
+static std::set<std::string> TestFiles;
+
+// Runtime item of all exports
+static CAEP_RTITEM Rti;
+
+
+// Path of file name in TestDir. The file is removed after the tests.
+static std::string
+testFile(const char *name)
+{
+    const std::string path = TestDir + "/" + name;
+    TestFiles.insert(path);
+    return path;
+}
+
+
+// Prints what failed if cond is false
+static bool
+check(const bool cond, const char *what)
+{
+    if (!cond) {
+        fprintf(stderr, "  failed: %s\n", what);
+    }
+    return cond;
+}
+
+
+// Contents of file path, empty if it cannot be read
+static std::string
+readFile(const std::string &path)
+{
+    std::string ret;
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (nullptr != fp) {
+        char buf[65536];
+        size_t n;
+        while (0 != (n = fread(buf, 1, sizeof(buf), fp))) {
+            ret.append(buf, n);
+        }
+        fclose(fp);
+    }
+    return ret;
+}
+
+
+// Case file text without its second line, the export's time stamp
+static std::string
+caseText(std::string text)
+{
+    const size_t begin = text.find('\n');
+    const size_t end = (std::string::npos == begin) ? begin :
+        text.find('\n', begin + 1);
+    if (std::string::npos != end) {
+        text.erase(begin + 1, end - begin);
+    }
+    return text;
+}
+
+
+// A node (10), cell (12) or face (13) section of a text case file
+struct TextSection {
+    PWP_UINT32                  id;
+    std::vector<PWP_UINT64>     header;     // the hex numbers of the header
+    std::vector<std::string>    body;       // the words of the body, if any
+};
+
+// The node, cell and face sections of case file text, in file order. Only
+// the declaration sections, zone 0, are left out.
+static std::vector<TextSection>
+textSections(const std::string &text)
+{
+    std::vector<TextSection> ret;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        unsigned id = 0;
+        int used = 0;
+        if (1 != sscanf(line.c_str(), "(%u (%n", &id, &used) || 0 == used ||
+                id < FLUENT_NODES || id > FLUENT_FACES) {
+            continue;
+        }
+        TextSection s;
+        s.id = id;
+        const size_t close = line.find(')', size_t(used));
+        std::istringstream hdr(line.substr(size_t(used), close - used));
+        std::string word;
+        while (hdr >> word) {
+            s.header.push_back(strtoull(word.c_str(), nullptr, 16));
+        }
+        if (s.header.empty() || 0 == s.header[0]) {
+            continue;
+        }
+        if (std::string::npos != line.find('(', close)) {
+            while (std::getline(in, line) && 0 != line.compare(0, 2, "))")) {
+                std::istringstream words(line);
+                while (words >> word) {
+                    s.body.push_back(word);
+                }
+            }
+        }
+        ret.push_back(s);
+    }
+    return ret;
+}
+
+
+// Writes a box of nx * ny * nz hex cells to the mesh file name in TestDir.
+// The cells are one fluid block. The faces at x = 0 are the inlet, those at
+// x = nx the outlet and all others a wall.
+static std::string
+writeBox(const char *name, const PWP_UINT32 nx, const PWP_UINT32 ny,
+    const PWP_UINT32 nz)
+{
+    FluentMeshWriter w(3);
+    auto vert = [=](PWP_UINT32 i, PWP_UINT32 j, PWP_UINT32 k) {
+        return (k * (ny + 1) + j) * (nx + 1) + i;
+    };
+    for (PWP_UINT32 k = 0; k <= nz; ++k) {
+        for (PWP_UINT32 j = 0; j <= ny; ++j) {
+            for (PWP_UINT32 i = 0; i <= nx; ++i) {
+                w.addVertex(0.1 * i, 0.1 * j, 0.1 * k);
+            }
+        }
+    }
+    const PWP_UINT32 fluid = w.addBlock("fluid", 1, "Fluid", 1);
+    for (PWP_UINT32 k = 0; k < nz; ++k) {
+        for (PWP_UINT32 j = 0; j < ny; ++j) {
+            for (PWP_UINT32 i = 0; i < nx; ++i) {
+                const PWP_UINT32 hex[8] = {
+                    vert(i, j, k), vert(i + 1, j, k), vert(i + 1, j + 1, k),
+                    vert(i, j + 1, k), vert(i, j, k + 1),
+                    vert(i + 1, j, k + 1), vert(i + 1, j + 1, k + 1),
+                    vert(i, j + 1, k + 1) };
+                w.addBlockElement(fluid, FluentMeshFile::Hex, hex);
+            }
+        }
+    }
+    const PWP_UINT32 inlet = w.addDomain("inlet", 10, "Pressure Inlet", 4);
+    const PWP_UINT32 outlet = w.addDomain("outlet", 11, "Pressure Outlet", 5);
+    const PWP_UINT32 wall = w.addDomain("wall", 12, "Wall", 3);
+    auto quad = [&](PWP_UINT32 d, PWP_UINT32 a, PWP_UINT32 b, PWP_UINT32 c,
+            PWP_UINT32 e) {
+        const PWP_UINT32 v[4] = { a, b, c, e };
+        w.addDomainElement(d, FluentMeshFile::Quad, v);
+    };
+    for (PWP_UINT32 k = 0; k < nz; ++k) {
+        for (PWP_UINT32 j = 0; j < ny; ++j) {
+            quad(inlet, vert(0, j, k), vert(0, j + 1, k),
+                vert(0, j + 1, k + 1), vert(0, j, k + 1));
+            quad(outlet, vert(nx, j, k), vert(nx, j + 1, k),
+                vert(nx, j + 1, k + 1), vert(nx, j, k + 1));
+        }
+    }
+    for (PWP_UINT32 i = 0; i < nx; ++i) {
+        for (PWP_UINT32 k = 0; k < nz; ++k) {
+            quad(wall, vert(i, 0, k), vert(i + 1, 0, k),
+                vert(i + 1, 0, k + 1), vert(i, 0, k + 1));
+            quad(wall, vert(i, ny, k), vert(i + 1, ny, k),
+                vert(i + 1, ny, k + 1), vert(i, ny, k + 1));
+        }
+        for (PWP_UINT32 j = 0; j < ny; ++j) {
+            quad(wall, vert(i, j, 0), vert(i + 1, j, 0),
+                vert(i + 1, j + 1, 0), vert(i, j + 1, 0));
+            quad(wall, vert(i, j, nz), vert(i + 1, j, nz),
+                vert(i + 1, j + 1, nz), vert(i, j + 1, nz));
+        }
+    }
+    const std::string path = testFile(name);
+    return w.write(path.c_str()) ? path : std::string();
+}
+
+
+// Writes three slabs of n * n * n cells along x to the mesh file name in
+// TestDir: hex cells and mixed cells that are two blocks of the fluid VC,
+// then hex cells of the solid VC. The mixed slab splits every other column
+// of hexes along z in two wedges, whose faces at z = 0 and z = n are
+// triangles. The faces at
+// x = 0 are the inlet, those at x = 3n the outlet, those at y = 0 wallA and
+// all other outer faces wallB. The faces between the mixed and the solid
+// slab are the baffle, an Interior BC with shadow faces.
+static std::string
+writeSlabs(const char *name, const PWP_UINT32 n)
+{
+    FluentMeshWriter w(3);
+    const PWP_UINT32 nx = 3 * n;
+    auto vert = [=](PWP_UINT32 i, PWP_UINT32 j, PWP_UINT32 k) {
+        return (k * (n + 1) + j) * (nx + 1) + i;
+    };
+    auto split = [=](PWP_UINT32 i, PWP_UINT32 j) {
+        return i >= n && i < 2 * n && 0 == (i + j) % 2;
+    };
+    for (PWP_UINT32 k = 0; k <= n; ++k) {
+        for (PWP_UINT32 j = 0; j <= n; ++j) {
+            for (PWP_UINT32 i = 0; i <= nx; ++i) {
+                w.addVertex(0.1 * i + 1e-7 * j, 0.1 * j - 0.05 * k,
+                    0.1 * k + 1234.5);
+            }
+        }
+    }
+    const PWP_UINT32 hexes = w.addBlock("fluidA", 1, "Fluid", 1);
+    const PWP_UINT32 mixed = w.addBlock("fluidB", 2, "Fluid", 1);
+    const PWP_UINT32 solid = w.addBlock("My Solid", 3, "Solid", 2);
+    for (PWP_UINT32 k = 0; k < n; ++k) {
+        for (PWP_UINT32 j = 0; j < n; ++j) {
+            for (PWP_UINT32 i = 0; i < nx; ++i) {
+                const PWP_UINT32 c[8] = {
+                    vert(i, j, k), vert(i + 1, j, k), vert(i + 1, j + 1, k),
+                    vert(i, j + 1, k), vert(i, j, k + 1),
+                    vert(i + 1, j, k + 1), vert(i + 1, j + 1, k + 1),
+                    vert(i, j + 1, k + 1) };
+                if (!split(i, j)) {
+                    w.addBlockElement((i < n) ? hexes : ((i < 2 * n) ?
+                        mixed : solid), FluentMeshFile::Hex, c);
+                    continue;
+                }
+                const PWP_UINT32 a[6] = { c[0], c[1], c[2], c[4], c[5],
+                    c[6] };
+                const PWP_UINT32 b[6] = { c[0], c[2], c[3], c[4], c[6],
+                    c[7] };
+                w.addBlockElement(mixed, FluentMeshFile::Wedge, a);
+                w.addBlockElement(mixed, FluentMeshFile::Wedge, b);
+            }
+        }
+    }
+    const PWP_UINT32 inlet = w.addDomain("inlet", 10, "Pressure Inlet", 4);
+    const PWP_UINT32 outlet = w.addDomain("outlet", 11, "Pressure Outlet", 5);
+    const PWP_UINT32 wallA = w.addDomain("wallA", 12, "Wall", 3);
+    const PWP_UINT32 wallB = w.addDomain("wallB", 13, "Wall", 3);
+    const PWP_UINT32 baffle = w.addDomain("baffle", 14, "Interior", 14);
+    auto face = [&](PWP_UINT32 d, PWP_UINT32 a, PWP_UINT32 b, PWP_UINT32 c,
+            PWP_UINT32 e) {
+        const PWP_UINT32 v[4] = { a, b, c, e };
+        w.addDomainElement(d, (PWP_BADID == e) ? FluentMeshFile::Tri :
+            FluentMeshFile::Quad, v);
+    };
+    for (PWP_UINT32 k = 0; k < n; ++k) {
+        for (PWP_UINT32 j = 0; j < n; ++j) {
+            face(inlet, vert(0, j, k), vert(0, j + 1, k),
+                vert(0, j + 1, k + 1), vert(0, j, k + 1));
+            face(outlet, vert(nx, j, k), vert(nx, j + 1, k),
+                vert(nx, j + 1, k + 1), vert(nx, j, k + 1));
+            face(baffle, vert(2 * n, j, k), vert(2 * n, j + 1, k),
+                vert(2 * n, j + 1, k + 1), vert(2 * n, j, k + 1));
+        }
+    }
+    for (PWP_UINT32 i = 0; i < nx; ++i) {
+        for (PWP_UINT32 k = 0; k < n; ++k) {
+            face(wallA, vert(i, 0, k), vert(i + 1, 0, k),
+                vert(i + 1, 0, k + 1), vert(i, 0, k + 1));
+            face(wallB, vert(i, n, k), vert(i + 1, n, k),
+                vert(i + 1, n, k + 1), vert(i, n, k + 1));
+        }
+        for (PWP_UINT32 j = 0; j < n; ++j) {
+            for (PWP_UINT32 k = 0; k <= n; k += n) {
+                if (!split(i, j)) {
+                    face(wallB, vert(i, j, k), vert(i + 1, j, k),
+                        vert(i + 1, j + 1, k), vert(i, j + 1, k));
+                    continue;
+                }
+                face(wallB, vert(i, j, k), vert(i + 1, j, k),
+                    vert(i + 1, j + 1, k), PWP_BADID);
+                face(wallB, vert(i, j, k), vert(i + 1, j + 1, k),
+                    vert(i, j + 1, k), PWP_BADID);
+            }
+        }
+    }
+    const std::string path = testFile(name);
+    return w.write(path.c_str()) ? path : std::string();
+}
+
+
+// Exports mesh to caseFile with the export attributes attrs
+static bool
+runExport(const std::string &mesh, const std::string &caseFile,
+    const std::map<std::string, std::string> &attrs =
+        std::map<std::string, std::string>(),
+    const PWP_ENUM_PRECISION precision = PWP_PRECISION_DOUBLE)
+{
+    Model.attributes = attrs;
+    if (mesh.empty() || !checkAttributes(Model) ||
+            !loadModel(Model, mesh.c_str())) {
+        return false;
+    }
+    Model.threads = streamThreads(Rti.model);
+    return 0 == exportModel(Rti, caseFile.c_str(), precision);
+}
+
+
+// Path of file name in the folder of this source file
+static std::string
+sourceFile(const char *name)
+{
+    const std::string src = __FILE__;
+    const size_t sep = src.find_last_of('/');
+    return (std::string::npos == sep) ? name : src.substr(0, sep + 1) + name;
+}
+
+
+/************************************************
+*   Tests
+*************************************************/
+
+// The case file of the slabs grid is byte for byte the golden case file,
+// written by the exporter as it was before the output was reworked: node,
+// cell and face sections, two fluid blocks, one of them of mixed cells,
+// connection faces between them, a change of VC, mixed face zones and the
+// shadow faces of the baffle. So is the case file of every setting that must
+// not change the output.
+static bool
+testGolden()
+{
+    const std::string golden = caseText(readFile(
+        sourceFile("fluentTestGolden.cas")));
+    const std::string mesh = writeSlabs("golden.fmsh", 2);
+    const std::string caseFile = testFile("golden.cas");
+    if (!check(!golden.empty(), "cannot read fluentTestGolden.cas")) {
+        return false;
+    }
+    const char *const settings[][2] = {
+        { nullptr, nullptr },
+        { "Threads", "1" },
+        { "OutputMode", "stdio" },
+        { "OutputMode", "async" },
+        { "OutputMode", "mmap" },
+        { "OutputMode", "direct" },
+        { "BufferSize", "4096" },
+        { "PipelineCellTypes", "true" },
+        { "PipelineNodes", "true" },
+        { "ShadowMemory", "1" },
+    };
+    bool ret = true;
+    for (size_t i = 0; i < sizeof(settings) / sizeof(settings[0]); ++i) {
+        std::map<std::string, std::string> attrs;
+        std::string what = "default settings";
+        if (nullptr != settings[i][0]) {
+            attrs[settings[i][0]] = settings[i][1];
+            what = std::string(settings[i][0]) + "=" + settings[i][1];
+        }
+        ret = check(runExport(mesh, caseFile, attrs) &&
+            golden == caseText(readFile(caseFile)), what.c_str()) && ret;
+    }
+    return ret;
+}
+
+
+// The case file captured in a FluentMemorySink and the case file written to
+// an output descriptor, which stages each face zone in memory, are the bytes
+// of the case file written to the export file, where the zone headers are
+// patched in place
+static bool
+testMemorySink()
+{
+    const std::string mesh = writeBox("box.fmsh", 6, 5, 4);
+    const std::string caseFile = testFile("box.cas");
+    if (!check(runExport(mesh, caseFile), "file export")) {
+        return false;
+    }
+    const std::string fileText = caseText(readFile(caseFile));
+
+    FluentMemorySink memory;
+    fluentSetOutputSink(&memory);
+    const bool memoryOk = runExport(mesh, testFile("memory.cas"));
+    const std::string memoryText = caseText(std::string(memory.data(),
+        memory.size()));
+
+    const std::string fdFile = testFile("fd.cas");
+    const int fd = open(fdFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    bool fdOk = check(0 <= fd, "open the descriptor file");
+    if (fdOk) {
+        setenv("CAEUNSFLUENT_OUTPUT_FD", std::to_string(fd).c_str(), 1);
+        fdOk = runExport(mesh, testFile("unused.cas"));
+        unsetenv("CAEUNSFLUENT_OUTPUT_FD");
+        close(fd);
+    }
+    const std::string fdText = caseText(readFile(fdFile));
+
+    bool ret = check(memoryOk, "memory export");
+    ret = check(fdOk, "descriptor export") && ret;
+    ret = check(!fileText.empty(), "case file is empty") && ret;
+    ret = check(memoryText == fileText, "memory sink differs from the case "
+        "file") && ret;
+    return check(fdText == fileText, "descriptor output differs from the "
+        "case file") && ret;
+}
+
+
+// A direct I/O sink writes what a plain file gets: a flush writes the last,
+// partial block padded and truncates the padding off, and a patch of bytes
+// already on disk reads, changes and rewrites their blocks, here across a
+// block boundary into the buffer. A direct export, with a buffer of one or
+// two blocks so the zone headers are patched on disk, is the default export.
+static bool
+testDirectOutput()
+{
+    const size_t block = FluentDirectSink::Alignment;
+    const std::string file = testFile("direct.bin");
+    std::string expected(block, 'h');
+    FILE *fp = fopen(file.c_str(), "wb");
+    bool ret = check(nullptr != fp && block == fwrite(expected.data(), 1,
+        block, fp), "write the leading block");
+    if (nullptr != fp) {
+        fclose(fp);
+    }
+    FluentDirectSink sink;
+    if (!check(ret && sink.open(file.c_str(), block, block),
+            "open the direct sink")) {
+        return false;
+    }
+    std::string bytes;
+    for (size_t i = 0; i < 9000; ++i) {
+        bytes += char('a' + (i * 7) % 26);
+    }
+    ret = check(sink.write(bytes.data(), 1000) && sink.flush(), "write and "
+        "flush a partial block");
+    expected += bytes.substr(0, 1000);
+    ret = check(readFile(file) == expected, "flushed partial block") && ret;
+
+    // fills the partial block and 1904 bytes of the next one
+    ret = check(sink.write(bytes.data() + 1000, 5000), "write") && ret;
+    expected += bytes.substr(1000, 5000);
+    ret = check(sink.patch(100, "PATCHED", 7) &&
+        sink.patch(block - 6, "ACROSS THE BLOCKS", 17), "patch") && ret;
+    expected.replace(block + 100, 7, "PATCHED");
+    expected.replace(2 * block - 6, 17, "ACROSS THE BLOCKS");
+    ret = check(sink.write(bytes.data() + 6000, 3000) && sink.close(),
+        "write and close") && ret;
+    expected += bytes.substr(6000, 3000);
+    ret = check(readFile(file) == expected, "direct sink differs from the "
+        "bytes written") && ret;
+
+    const std::string mesh = writeSlabs("direct.fmsh", 8);
+    const std::string refFile = testFile("direct.ref.cas");
+    const std::string caseFile = testFile("direct.cas");
+    ret = check(runExport(mesh, refFile), "default export") && ret;
+    const std::string ref = caseText(readFile(refFile));
+    const char *const bufferSizes[] = { "4096", "5000" };
+    for (size_t i = 0; i < sizeof(bufferSizes) / sizeof(bufferSizes[0]); ++i) {
+        std::map<std::string, std::string> attrs;
+        attrs["OutputMode"] = "direct";
+        attrs["BufferSize"] = bufferSizes[i];
+        const std::string what = std::string("direct export, BufferSize=") +
+            bufferSizes[i];
+        ret = check(runExport(mesh, caseFile, attrs) &&
+            ref == caseText(readFile(caseFile)), what.c_str()) && ret;
+    }
+    return check(0 != ref.size() % block, "the case file ends on a block; "
+        "no partial block was written") && ret;
+}
+
+
+// An export to a full disk fails, whether the case file is written through
+// the export file in any output mode or through an output descriptor, which
+// stages each face zone in memory. Needs /dev/full (Linux).
+static bool
+testWriteFailure()
+{
+    if (0 != access("/dev/full", W_OK)) {
+        return true;
+    }
+    const std::string mesh = writeBox("full.fmsh", 6, 5, 4);
+    static const char *Modes[] = { "stdio", "buffered", "async" };
+    bool ret = true;
+    for (size_t i = 0; i < ARRAYSIZE(Modes); ++i) {
+        std::map<std::string, std::string> attrs;
+        attrs["OutputMode"] = Modes[i];
+        ret = check(!runExport(mesh, "/dev/full", attrs),
+            (std::string("export to a full disk in ") + Modes[i] +
+                " mode").c_str()) && ret;
+    }
+    const int fd = open("/dev/full", O_WRONLY);
+    if (!check(0 <= fd, "open /dev/full")) {
+        return false;
+    }
+    setenv("CAEUNSFLUENT_OUTPUT_FD", std::to_string(fd).c_str(), 1);
+    ret = check(!runExport(mesh, testFile("unused.cas")),
+        "export to a full output descriptor") && ret;
+    unsetenv("CAEUNSFLUENT_OUTPUT_FD");
+    close(fd);
+    return ret;
+}
+
+
+// Grids with fewer cells than parts, or than twice the parts, are
+// partitioned and the export finishes. Each cell zone gets a partition
+// section.
+static bool
+testSmallPartitions()
+{
+    struct Case {
+        PWP_UINT32  nx, ny, nz;
+        const char  *parts;
+    };
+    static const Case Cases[] = {
+        { 4, 1, 1, "3" }, { 4, 1, 1, "5" }, { 4, 1, 1, "7" },
+        { 2, 2, 2, "5" }, { 2, 2, 2, "7" }
+    };
+    bool ret = true;
+    for (size_t i = 0; i < ARRAYSIZE(Cases); ++i) {
+        const Case &c = Cases[i];
+        const std::string name = std::to_string(c.nx) + "x" +
+            std::to_string(c.ny) + "x" + std::to_string(c.nz) + " in " +
+            c.parts + " parts";
+        std::map<std::string, std::string> attrs;
+        attrs["PartitionCount"] = c.parts;
+        const std::string caseFile = testFile("parts.cas");
+        const bool ok = check(runExport(writeBox("parts.fmsh", c.nx, c.ny,
+            c.nz), caseFile, attrs), ("export of " + name).c_str());
+        ret = ok && check(std::string::npos != readFile(caseFile).find(
+            "\n(40 ("), ("partition section of " + name).c_str()) && ret;
+    }
+    return ret;
+}
+
+
+// The AutoTune write probe uses a scratch file of its own, so a file named
+// like it is left alone
+static bool
+testProbeScratch()
+{
+    const std::string mesh = writeBox("probe.fmsh", 2, 2, 2);
+    const std::string caseFile = testFile("probe.cas");
+    const std::string other = testFile("probe.cas.probe");
+    FILE *fp = fopen(other.c_str(), "wb");
+    if (!check(nullptr != fp, "create the file")) {
+        return false;
+    }
+    fputs("keep\n", fp);
+    fclose(fp);
+    std::map<std::string, std::string> attrs;
+    attrs["AutoTune"] = "true";
+    bool ret = check(runExport(mesh, caseFile, attrs), "export");
+    return check("keep\n" == readFile(other), "the file was overwritten") &&
+        ret;
+}
+
+
+// Names of the files in folder dir
+static std::vector<std::string>
+listFolder(const std::string &dir)
+{
+    std::vector<std::string> ret;
+    DIR *d = opendir(dir.c_str());
+    if (nullptr != d) {
+        struct dirent *e;
+        while (nullptr != (e = readdir(d))) {
+            if ('.' != e->d_name[0]) {
+                ret.push_back(e->d_name);
+            }
+        }
+        closedir(d);
+    }
+    return ret;
+}
+
+
+// A MeshCache export writes the mesh file and its zone record and leaves no
+// temporary files. A record that refers to a volume condition the grid does
+// not have is not used: the mesh file is written again.
+static bool
+testMeshCacheRecord()
+{
+    const std::string mesh = writeBox("cache.fmsh", 3, 3, 3);
+    const std::string caseFile = testFile("cache.cas");
+    // The export creates the missing folder and its missing parent
+    testFile("cache");
+    const std::string dir = testFile("cache/runs");
+    std::map<std::string, std::string> attrs;
+    attrs["MeshCache"] = dir;
+    bool ret = check(runExport(mesh, caseFile, attrs), "first export");
+    std::vector<std::string> names = listFolder(dir);
+    std::string record;
+    for (size_t i = 0; i < names.size(); ++i) {
+        testFile(("cache/runs/" + names[i]).c_str());
+        if (names[i].size() > 6 &&
+                0 == names[i].compare(names[i].size() - 6, 6, ".zones")) {
+            record = dir + "/" + names[i];
+        }
+    }
+    ret = check(2 == names.size() && !record.empty(),
+        "the cache holds more or less than a mesh file and its record") &&
+        ret;
+    const std::string text = readFile(record);
+    const size_t cell = text.find(" c ");
+    if (!check(std::string::npos != cell, "no cell zone in the record")) {
+        return false;
+    }
+    // Refer the first cell zone to a VC the grid does not have
+    const std::string bad = text.substr(0, cell) + " c 999" +
+        text.substr(text.find(' ', cell + 3));
+    FILE *fp = fopen(record.c_str(), "w");
+    if (!check(nullptr != fp, "rewrite the record")) {
+        return false;
+    }
+    fputs(bad.c_str(), fp);
+    fclose(fp);
+    const std::string first = caseText(readFile(caseFile));
+    ret = check(runExport(mesh, caseFile, attrs), "second export") && ret;
+    ret = check(first == caseText(readFile(caseFile)),
+        "the case files differ") && ret;
+    ret = check(text == readFile(record), "the record was not rewritten") &&
+        ret;
+    return check(2 == listFolder(dir).size(),
+        "temporary files were left in the cache") && ret;
+}
+
+
+// The face stream is not built after a quit signal: the face keys are not
+// generated and the sorts stop. Without one it holds every face of the box.
+static bool
+testQuitBuildFaces()
+{
+    const PWP_UINT32 n = 48;
+    const std::string mesh = writeBox("quit.fmsh", n, n, n);
+    Model.attributes.clear();
+    if (!check(!mesh.empty() && loadModel(Model, mesh.c_str()),
+            "load the mesh")) {
+        return false;
+    }
+    Model.threads = 4;
+    std::vector<StreamFace> faces;
+    PWGM_BEGINSTREAM_DATA counts;
+    memset(&counts, 0, sizeof(counts));
+    QuitSignal = 1;
+    bool ret = check(!buildFaces(Model, false, faces, counts) &&
+        faces.empty(), "the faces were built after a quit signal");
+    std::vector<PWP_UINT32> values(3 * SortSlice);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = PWP_UINT32(values.size() - i);
+    }
+    ret = check(!parallelSort(values, 4, std::less<PWP_UINT32>()) &&
+        values.front() > values.back(), "the sort ran after a quit signal") &&
+        ret;
+    QuitSignal = 0;
+    ret = check(buildFaces(Model, false, faces, counts) &&
+        3 * n * n * (n + 1) == faces.size(), "the faces of the box") && ret;
+    return check(parallelSort(values, 4, std::less<PWP_UINT32>()) &&
+        std::is_sorted(values.begin(), values.end()), "the sort") && ret;
+}
+
+
+// A checkpointed export stopped by a quit signal keeps its part file and
+// checkpoint record, and the next export resumes from the record. The bytes
+// the part file holds past the checkpoint, and any junk after them, are cut
+// off. To tell a resume from a restart, the time stamp in the checkpointed
+// bytes is changed and the record's digest updated: only a resume keeps it.
+static bool
+testCheckpointResume()
+{
+    const std::string mesh = writeSlabs("ckpt.fmsh", 24);
+    const std::string refFile = testFile("ckpt.ref.cas");
+    const std::string caseFile = testFile("ckpt.cas");
+    const std::string partFile = testFile("ckpt.cas.part");
+    const std::string recordFile = testFile("ckpt.cas.ckpt");
+    if (!check(runExport(mesh, refFile), "export without a checkpoint")) {
+        return false;
+    }
+    const std::string ref = readFile(refFile);
+    std::map<std::string, std::string> attrs;
+    attrs["Checkpoint"] = "1";
+
+    // Quit once a face zone boundary was checkpointed
+    std::atomic<bool> done(false);
+    std::thread quit([&]() {
+        FluentCheckpoint rec;
+        while (!done && !(rec.read(recordFile.c_str()) && 0 != rec.ordinal)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        QuitSignal = 1;
+    });
+    const bool stopped = !runExport(mesh, caseFile, attrs);
+    done = true;
+    quit.join();
+    QuitSignal = 0;
+    FluentCheckpoint rec;
+    bool ret = check(stopped, "the export ended before the quit");
+    if (!check(rec.read(recordFile.c_str()) && 0 != rec.ordinal &&
+            rec.length < ref.size(), "no face checkpoint")) {
+        return false;
+    }
+    std::string part = readFile(partFile);
+    ret = check(part.size() > rec.length,
+        "nothing was written past the checkpoint") && ret;
+
+    // Mark the time stamp, fix the digest and add junk past the checkpoint
+    part.resize(size_t(rec.length));
+    const size_t stamp = part.find('\n') + 4;
+    part[stamp] = 'X';
+    part += "junk past the checkpoint";
+    FILE *fp = fopen(partFile.c_str(), "wb");
+    ret = check(nullptr != fp && part.size() == fwrite(part.data(), 1,
+        part.size(), fp), "rewrite the part file") && ret;
+    if (nullptr != fp) {
+        fclose(fp);
+    }
+    FluentChunkHash hash;
+    ret = check(fluentHashFile(partFile.c_str(), rec.length, 1, hash),
+        "hash the part file") && ret;
+    rec.digest = hash.digest();
+    ret = check(rec.write(recordFile.c_str()), "rewrite the record") && ret;
+
+    ret = check(runExport(mesh, caseFile, attrs), "resumed export") && ret;
+    const std::string text = readFile(caseFile);
+    ret = check(text.size() > stamp && 'X' == text[stamp],
+        "the export started over") && ret;
+    ret = check(caseText(ref) == caseText(text),
+        "the resumed case file differs") && ret;
+    return check(readFile(partFile).empty() && readFile(recordFile).empty(),
+        "the part file or the record was left") && ret;
+}
+
+
+// Each entry of a SectionIndex file is at the start of its node, cell, face
+// or partition section, "(<id> (<zone> <first> <last> ", and its length ends
+// the section. The entries are in file order and each zone section of the
+// case file has one.
+static bool
+testSectionIndex()
+{
+    const std::string mesh = writeSlabs("index.fmsh", 3);
+    const std::string caseFile = testFile("index.cas");
+    const std::string indexFile = testFile("index.cas.idx");
+    std::map<std::string, std::string> attrs;
+    attrs["SectionIndex"] = "true";
+    attrs["PartitionCount"] = "2";
+    if (!check(runExport(mesh, caseFile, attrs), "export")) {
+        return false;
+    }
+    const std::string text = readFile(caseFile);
+    std::istringstream index(readFile(indexFile));
+    std::string line;
+    size_t entries = 0;
+    PWP_UINT64 end = 0;
+    bool ret = true;
+    while (std::getline(index, line)) {
+        if ('#' == line[0]) {
+            continue;
+        }
+        unsigned zone, section, first, last;
+        unsigned long long offset, length;
+        if (!check(6 == sscanf(line.c_str(), "%u %u %u %u %llu %llu", &zone,
+                &section, &first, &last, &offset, &length), line.c_str())) {
+            return false;
+        }
+        ++entries;
+        char start[64];
+        snprintf(start, sizeof(start), "(%u (%x %x %x ", section, zone,
+            first, last);
+        const std::string what = "entry " + line;
+        ret = check(offset >= end && offset + length <= text.size() &&
+            0 == text.compare(size_t(offset), strlen(start), start) &&
+            0 == text.compare(size_t(offset + length) - 3, 3, "))\n"),
+            what.c_str()) && ret;
+        end = offset + length;
+    }
+
+    // Zone sections; the declarations are of zone 0
+    size_t sections = 0;
+    const char *const ids[] = { "\n(10 (", "\n(12 (", "\n(13 (", "\n(40 (" };
+    for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+        for (size_t at = text.find(ids[i]); std::string::npos != at;
+                at = text.find(ids[i], at + 1)) {
+            sections += ('0' != text[at + strlen(ids[i])]) ? 1 : 0;
+        }
+    }
+    return check(0 != entries && sections == entries, "the index does not "
+        "have an entry for each zone section") && ret;
+}
+
+
+// The faces of the face zones of case file text, each as its zone name and
+// the coordinates of its nodes, sorted. Sets nodes to the coordinates of the
+// nodes, in order, and cellsZero to whether no face has a cell.
+static std::vector<std::string>
+zoneFaces(const std::string &text, std::vector<std::string> &nodes,
+    bool &cellsZero)
+{
+    std::map<PWP_UINT64, std::string> names;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        // The zone of a zone section is decimal
+        unsigned zone = 0;
+        char name[64];
+        if (2 == sscanf(line.c_str(), "(45 (%u %*s %63[^)])", &zone, name)) {
+            names[zone] = name;
+        }
+    }
+    const std::vector<TextSection> sections = textSections(text);
+    std::vector<std::string> ret;
+    nodes.clear();
+    cellsZero = true;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        const TextSection &s = sections[i];
+        if (FLUENT_NODES == s.id && s.header.size() == 5) {
+            const size_t dim = size_t(s.header[4]);
+            for (size_t w = 0; w + dim <= s.body.size(); w += dim) {
+                std::string coords;
+                for (size_t d = 0; d < dim; ++d) {
+                    coords += s.body[w + d] + " ";
+                }
+                nodes.push_back(coords);
+            }
+        }
+        if (FLUENT_FACES != s.id || s.header.size() != 5) {
+            continue;
+        }
+        for (size_t w = 0; w < s.body.size();) {
+            size_t cnt = size_t(s.header[4]);
+            if (0 == cnt) {
+                cnt = size_t(strtoul(s.body[w++].c_str(), nullptr, 16));
+            }
+            std::string face = names[s.header[0]] + ":";
+            for (size_t v = 0; v < cnt && w < s.body.size(); ++v, ++w) {
+                const size_t node = strtoul(s.body[w].c_str(), nullptr, 16);
+                face += "|" + ((node - 1 < nodes.size()) ?
+                    nodes[node - 1] : std::string("?"));
+            }
+            for (int c = 0; c < 2 && w < s.body.size(); ++c, ++w) {
+                cellsZero = cellsZero && ("0" == s.body[w]);
+            }
+            ret.push_back(face);
+        }
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+
+// A BoundaryOnly export writes the boundary and shadow faces of the full
+// export, with the same nodes, and no cells or interior faces. Its nodes are
+// the nodes these faces use, each once, in the order of the full export:
+// the faces are the same when their nodes are read by coordinates.
+static bool
+testBoundaryOnly()
+{
+    const std::string mesh = writeSlabs("surface.fmsh", 3);
+    const std::string fullFile = testFile("full.cas");
+    const std::string caseFile = testFile("surface.cas");
+    std::map<std::string, std::string> attrs;
+    attrs["BoundaryOnly"] = "true";
+    if (!check(runExport(mesh, fullFile), "full export") ||
+            !check(runExport(mesh, caseFile, attrs), "boundary only export")) {
+        return false;
+    }
+    std::vector<std::string> fullNodes;
+    bool fullCellsZero;
+    std::vector<std::string> full = zoneFaces(readFile(fullFile), fullNodes,
+        fullCellsZero);
+    full.erase(std::remove_if(full.begin(), full.end(),
+        [](const std::string &face) {
+            return 0 == face.compare(0, 9, "interior-");
+        }), full.end());
+    std::vector<std::string> nodes;
+    bool cellsZero;
+    const std::string text = readFile(caseFile);
+    const std::vector<std::string> faces = zoneFaces(text, nodes, cellsZero);
+
+    bool ret = check(!faces.empty() && faces == full, "the faces differ from "
+        "the boundary faces of the full export");
+    ret = check(cellsZero, "a face has a cell") && ret;
+    const std::vector<TextSection> sections = textSections(text);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        ret = check(FLUENT_CELLS != sections[i].id, "a cell zone was "
+            "written") && ret;
+    }
+
+    // Every node is used, and the nodes keep the order of the full export
+    std::set<std::string> used;
+    for (size_t i = 0; i < faces.size(); ++i) {
+        for (size_t at = faces[i].find('|'); std::string::npos != at;
+                at = faces[i].find('|', at + 1)) {
+            used.insert(faces[i].substr(at + 1,
+                faces[i].find('|', at + 1) - at - 1));
+        }
+    }
+    size_t next = 0;
+    for (size_t i = 0; i < fullNodes.size() && next < nodes.size(); ++i) {
+        next += (fullNodes[i] == nodes[next]) ? 1 : 0;
+    }
+    ret = check(used.size() == nodes.size(), "a node is not used by a "
+        "face") && ret;
+    return check(next == nodes.size(), "the nodes are not the full export's "
+        "nodes in order") && ret;
+}
+
+
+// A MergeBCZones export writes one face zone for each boundary condition,
+// named after it: the faces of the three domains of one wall condition are
+// one zone, those of another wall condition a zone of their own. Across
+// blocks of different cell types and for shadow faces, the merged zones hold
+// the faces of the zones of the same condition of the unmerged export.
+static bool
+testMergeBCZones()
+{
+    FluentMeshWriter w(3);
+    for (PWP_UINT32 k = 0; k < 2; ++k) {
+        for (PWP_UINT32 j = 0; j < 2; ++j) {
+            for (PWP_UINT32 i = 0; i < 3; ++i) {
+                w.addVertex(0.1 * i, 0.1 * j, 0.1 * k);
+            }
+        }
+    }
+    const PWP_UINT32 fluid = w.addBlock("fluid", 1, "Fluid", 1);
+    const PWP_UINT32 hex0[8] = { 0, 1, 4, 3, 6, 7, 10, 9 };
+    const PWP_UINT32 hex1[8] = { 1, 2, 5, 4, 7, 8, 11, 10 };
+    w.addBlockElement(fluid, FluentMeshFile::Hex, hex0);
+    w.addBlockElement(fluid, FluentMeshFile::Hex, hex1);
+    const PWP_UINT32 quads[][4] = {
+        { 0, 3, 9, 6 }, { 2, 5, 11, 8 },
+        { 0, 1, 7, 6 }, { 1, 2, 8, 7 },
+        { 3, 4, 10, 9 }, { 4, 5, 11, 10 },
+        { 0, 1, 4, 3 }, { 1, 2, 5, 4 },
+        { 6, 7, 10, 9 }, { 7, 8, 11, 10 },
+    };
+    const PWP_UINT32 domains[] = {
+        w.addDomain("inlet", 10, "Pressure Inlet", 4),
+        w.addDomain("outlet", 11, "Pressure Outlet", 5),
+        w.addDomain("walls", 12, "Wall", 3),
+        w.addDomain("walls", 12, "Wall", 3),
+        w.addDomain("walls", 12, "Wall", 3),
+        w.addDomain("lid", 13, "Wall", 3),
+    };
+    for (size_t q = 0; q < sizeof(quads) / sizeof(quads[0]); ++q) {
+        w.addDomainElement(domains[(q + 2) / 2], FluentMeshFile::Quad,
+            quads[q]);
+    }
+    const std::string box = testFile("merge.fmsh");
+    if (!check(w.write(box.c_str()), "write the mesh")) {
+        return false;
+    }
+    const std::string meshes[] = { box, writeSlabs("mergeSlabs.fmsh", 2) };
+    const std::string caseFile = testFile("merge.cas");
+    std::map<std::string, std::string> attrs;
+    attrs["MergeBCZones"] = "true";
+    bool ret = true;
+    for (size_t m = 0; m < 2; ++m) {
+        std::vector<std::string> nodes;
+        bool cellsZero;
+        const bool unmergedOk = runExport(meshes[m], caseFile);
+        const std::string unmergedText = readFile(caseFile);
+        const std::vector<std::string> unmerged = zoneFaces(unmergedText,
+            nodes, cellsZero);
+        const bool mergedOk = runExport(meshes[m], caseFile, attrs);
+        const std::string text = readFile(caseFile);
+        const std::vector<std::string> merged = zoneFaces(text, nodes,
+            cellsZero);
+        std::map<std::string, size_t> zones;
+        std::istringstream lines(text);
+        std::string line;
+        while (std::getline(lines, line)) {
+            char name[64];
+            if (1 == sscanf(line.c_str(), "(45 (%*u %*s %63[^)])", name)) {
+                ++zones[name];
+            }
+        }
+        const std::string grid = (0 == m) ? "box: " : "slabs: ";
+        ret = check(unmergedOk && mergedOk, (grid + "export").c_str()) && ret;
+        ret = check(!merged.empty() && merged == unmerged,
+            (grid + "the merged zones have other faces").c_str()) && ret;
+        for (auto z = zones.begin(); z != zones.end(); ++z) {
+            ret = check(1 == z->second, (grid + "more than one zone " +
+                z->first).c_str()) && ret;
+        }
+        if (0 == m) {
+            ret = check(5 == zones.size() && 1 == zones.count("walls") &&
+                1 == zones.count("lid") && 1 == zones.count("interior-fluid"),
+                "box: the zones are not one per condition") && ret;
+            ret = check(std::string::npos != unmergedText.find(
+                "(45 (6 wall walls)") && std::string::npos !=
+                unmergedText.find("(45 (7 wall walls)"),
+                "box: the unmerged export has one walls zone") && ret;
+        }
+    }
+    return ret;
+}
+
+
+// A single precision export writes each coordinate as the float nearest the
+// double of the double precision export, in 16 characters with its
+// separator. The rest of the case file is the same. The node writer of
+// PipelineNodes skips the node section by that width and an exact DryRun
+// counts it, so they must agree with the coordinates written.
+static bool
+testSinglePrecision()
+{
+    const std::string mesh = writeSlabs("single.fmsh", 4);
+    const std::string doubleFile = testFile("double.cas");
+    const std::string caseFile = testFile("single.cas");
+    bool ret = check(runExport(mesh, doubleFile), "double precision export");
+    ret = check(runExport(mesh, caseFile, std::map<std::string,
+        std::string>(), PWP_PRECISION_SINGLE), "single precision export") &&
+        ret;
+    const std::string text = readFile(caseFile);
+    const std::string doubleText = readFile(doubleFile);
+    const size_t begin = text.find("\n(10 (1 ");
+    const size_t end = text.find("\n))", begin);
+    const size_t doubleBegin = doubleText.find("\n(10 (1 ");
+    const size_t doubleEnd = doubleText.find("\n))", doubleBegin);
+    if (!check(ret && std::string::npos != end &&
+            std::string::npos != doubleEnd, "no node section")) {
+        return false;
+    }
+    ret = check(caseText(text.substr(0, begin)) ==
+        caseText(doubleText.substr(0, doubleBegin)) &&
+        text.substr(end) == doubleText.substr(doubleEnd),
+        "the case file differs outside of the node section") && ret;
+
+    std::istringstream lines(text.substr(begin + 1, end - begin));
+    std::istringstream doubleLines(doubleText.substr(doubleBegin + 1,
+        doubleEnd - doubleBegin));
+    std::string line;
+    std::string doubleLine;
+    std::getline(lines, line);
+    std::getline(doubleLines, doubleLine);
+    size_t nodes = 0;
+    bool widths = true;
+    bool values = true;
+    while (std::getline(lines, line) && std::getline(doubleLines,
+            doubleLine)) {
+        ++nodes;
+        widths = widths && (3 * 16 == line.size() + 1);
+        std::istringstream words(line);
+        std::istringstream doubleWords(doubleLine);
+        std::string word;
+        std::string doubleWord;
+        while (words >> word && doubleWords >> doubleWord) {
+            values = values && (strtof(word.c_str(), nullptr) ==
+                float(strtod(doubleWord.c_str(), nullptr)));
+        }
+    }
+    ret = check(0 != nodes && std::getline(lines, line).eof() &&
+        std::getline(doubleLines, doubleLine).eof(), "the node counts "
+        "differ") && ret;
+    ret = check(widths, "a node line is not 3 * 16 characters") && ret;
+    ret = check(values, "a coordinate is not the nearest float") && ret;
+
+    std::map<std::string, std::string> attrs;
+    attrs["PipelineNodes"] = "true";
+    ret = check(runExport(mesh, caseFile, attrs, PWP_PRECISION_SINGLE) &&
+        caseText(readFile(caseFile)) == caseText(text), "PipelineNodes "
+        "differs") && ret;
+    attrs.clear();
+    attrs["DryRun"] = "count";
+    const std::string sizeFile = testFile("single.cas.size.txt");
+    unsigned long long size = 0;
+    ret = check(runExport(mesh, caseFile, attrs, PWP_PRECISION_SINGLE) &&
+        1 == sscanf(readFile(sizeFile).c_str(), "Case file size (exact) : "
+        "%llu", &size) && size == text.size(), "the DryRun count differs") &&
+        ret;
+    return ret;
+}
+
+
+// The boundary faces of a grid that are not on a domain are written as a
+// wall zone of the unspecified BC
+static bool
+testBareBoundaryFaces()
+{
+    FluentMeshWriter w(3);
+    for (PWP_UINT32 k = 0; k < 2; ++k) {
+        for (PWP_UINT32 j = 0; j < 2; ++j) {
+            for (PWP_UINT32 i = 0; i < 3; ++i) {
+                w.addVertex(0.1 * i, 0.1 * j, 0.1 * k);
+            }
+        }
+    }
+    const PWP_UINT32 fluid = w.addBlock("fluid", 1, "Fluid", 1);
+    const PWP_UINT32 hex0[8] = { 0, 1, 4, 3, 6, 7, 10, 9 };
+    const PWP_UINT32 hex1[8] = { 1, 2, 5, 4, 7, 8, 11, 10 };
+    w.addBlockElement(fluid, FluentMeshFile::Hex, hex0);
+    w.addBlockElement(fluid, FluentMeshFile::Hex, hex1);
+    const PWP_UINT32 inlet = w.addDomain("inlet", 10, "Pressure Inlet", 4);
+    const PWP_UINT32 quad[4] = { 0, 3, 9, 6 };
+    w.addDomainElement(inlet, FluentMeshFile::Quad, quad);
+    const std::string mesh = testFile("bare.fmsh");
+    const std::string caseFile = testFile("bare.cas");
+    if (!check(w.write(mesh.c_str()), "write the mesh")) {
+        return false;
+    }
+    bool ret = check(runExport(mesh, caseFile), "export");
+    const std::string text = readFile(caseFile);
+    ret = check(std::string::npos != text.find("BC: Unspecified wall = 3"),
+        "no unspecified wall zone") && ret;
+    return check(std::string::npos != text.find(" wall unspecified)"),
+        "no unspecified wall zone section") && ret;
+}
+
+
+// Sets span to the time span of the trace events named name in the trace
+// file text, in milliseconds since the trace began. Returns false if there
+// is no such event.
+struct TraceSpan {
+    double  begin;
+    double  end;
+};
+
+static bool
+traceSpan(const std::string &text, const char *name, TraceSpan &span)
+{
+    const std::string key = std::string("{\"name\":\"") + name + "\"";
+    bool found = false;
+    for (size_t pos = text.find(key); std::string::npos != pos;
+            pos = text.find(key, pos + 1)) {
+        const size_t ts = text.find("\"ts\":", pos);
+        const size_t dur = text.find("\"dur\":", pos);
+        if (std::string::npos == ts || std::string::npos == dur) {
+            break;
+        }
+        const double begin = strtod(text.c_str() + ts + 5, nullptr) / 1000.0;
+        const double end = begin +
+            strtod(text.c_str() + dur + 6, nullptr) / 1000.0;
+        span.begin = found ? std::min(span.begin, begin) : begin;
+        span.end = found ? std::max(span.end, end) : end;
+        found = true;
+    }
+    return found;
+}
+
+
+// Milliseconds an export may take to stop after a quit signal. The export
+// polls for an abort every 50 ms.
+static const double AbortLatencyMs = 500.0;
+
+// An export of a large grid stops within AbortLatencyMs of a quit signal in
+// every phase and leaves an empty case file. A first export with a trace
+// gives the span of each phase; each later export is quit halfway through
+// one of them.
+static bool
+testAbortLatency()
+{
+    typedef std::chrono::steady_clock Clock;
+    const std::string mesh = writeSlabs("abort.fmsh", 56);
+    const std::string caseFile = testFile("abort.cas");
+    const std::string traceFile = testFile("abort.cas.trace.json");
+    Model.attributes.clear();
+    Model.attributes["PartitionCount"] = "16";
+    Model.attributes["ShadowMemory"] = "1";
+    Model.attributes["MergeBCZones"] = "true";
+    Model.attributes["TraceEvents"] = "true";
+    if (!check(!mesh.empty() && checkAttributes(Model) &&
+            loadModel(Model, mesh.c_str()), "load the mesh")) {
+        return false;
+    }
+    Model.threads = streamThreads(Rti.model);
+    if (!check(0 == exportModel(Rti, caseFile.c_str(), PWP_PRECISION_DOUBLE),
+            "export with a trace")) {
+        return false;
+    }
+    Model.attributes.erase("TraceEvents");
+    const std::string trace = readFile(traceFile);
+
+    // The batch converter builds the face stream before beginCB()
+    TraceSpan all;
+    TraceSpan begin;
+    bool ret = check(traceSpan(trace, "runtimeWrite", all) &&
+        traceSpan(trace, "beginCB", begin), "no export span in the trace");
+    struct Phase {
+        const char  *name;
+        TraceSpan   span;
+    };
+    std::vector<Phase> phases;
+    const Phase stream = { "buildFaces", { all.begin, begin.begin } };
+    phases.push_back(stream);
+    const char *const names[] = { "writeVerts", "processBlockVCMap",
+        "writeVCZone", "faceBatch", "sortShadowFaces", "mergeShadowFaces",
+        "partition" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        Phase p = { names[i], { 0.0, 0.0 } };
+        if (check(traceSpan(trace, names[i], p.span), names[i])) {
+            phases.push_back(p);
+        }
+        else {
+            ret = false;
+        }
+    }
+
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const Phase &p = phases[i];
+        const Clock::time_point start = Clock::now();
+        const Clock::time_point quitAt = start +
+            std::chrono::microseconds(long(500.0 * (p.span.begin +
+                p.span.end)));
+        std::atomic<bool> done(false);
+        std::thread quit([&]() {
+            while (!done && Clock::now() < quitAt) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            if (!done) {
+                QuitSignal = 1;
+            }
+        });
+        const int rc = exportModel(Rti, caseFile.c_str(),
+            PWP_PRECISION_DOUBLE);
+        const Clock::time_point end = Clock::now();
+        done = true;
+        quit.join();
+        const bool quitted = (0 != QuitSignal);
+        QuitSignal = 0;
+        const double ms = std::chrono::duration<double, std::milli>(end -
+            quitAt).count();
+        char what[128];
+        snprintf(what, sizeof(what), "%s: the export ended before the quit",
+            p.name);
+        if (!check(quitted, what)) {
+            ret = false;
+            continue;
+        }
+        snprintf(what, sizeof(what), "%s: stopped %.0f ms after the quit",
+            p.name, ms);
+        ret = check(0 != rc && ms < AbortLatencyMs, what) && ret;
+        snprintf(what, sizeof(what), "%s: the case file is not empty",
+            p.name);
+        ret = check(readFile(caseFile).empty(), what) && ret;
+    }
+    return ret;
+}
+
+
+// XXH64 of the len bytes at p with seed 0, written from the xxHash
+// specification and independent of FluentXxh64
+static PWP_UINT64
+xxh64(const unsigned char *p, size_t len)
+{
+    const PWP_UINT64 p1 = 0x9E3779B185EBCA87ULL;
+    const PWP_UINT64 p2 = 0xC2B2AE3D27D4EB4FULL;
+    const PWP_UINT64 p3 = 0x165667B19E3779F9ULL;
+    const PWP_UINT64 p4 = 0x85EBCA77C2B2AE63ULL;
+    const PWP_UINT64 p5 = 0x27D4EB2F165667C5ULL;
+    struct Op {
+        static PWP_UINT64 rotl(PWP_UINT64 x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+        static PWP_UINT64 le(const unsigned char *b, int n)
+        {
+            PWP_UINT64 v = 0;
+            for (int i = n - 1; i >= 0; --i) {
+                v = (v << 8) | b[i];
+            }
+            return v;
+        }
+        static PWP_UINT64 round(PWP_UINT64 acc, PWP_UINT64 lane)
+        {
+            return rotl(acc + lane * 0xC2B2AE3D27D4EB4FULL, 31) *
+                0x9E3779B185EBCA87ULL;
+        }
+    };
+    const unsigned char *const end = p + len;
+    PWP_UINT64 h;
+    if (len >= 32) {
+        PWP_UINT64 acc[4] = { p1 + p2, p2, 0, 0 - p1 };
+        for (; end - p >= 32; p += 32) {
+            for (int i = 0; i < 4; ++i) {
+                acc[i] = Op::round(acc[i], Op::le(p + 8 * i, 8));
+            }
+        }
+        h = Op::rotl(acc[0], 1) + Op::rotl(acc[1], 7) + Op::rotl(acc[2], 12) +
+            Op::rotl(acc[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            h = (h ^ Op::round(0, acc[i])) * p1 + p4;
+        }
+    }
+    else {
+        h = p5;
+    }
+    h += len;
+    for (; end - p >= 8; p += 8) {
+        h = Op::rotl(h ^ Op::round(0, Op::le(p, 8)), 27) * p1 + p4;
+    }
+    if (end - p >= 4) {
+        h = Op::rotl(h ^ (Op::le(p, 4) * p1), 23) * p2 + p3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h = Op::rotl(h ^ (*p * p5), 11) * p1;
+    }
+    h = (h ^ (h >> 33)) * p2;
+    h = (h ^ (h >> 29)) * p3;
+    return h ^ (h >> 32);
+}
+
+
+// The ContentHash digest of text: the XXH64 of the XXH64 digests of its
+// 1 MiB chunks and its length, each as 8 little endian bytes
+static PWP_UINT64
+contentDigest(const std::string &text)
+{
+    const size_t chunk = 1024 * 1024;
+    std::vector<PWP_UINT64> values;
+    for (size_t at = 0; at < text.size(); at += chunk) {
+        values.push_back(xxh64(reinterpret_cast<const unsigned char*>(
+            &text[at]), std::min(chunk, text.size() - at)));
+    }
+    values.push_back(text.size());
+    std::string digests;
+    for (size_t v = 0; v < values.size(); ++v) {
+        for (int i = 0; i < 8; ++i) {
+            digests += char(values[v] >> (8 * i));
+        }
+    }
+    return xxh64(reinterpret_cast<const unsigned char*>(digests.data()),
+        digests.size());
+}
+
+
+// The ContentHash digests appended to a case file are the digests of its
+// bytes, recomputed here by an XXH64 written from the specification: the
+// file digest covers the bytes before the comments, and the sections, each
+// of its own digest, follow each other from the start to those bytes. The
+// grid has node and face sections of more than one chunk, and the face zone
+// headers are patched in place or, with the stdio OutputMode, staged.
+static bool
+testContentHash()
+{
+    const char *const vectors[][2] = {
+        { "", "ef46db3751d8e999" },
+        { "a", "d24ec4f1a98c6e5b" },
+        { "abc", "44bc2cf5ad770999" },
+        { "Nobody inspects the spammish repetition", "fbcea83c8a378bf1" },
+    };
+    bool ret = true;
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i) {
+        const std::string what = std::string("XXH64 of \"") + vectors[i][0] +
+            "\"";
+        ret = check(strtoull(vectors[i][1], nullptr, 16) == xxh64(
+            reinterpret_cast<const unsigned char*>(vectors[i][0]),
+            strlen(vectors[i][0])), what.c_str()) && ret;
+    }
+
+    const std::string mesh = writeSlabs("hash.fmsh", 20);
+    const std::string caseFile = testFile("hash.cas");
+    testFile("hash.cas.stats.txt");
+    const char *const modes[] = { "buffered", "stdio" };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+        std::map<std::string, std::string> attrs;
+        attrs["ContentHash"] = "true";
+        attrs["OutputMode"] = modes[m];
+        if (!check(runExport(mesh, caseFile, attrs), modes[m])) {
+            ret = false;
+            continue;
+        }
+        const std::string text = readFile(caseFile);
+        const size_t comments = text.find("\n(0 \"Content hash ");
+        unsigned long long digest = 0;
+        unsigned long long length = 0;
+        if (!check(std::string::npos != comments && 2 == sscanf(
+                text.c_str() + comments, "\n(0 \"Content hash %llx of %llu",
+                &digest, &length), "no content hash")) {
+            ret = false;
+            continue;
+        }
+        std::string what = std::string(modes[m]) + ": file digest";
+        ret = check(comments == length &&
+            digest == contentDigest(text.substr(0, comments)),
+            what.c_str()) && ret;
+
+        std::istringstream lines(text.substr(comments + 1));
+        std::string line;
+        std::getline(lines, line);
+        PWP_UINT64 end = 0;
+        size_t large = 0;
+        while (std::getline(lines, line)) {
+            const size_t at = line.find(" at ");
+            unsigned long long offset = 0;
+            what = std::string(modes[m]) + ": " + line;
+            if (!check(std::string::npos != at && at >= 16 && 2 == sscanf(
+                    line.c_str() + at, " at %llu, %llu", &offset, &length),
+                    what.c_str())) {
+                ret = false;
+                break;
+            }
+            digest = strtoull(line.substr(at - 16, 16).c_str(), nullptr, 16);
+            ret = check(offset == end && offset + length <= comments &&
+                digest == contentDigest(text.substr(size_t(offset),
+                size_t(length))), what.c_str()) && ret;
+            end = offset + length;
+            large += (length > 1024 * 1024) ? 1 : 0;
+        }
+        what = std::string(modes[m]) + ": the sections do not cover the file";
+        ret = check(comments == end, what.c_str()) && ret;
+        what = std::string(modes[m]) + ": no section of more than a chunk";
+        ret = check(0 != large, what.c_str()) && ret;
+    }
+    return ret;
+}
+
+
+#if defined(CAEUNSFLUENT_HAVE_ZLIB)
+
+// Inflates the gzip file path into out. False unless it is one gzip member.
+static bool
+gunzipOne(const std::string &path, std::string &out)
+{
+    std::string in = readFile(path);
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if (in.empty() || Z_OK != inflateInit2(&z, 16 + MAX_WBITS)) {
+        return false;
+    }
+    z.next_in = reinterpret_cast<Bytef*>(&in[0]);
+    z.avail_in = uInt(in.size());
+    out.clear();
+    int rc = Z_OK;
+    while (Z_OK == rc) {
+        char buf[65536];
+        z.next_out = reinterpret_cast<Bytef*>(buf);
+        z.avail_out = uInt(sizeof(buf));
+        rc = inflate(&z, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - z.avail_out);
+    }
+    const uInt left = z.avail_in;
+    inflateEnd(&z);
+    return Z_STREAM_END == rc && 0 == left;
+}
+
+
+// A FluentGzipSink flushed in the middle of the stream and a gzip compressed
+// OutputCopies copy are one gzip member that holds the bytes written
+static bool
+testGzipCopy()
+{
+    const std::string flushed = testFile("flushed.gz");
+    gzFile gz = gzopen(flushed.c_str(), "wb1");
+    if (!check(nullptr != gz, "gzopen")) {
+        return false;
+    }
+    FluentGzipSink sink(gz);
+    bool ret = check(sink.print("first\n") && sink.flush() &&
+        sink.print("second\n") && sink.flush() && sink.close(),
+        "write the flushed file");
+    std::string text;
+    ret = check(gunzipOne(flushed, text), "the flushed file is not one gzip "
+        "member") && ret;
+    ret = check("first\nsecond\n" == text, "the flushed file differs") &&
+        ret;
+
+    const std::string mesh = writeBox("gz.fmsh", 6, 5, 4);
+    const std::string caseFile = testFile("gz.cas");
+    const std::string copy = testFile("gz.copy.cas.gz");
+    std::map<std::string, std::string> attrs;
+    attrs["OutputCopies"] = copy;
+    if (!check(runExport(mesh, caseFile, attrs), "export")) {
+        return false;
+    }
+    ret = check(gunzipOne(copy, text), "the copy is not one gzip member") &&
+        ret;
+    return check(readFile(caseFile) == text,
+        "the copy differs from the case file") && ret;
+}
+
+#endif // CAEUNSFLUENT_HAVE_ZLIB
+
+
+#if defined(CAEUNSFLUENT_HAVE_HDF5)
+
+// Values of the dataset at path of file, converted to memType. Empty if the
+// dataset cannot be read.
+template<typename T>
+static std::vector<T>
+readDataset(hid_t file, const std::string &path, hid_t memType)
+{
+    std::vector<T> ret;
+    hid_t dset = H5Dopen2(file, path.c_str(), H5P_DEFAULT);
+    if (dset < 0) {
+        return ret;
+    }
+    hid_t space = H5Dget_space(dset);
+    ret.resize(size_t(std::max<hssize_t>(0,
+        H5Sget_simple_extent_npoints(space))));
+    if (!ret.empty() && H5Dread(dset, memType, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+            ret.data()) < 0) {
+        ret.clear();
+    }
+    H5Sclose(space);
+    H5Dclose(dset);
+    return ret;
+}
+
+
+// The one element integer attribute name of the object at path of file.
+// ~0 if there is no such attribute.
+static PWP_UINT64
+readAttr(hid_t file, const std::string &path, const char *name)
+{
+    PWP_UINT64 ret = ~PWP_UINT64(0);
+    if (0 < H5Aexists_by_name(file, path.c_str(), name, H5P_DEFAULT)) {
+        hid_t attr = H5Aopen_by_name(file, path.c_str(), name, H5P_DEFAULT,
+            H5P_DEFAULT);
+        hid_t space = H5Aget_space(attr);
+        if (1 != H5Sget_simple_extent_npoints(space) ||
+                H5Aread(attr, H5T_NATIVE_UINT64, &ret) < 0) {
+            ret = ~PWP_UINT64(0);
+        }
+        H5Sclose(space);
+        H5Aclose(attr);
+    }
+    return ret;
+}
+
+
+// The one element string attribute name of the object at path of file
+static std::string
+readNameAttr(hid_t file, const std::string &path)
+{
+    std::string ret;
+    if (0 < H5Aexists_by_name(file, path.c_str(), "name", H5P_DEFAULT)) {
+        hid_t attr = H5Aopen_by_name(file, path.c_str(), "name",
+            H5P_DEFAULT, H5P_DEFAULT);
+        hid_t type = H5Aget_type(attr);
+        std::vector<char> buf(H5Tget_size(type) + 1, '\0');
+        if (H5Aread(attr, type, buf.data()) >= 0) {
+            ret = buf.data();
+        }
+        H5Tclose(type);
+        H5Aclose(attr);
+    }
+    return ret;
+}
+
+
+// The HDF5 case file of a CaseFormat both export holds the nodes, cells and
+// faces of the text case file of the same pass in the layout described in
+// fluentCff.h
+static bool
+testCffLayout()
+{
+    const std::string mesh = writeBox("cff.fmsh", 5, 4, 3);
+    const std::string caseFile = testFile("cff.cas");
+    testFile("cff.cas.h5");
+    std::map<std::string, std::string> attrs;
+    attrs["CaseFormat"] = "both";
+    if (!check(runExport(mesh, caseFile, attrs), "export")) {
+        return false;
+    }
+    const std::vector<TextSection> text = textSections(readFile(caseFile));
+    hid_t file = H5Fopen((caseFile + ".h5").c_str(), H5F_ACC_RDONLY,
+        H5P_DEFAULT);
+    if (!check(file >= 0, "open the HDF5 case file")) {
+        return false;
+    }
+    const std::string m = "/meshes/1/";
+    bool ret = check(3 == readAttr(file, m, "dimension"), "dimension");
+
+    // Nodes
+    const std::vector<double> coords = readDataset<double>(file,
+        m + "nodes/coords/1", H5T_NATIVE_DOUBLE);
+    PWP_UINT64 nNodes = 0;
+    PWP_UINT64 nCells = 0;
+    PWP_UINT64 nFaces = 0;
+    size_t nCellZones = 0;
+    size_t nFaceZones = 0;
+    size_t face = 0;        // index of the next face
+    size_t faceNode = 0;    // index of its first node
+    const std::vector<PWP_UINT32> cellIds = readDataset<PWP_UINT32>(file,
+        m + "cells/zoneTopology/id", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> cellMin = readDataset<PWP_UINT32>(file,
+        m + "cells/zoneTopology/minId", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> cellMax = readDataset<PWP_UINT32>(file,
+        m + "cells/zoneTopology/maxId", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> cellType = readDataset<PWP_UINT32>(file,
+        m + "cells/zoneTopology/cellType", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> faceIds = readDataset<PWP_UINT32>(file,
+        m + "faces/zoneTopology/id", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> faceMin = readDataset<PWP_UINT32>(file,
+        m + "faces/zoneTopology/minId", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> faceMax = readDataset<PWP_UINT32>(file,
+        m + "faces/zoneTopology/maxId", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> zoneType = readDataset<PWP_UINT32>(file,
+        m + "faces/zoneTopology/zoneType", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> nnodes = readDataset<PWP_UINT32>(file,
+        m + "faces/nodes/1/nnodes", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> nodes = readDataset<PWP_UINT32>(file,
+        m + "faces/nodes/1/nodes", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> c0 = readDataset<PWP_UINT32>(file,
+        m + "faces/c0/1", H5T_NATIVE_UINT32);
+    const std::vector<PWP_UINT32> c1 = readDataset<PWP_UINT32>(file,
+        m + "faces/c1/1", H5T_NATIVE_UINT32);
+    for (size_t i = 0; i < text.size(); ++i) {
+        const TextSection &s = text[i];
+        if (FLUENT_NODES == s.id) {
+            nNodes = s.header[2] - s.header[1] + 1;
+            bool same = (coords.size() == s.body.size());
+            for (size_t j = 0; same && j < coords.size(); ++j) {
+                const double v = strtod(s.body[j].c_str(), nullptr);
+                same = fabs(v - coords[j]) <= 1e-14 * fabs(v);
+            }
+            ret = check(same, "node coordinates") && ret;
+        }
+        else if (FLUENT_CELLS == s.id) {
+            const size_t k = nCellZones++;
+            nCells += s.header[2] - s.header[1] + 1;
+            ret = check(k < cellIds.size() && s.header[0] == cellIds[k] &&
+                s.header[1] == cellMin[k] && s.header[2] == cellMax[k] &&
+                s.header[4] == cellType[k], "cell zone topology") && ret;
+            const std::string sec = m + "cells/ctype/" +
+                std::to_string(k + 1);
+            ret = check(s.header[4] == readAttr(file, sec, "elementType") &&
+                s.header[1] == readAttr(file, sec, "minId") &&
+                s.header[2] == readAttr(file, sec, "maxId"),
+                "cell type section") && ret;
+        }
+        else {
+            const size_t k = nFaceZones++;
+            nFaces += s.header[2] - s.header[1] + 1;
+            ret = check(k < faceIds.size() && s.header[0] == faceIds[k] &&
+                s.header[1] == faceMin[k] && s.header[2] == faceMax[k] &&
+                s.header[3] == zoneType[k], "face zone topology") && ret;
+            // Each face is its node count if mixed, its nodes and its cells
+            bool same = (s.header[1] == face + 1);
+            size_t w = 0;
+            for (PWP_UINT64 f = s.header[1]; same && f <= s.header[2]; ++f) {
+                const size_t cnt = (0 == s.header[4]) ?
+                    size_t(strtoul(s.body[w++].c_str(), nullptr, 16)) :
+                    size_t(s.header[4]);
+                same = (face < nnodes.size()) && (cnt == nnodes[face]) &&
+                    (w + cnt + 2 <= s.body.size());
+                for (size_t n = 0; same && n < cnt; ++n) {
+                    same = (faceNode + n < nodes.size()) &&
+                        (strtoul(s.body[w++].c_str(), nullptr, 16) ==
+                            nodes[faceNode + n]);
+                }
+                same = same && (face < c1.size()) &&
+                    (strtoul(s.body[w].c_str(), nullptr, 16) == c0[face]) &&
+                    (strtoul(s.body[w + 1].c_str(), nullptr, 16) ==
+                        c1[face]);
+                w += 2;
+                faceNode += cnt;
+                ++face;
+            }
+            ret = check(same, "faces of a zone") && ret;
+        }
+    }
+    ret = check(nNodes == readAttr(file, m, "nodeCount") &&
+        nCells == readAttr(file, m, "cellCount") &&
+        nFaces == readAttr(file, m, "faceCount"), "mesh counts") && ret;
+    ret = check(face == nnodes.size() && faceNode == nodes.size() &&
+        face == c0.size(), "face section size") && ret;
+    ret = check(1 == readAttr(file, m + "faces/nodes", "nSections") &&
+        1 == readAttr(file, m + "faces/nodes/1", "minId") &&
+        nFaces == readAttr(file, m + "faces/nodes/1", "maxId") &&
+        nNodes == readAttr(file, m + "nodes/coords/1", "maxId") &&
+        nCellZones == readAttr(file, m + "cells/ctype", "nSections"),
+        "section attributes") && ret;
+    const std::string names = readNameAttr(file, m + "faces/zoneTopology");
+    ret = check(nFaceZones == size_t(std::count(names.begin(), names.end(),
+        ';') + 1), "face zone names") && ret;
+    H5Fclose(file);
+    return ret;
+}
+
+
+// The case file of a CaseFormat cff export names the HDF5 case file
+static bool
+testCffStub()
+{
+    const std::string mesh = writeBox("stub.fmsh", 2, 2, 2);
+    const std::string caseFile = testFile("stub.cas");
+    testFile("stub.cas.h5");
+    std::map<std::string, std::string> attrs;
+    attrs["CaseFormat"] = "cff";
+    if (!check(runExport(mesh, caseFile, attrs), "export")) {
+        return false;
+    }
+    return check(std::string::npos != readFile(caseFile).find(
+        "stub.cas.h5"), "the case file does not name the HDF5 file");
+}
+
+#endif // CAEUNSFLUENT_HAVE_HDF5
+
+
+struct Test {
+    const char  *name;
+    bool        (*run)();
+};
+
+static const Test Tests[] = {
+    { "golden", testGolden },
+    { "memorySink", testMemorySink },
+    { "directOutput", testDirectOutput },
+    { "writeFailure", testWriteFailure },
+    { "smallPartitions", testSmallPartitions },
+    { "probeScratch", testProbeScratch },
+    { "meshCacheRecord", testMeshCacheRecord },
+    { "quitBuildFaces", testQuitBuildFaces },
+    { "bareBoundaryFaces", testBareBoundaryFaces },
+    { "checkpointResume", testCheckpointResume },
+    { "sectionIndex", testSectionIndex },
+    { "contentHash", testContentHash },
+    { "boundaryOnly", testBoundaryOnly },
+    { "mergeBCZones", testMergeBCZones },
+    { "singlePrecision", testSinglePrecision },
+    { "abortLatency", testAbortLatency },
+#if defined(CAEUNSFLUENT_HAVE_ZLIB)
+    { "gzipCopy", testGzipCopy },
+#endif
+#if defined(CAEUNSFLUENT_HAVE_HDF5)
+    { "cffLayout", testCffLayout },
+    { "cffStub", testCffStub },
+#endif
+};
+
+
+/************************************************
+*   main
+*************************************************/
+
+// Runs test on the calling thread. Ends the process if it takes more than
+// TestTimeout seconds.
+static bool
+runTest(const Test &test)
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::thread watchdog([&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!finished.wait_for(lock, std::chrono::seconds(TestTimeout),
+                [&]() { return done; })) {
+            fprintf(stderr, "FAIL %s: not finished after %d seconds\n",
+                test.name, TestTimeout);
+            fflush(stderr);
+            _exit(1);
+        }
+    });
+    const bool ok = test.run();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    finished.notify_one();
+    watchdog.join();
+    return ok;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    const char *tmp = getenv("TMPDIR");
+    std::string dir = std::string((tmp && *tmp) ? tmp : "/tmp") +
+        "/fluentTest.XXXXXX";
+    if (nullptr == mkdtemp(&dir[0])) {
+        report("error", "cannot create %s", dir.c_str());
+        return 1;
+    }
+    TestDir = dir;
+    Quiet = true;
+    if (!createRuntime(Rti)) {
+        return 1;
+    }
+    signal(SIGINT, onQuitSignal);
+    signal(SIGTERM, onQuitSignal);
+
+    int failed = 0;
+    for (size_t i = 0; i < ARRAYSIZE(Tests); ++i) {
+        bool selected = (1 == argc);
+        for (int a = 1; a < argc; ++a) {
+            selected = selected || (0 == strcmp(argv[a], Tests[i].name));
+        }
+        if (selected) {
+            const bool ok = runTest(Tests[i]);
+            printf("%s %s\n", ok ? "PASS" : "FAIL", Tests[i].name);
+            fflush(stdout);
+            failed += ok ? 0 : 1;
+        }
+    }
+    runtimeDestroy(&Rti);
+    Model.file.close();
+
+    // In reverse, so the files of a folder go before the folder
+    std::set<std::string>::const_reverse_iterator it = TestFiles.rbegin();
+    for (; TestFiles.rend() != it; ++it) {
+        remove(it->c_str());
+    }
+    if (0 != rmdir(TestDir.c_str())) {
+        report("warning", "cannot remove %s", TestDir.c_str());
+    }
+    return failed;
+}
+
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -0,0 +1,186 @@
+/****************************************************************************
+ *
+ * (C) 2021 Cadence Design Systems, Inc. All rights reserved worldwide.
+ *
+ * This sample source code is not supported by Cadence Design Systems, Inc.
+ * It is provided freely for demonstration purposes only.
+ * SEE THE WARRANTY DISCLAIMER AT THE BOTTOM OF THIS FILE.
+ *
+ ***************************************************************************/
+/****************************************************************************
+ *
+ * FLUENT export trace events
+ *
+ * Writes a Chrome trace-event (JSON array) timeline of the export. Load the
+ * file in chrome://tracing or https://ui.perfetto.dev.
+ *
+ ***************************************************************************/
+
+#ifndef _FLUENTTRACE_H_
+#define _FLUENTTRACE_H_
+
+#include "apiPWP.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+
+
+// Receives completed spans and streams them to the trace file. All methods
+// are cheap no-ops until open() succeeds.
+class FluentTrace {
+public:
+    enum { MaxArgs = 3 };
+
+    struct Arg {
+        const char *key;
+        PWP_UINT64  value;
+    };
+
+    FluentTrace() :
+        fp_(nullptr),
+        cnt_(0),
+        t0_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~FluentTrace()
+    {
+        close();
+    }
+
+    bool open(const char *filename)
+    {
+        close();
+        fp_ = (filename && *filename) ? fopen(filename, "w") : nullptr;
+        if (fp_) {
+            cnt_ = 0;
+            t0_ = std::chrono::steady_clock::now();
+            fprintf(fp_, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"args\":{\"name\":\"CaeUnsFluent export\"}}");
+        }
+        return enabled();
+    }
+
+    void close()
+    {
+        if (fp_) {
+            fprintf(fp_, "\n]\n");
+            fclose(fp_);
+            fp_ = nullptr;
+        }
+    }
+
+    bool enabled() const
+    {
+        return nullptr != fp_;
+    }
+
+    // microseconds since open()
+    PWP_UINT64 now() const
+    {
+        return (PWP_UINT64)std::chrono::duration_cast<
+            std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                t0_).count();
+    }
+
+    // Emit a complete ("X") event
+    void complete(const char *name, PWP_UINT64 begin, PWP_UINT64 end,
+        const Arg *args = nullptr, PWP_UINT32 argCnt = 0)
+    {
+        if (!fp_) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        fprintf(fp_, ",\n{\"name\":\"%s\",\"cat\":\"export\",\"ph\":\"X\","
+            "\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu", name, threadId(),
+            (unsigned long long)begin, (unsigned long long)(end - begin));
+        if (argCnt) {
+            fprintf(fp_, ",\"args\":{");
+            for (PWP_UINT32 i = 0; i < argCnt; ++i) {
+                fprintf(fp_, "%s\"%s\":%llu", (i ? "," : ""), args[i].key,
+                    (unsigned long long)args[i].value);
+            }
+            fprintf(fp_, "}");
+        }
+        fprintf(fp_, "}");
+        ++cnt_;
+    }
+
+    PWP_UINT64 eventCount() const
+    {
+        return cnt_;
+    }
+
+private:
+    // Small, stable per-thread ids read better in the viewer than native ids
+    static PWP_UINT32 threadId()
+    {
+        static std::atomic<PWP_UINT32> nextId(1);
+        static thread_local PWP_UINT32 id = nextId++;
+        return id;
+    }
+
+    FluentTrace(const FluentTrace&) = delete;
+    FluentTrace& operator=(const FluentTrace&) = delete;
+
+private:
+    FILE       *fp_;
+    PWP_UINT64  cnt_;
+    std::mutex  mutex_;
+    std::chrono::steady_clock::time_point t0_;
+};
+
+
+// Scoped span. Costs a single pointer test when tracing is off.
+class FluentTraceSpan {
+public:
+    FluentTraceSpan(FluentTrace *trace, const char *name) :
+        trace_((trace && trace->enabled()) ? trace : nullptr),
+        name_(name),
+        begin_(trace_ ? trace_->now() : 0),
+        argCnt_(0)
+    {
+    }
+
+    ~FluentTraceSpan()
+    {
+        if (trace_) {
+            trace_->complete(name_, begin_, trace_->now(), args_, argCnt_);
+        }
+    }
+
+    void arg(const char *key, PWP_UINT64 value)
+    {
+        if (trace_ && argCnt_ < FluentTrace::MaxArgs) {
+            args_[argCnt_].key = key;
+            args_[argCnt_].value = value;
+            ++argCnt_;
+        }
+    }
+
+private:
+    FluentTraceSpan(const FluentTraceSpan&) = delete;
+    FluentTraceSpan& operator=(const FluentTraceSpan&) = delete;
+
+private:
+    FluentTrace        *trace_;
+    const char         *name_;
+    PWP_UINT64          begin_;
+    PWP_UINT32          argCnt_;
+    FluentTrace::Arg    args_[FluentTrace::MaxArgs];
+};
+
+#endif /* _FLUENTTRACE_H_ */
+
+/****************************************************************************
+ *
+ * This file is licensed under the Cadence Public License Version 1.0 (the
+ * "License"), a copy of which is found in the included file named "LICENSE",
+ * and is distributed "AS IS." TO THE MAXIMUM EXTENT PERMITTED BY APPLICABLE
+ * LAW, CADENCE DISCLAIMS ALL WARRANTIES AND IN NO EVENT SHALL BE LIABLE TO
+ * ANY PARTY FOR ANY DAMAGES ARISING OUT OF OR RELATING TO USE OF THIS FILE.
+ * Please see the License for the full text of applicable terms.
+ *
+ ****************************************************************************/
@@ -36,7 +36,7 @@
         PWP_FALSE,              /* PWP_BOOL allowedFileFormatBinary */
         PWP_FALSE,              /* PWP_BOOL allowedFileFormatUnformatted */
 
-        PWP_FALSE,              /* PWP_BOOL allowedDataPrecisionSingle */
+        PWP_TRUE,               /* PWP_BOOL allowedDataPrecisionSingle */
         PWP_TRUE,               /* PWP_BOOL allowedDataPrecisionDouble */
 
         PWP_TRUE,               /* PWP_BOOL allowedDimension2D */
@@ -20,29 +20,170 @@
 #include "runtimeWrite.h"
 #include "pwpPlatform.h"
 
+#include "fluentApiStats.h"
+#include "fluentArena.h"
+#include "fluentCellTypes.h"
+#include "fluentCff.h"
+#include "fluentCheckpoint.h"
 #include "fluentConstants.h"
+#include "fluentFanOut.h"
+#include "fluentHash.h"
+#include "fluentIndex.h"
+#include "fluentMeshCache.h"
+#include "fluentNodeWriter.h"
+#include "fluentPartition.h"
+#include "fluentPerf.h"
+#include "fluentSink.h"
+#include "fluentSizing.h"
+#include "fluentSpill.h"
+#include "fluentTrace.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <set>
+#include <limits.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <thread>
 #include <vector>
 #include <utility>
 
-
-// VC group stats and info
+#if defined(WINDOWS)
+#   include <io.h>
+#endif
+
+// The grid model API calls below go through FLUENT_API_CALL, which counts
+// and times them if the ApiStats export attribute is set. PwModStreamFaces()
+// is left out. Its time is the whole face stream, callbacks included.
+#define PwBlkCondition(...) \
+    FLUENT_API_CALL(PwBlkCondition, __VA_ARGS__)
+#define PwBlkElementCount(...) \
+    FLUENT_API_CALL(PwBlkElementCount, __VA_ARGS__)
+#define PwBlkEnumElements(...) \
+    FLUENT_API_CALL(PwBlkEnumElements, __VA_ARGS__)
+#define PwDomCondition(...) \
+    FLUENT_API_CALL(PwDomCondition, __VA_ARGS__)
+#define PwDomElementCount(...) \
+    FLUENT_API_CALL(PwDomElementCount, __VA_ARGS__)
+#define PwDomEnumElements(...) \
+    FLUENT_API_CALL(PwDomEnumElements, __VA_ARGS__)
+#define PwElemDataMod(...) \
+    FLUENT_API_CALL(PwElemDataMod, __VA_ARGS__)
+#define PwElemDataModEnum(...) \
+    FLUENT_API_CALL(PwElemDataModEnum, __VA_ARGS__)
+#define PwModAppendEnumElementOrder(...) \
+    FLUENT_API_CALL(PwModAppendEnumElementOrder, __VA_ARGS__)
+#define PwModBlockCount(...) \
+    FLUENT_API_CALL(PwModBlockCount, __VA_ARGS__)
+#define PwModDomainCount(...) \
+    FLUENT_API_CALL(PwModDomainCount, __VA_ARGS__)
+#define PwModEnumBlocks(...) \
+    FLUENT_API_CALL(PwModEnumBlocks, __VA_ARGS__)
+#define PwModEnumDomains(...) \
+    FLUENT_API_CALL(PwModEnumDomains, __VA_ARGS__)
+#define PwModEnumElements(...) \
+    FLUENT_API_CALL(PwModEnumElements, __VA_ARGS__)
+#define PwModEnumVertices(...) \
+    FLUENT_API_CALL(PwModEnumVertices, __VA_ARGS__)
+#define PwModGetAttributeBOOL(...) \
+    FLUENT_API_CALL(PwModGetAttributeBOOL, __VA_ARGS__)
+#define PwModGetAttributeEnum(...) \
+    FLUENT_API_CALL(PwModGetAttributeEnum, __VA_ARGS__)
+#define PwModGetAttributeREAL(...) \
+    FLUENT_API_CALL(PwModGetAttributeREAL, __VA_ARGS__)
+#define PwModGetAttributeString(...) \
+    FLUENT_API_CALL(PwModGetAttributeString, __VA_ARGS__)
+#define PwModGetAttributeUINT32(...) \
+    FLUENT_API_CALL(PwModGetAttributeUINT32, __VA_ARGS__)
+#define PwModVertexCount(...) \
+    FLUENT_API_CALL(PwModVertexCount, __VA_ARGS__)
+#define PwVertDataMod(...) \
+    FLUENT_API_CALL(PwVertDataMod, __VA_ARGS__)
+
+
+// VC group stats and info. The strings are held by the export's arena.
 struct VCGroupStats {
     PWP_UINT32  groupBlkCells;
     PWP_UINT32  elemTypes;
     PWP_UINT32  tid;
-    std::string type;
-    std::string name;
+    const char *type;
+    const char *name;
 };
 
-using VCBlocks      = std::vector<PWP_UINT32>;
+// The per-export containers allocate from FLUENT_DATA::arena
+using VCBlocks      = std::vector<PWP_UINT32,
+                          FluentArenaAllocator<PWP_UINT32> >;
 using VCGroupData   = std::pair<VCGroupStats, VCBlocks>;
-using BlockVCMap    = std::map<PWP_UINT32, VCGroupData>;
-using ShadowFaces   = std::vector<PWGM_FACESTREAM_DATA>;
+using BlockVCMap    = std::map<PWP_UINT32, VCGroupData,
+                          std::less<PWP_UINT32>, FluentArenaAllocator<
+                              std::pair<const PWP_UINT32, VCGroupData> > >;
+using ShadowFaces   = std::vector<PWGM_FACESTREAM_DATA,
+                          FluentArenaAllocator<PWGM_FACESTREAM_DATA> >;
+using ShadowSpill   = FluentSpillFile<PWGM_FACESTREAM_DATA>;
+using FaceBatch     = std::vector<PWGM_FACESTREAM_DATA,
+                          FluentArenaAllocator<PWGM_FACESTREAM_DATA> >;
+
+
+// A written cell zone and its 1-based cell index range
+struct CellZone {
+    PWP_UINT32  zone;
+    PWP_UINT32  firstCell;
+    PWP_UINT32  lastCell;
+};
+
+using CellZones     = std::vector<CellZone, FluentArenaAllocator<CellZone> >;
+
+// The vertices of a boundary only export in ascending order. A vertex is
+// written as the node of its position.
+using SurfaceNodes  = std::vector<PWP_UINT32,
+                          FluentArenaAllocator<PWP_UINT32> >;
+
+// The BC condition id of each domain, and the cell type of each BC zone of a
+// MergeBCZones export. A BC zone is named by its bcZoneKey().
+using DomainBCs     = std::vector<PWP_UINT32,
+                          FluentArenaAllocator<PWP_UINT32> >;
+using BCZoneTypes   = std::map<PWP_UINT64, PWP_UINT32,
+                          std::less<PWP_UINT64>, FluentArenaAllocator<
+                              std::pair<const PWP_UINT64, PWP_UINT32> > >;
+
+
+// State of a checkpointed export (see the Checkpoint export attribute)
+struct CheckpointState {
+    // the case file until the export completes, and the checkpoint record
+    std::string         partFile;
+    std::string         recordFile;
+
+    // descriptor of partFile
+    int                 fd{ -1 };
+
+    // bytes written between two checkpoints
+    PWP_UINT64          interval{ 0 };
+
+    // modelFingerprint() of the export
+    PWP_UINT64          fingerprint{ 0 };
+
+    // digest of the partFile bytes up to the last checkpoint
+    FluentChunkHash     hash;
+
+    // false once a checkpoint could not be written
+    bool                enabled{ true };
+
+    // true if the export continues from resume
+    bool                resumed{ false };
+    FluentCheckpoint    resume;
+
+    // streamed faces still to skip because they are in the resumed file
+    PWP_UINT64          skipFaces{ 0 };
+};
+
+
+// BC types that are exported as a face and its shadow
+static const char * const ShadowTypes = "Porous Jump|Fan|Radiator|Interior";
 
 
 // Runtime export state data
@@ -58,6 +199,29 @@ struct FLUENT_DATA {
         *this = FLUENT_DATA();
     }
 
+    // Puts the containers on arena a. They must be empty.
+    void setArena(FluentArena &a)
+    {
+        arena = &a;
+        blockVCMap = BlockVCMap(BlockVCMap::key_compare(),
+            BlockVCMap::allocator_type(&a, FluentArena::VCMap));
+        shadowFaces = ShadowFaces(ShadowFaces::allocator_type(&a,
+            FluentArena::ShadowFaces));
+        faceBatch = FaceBatch(FaceBatch::allocator_type(&a,
+            FluentArena::FaceBatch));
+        cellZones = CellZones(CellZones::allocator_type(&a,
+            FluentArena::CellZones));
+        surfaceNodes = SurfaceNodes(SurfaceNodes::allocator_type(&a,
+            FluentArena::SurfaceNodes));
+        domainBCs = DomainBCs(DomainBCs::allocator_type(&a,
+            FluentArena::BCZones));
+        bcZoneTypes = BCZoneTypes(BCZoneTypes::key_compare(),
+            BCZoneTypes::allocator_type(&a, FluentArena::BCZones));
+    }
+
+    // allocator of the containers below, freed when the export returns
+    FluentArena        *arena{ nullptr };
+
     // current zone id
     PWP_UINT32          zone{ 0 };
 
@@ -97,16 +261,217 @@ struct FLUENT_DATA {
     // maps VC id to its blocks
     BlockVCMap          blockVCMap;
 
-    // cache of shadow faces
+    // cache of shadow faces, and of the BC faces of a MergeBCZones export
     ShadowFaces         shadowFaces;
 
-    // file pos of open face zone header comment
-    sysFILEPOS          indexPos1{};
+    // sorted runs of shadow faces spilled over the ShadowMemory budget
+    ShadowSpill        *shadowSpill{ nullptr };
+
+    // faces streamed since the last flushFaceBatch()
+    FaceBatch           faceBatch;
+
+    // number of faces streamed to faceBatch before its first face. Shadow
+    // faces are not counted.
+    PWP_UINT64          batchOrdinal{ 0 };
+
+    // checkpoint and resume state (null if not checkpointing)
+    CheckpointState    *checkpoint{ nullptr };
+
+    // sink offset of open face zone header comment
+    PWP_UINT64          indexPos1{ 0 };
+
+    // sink offset of open face zone header data
+    PWP_UINT64          indexPos2{ 0 };
+
+    // destination of all writer output
+    FluentSink         *sink{ nullptr };
+
+    // digests of the case file and its sections (null unless ContentHash)
+    FluentHashSink     *hashSink{ nullptr };
+
+    // the export's sink while an open face zone is staged in zoneStage
+    FluentSink         *zoneSink{ nullptr };
+
+    // holds the open face zone if the export's sink is not patchable
+    FluentMemorySink   *zoneStage{ nullptr };
+
+    // set once an error that fails the export has been reported
+    bool                writeFailed{ false };
+
+    // trace-event recorder (disabled unless requested)
+    FluentTrace        *trace{ nullptr };
 
-    // file pos of open face zone header data
-    sysFILEPOS          indexPos2{};
+    // per-phase hardware counters (disabled unless requested)
+    FluentPerf         *perf{ nullptr };
+    bool                perfFaces{ false };     // face stream phase running
+
+    // grid model API call counts and times (null unless ApiStats)
+    FluentApiStats     *apiStats{ nullptr };
+
+    // trace time the open face zone was started
+    PWP_UINT64          zoneTraceBegin{ 0 };
+
+    // total number of cells in the model
+    PWP_UINT32          cellCount{ 0 };
+
+    // cell zones in the order written
+    CellZones           cellZones;
+
+    // true if only the BC faces and their nodes are written (see the
+    // BoundaryOnly export attribute)
+    bool                boundaryOnly{ false };
+
+    // vertices of a boundary only export
+    SurfaceNodes        surfaceNodes;
+
+    // true if the BC faces are written as one face zone per BC (see the
+    // MergeBCZones export attribute)
+    bool                mergeBCZones{ false };
+
+    // BC condition id by domain id, and cell type by BC zone
+    DomainBCs           domainBCs;
+    BCZoneTypes         bcZoneTypes;
+
+    // block of the last cached BC face that ran the zone state machine
+    PWGM_HBLOCK         bcZoneBlk = PWGM_HBLOCK_INIT;
+
+    // block and zone key of the last cached face added to bcZoneTypes
+    PWGM_HBLOCK         bcTypeBlk = PWGM_HBLOCK_INIT;
+    PWP_UINT64          bcTypeKey{ 0 };
+
+    // zone key of the open face zone of the cached faces
+    PWP_UINT64          cachedZoneKey{ 0 };
+
+    // cell adjacency collected for partitioning (null if not partitioning)
+    FluentCellGraph    *cellGraph{ nullptr };
+
+    // cell types of the mixed cell zones made on a worker thread (null if
+    // writeVCZone() enumerates them itself)
+    FluentCellTypeLists *cellTypeLists{ nullptr };
+
+    // set instead of a real sink during a counting dry run
+    FluentCountingSink *countingSink{ nullptr };
+
+    // zones of the mesh file of a MeshCache export (null if the export
+    // writes the whole case file). writeZoneEnd() records the zones instead
+    // of writing their zone sections.
+    FluentMeshZones    *meshZones{ nullptr };
+
+    // writes the node coordinates on a worker thread (null if writeVerts()
+    // writes them itself, PipelineNodes export attribute)
+    FluentNodeWriter   *nodeWriter{ nullptr };
+
+    // false if only the HDF5 case file is written
+    bool                writeText{ true };
+
+    // HDF5 (CFF) case file writer (null if not requested)
+    FluentCffWriter    *cff{ nullptr };
+
+    // section byte offsets for the index file (null if not requested)
+    FluentSectionIndex *sectionIndex{ nullptr };
+
+    // partitioning settings (see the Partition* export attributes)
+    PWP_UINT32          partCount{ 0 };
+    PWP_REAL            partImbalance{ 0.05 };
+    PWP_REAL            partPrismWeight{ 1.0 };
+
+    // runtime settings (see the Threads, BufferSize, ShadowMemory and
+    // ProgressStep export attributes). A zero bufferSize or shadowBudget
+    // selects the default; a zero progressStep is chosen per step.
+    PWP_UINT32          threads{ 1 };
+    PWP_UINT32          bufferSize{ 0 };
+    PWP_UINT64          shadowBudget{ 0 };
+    PWP_UINT32          progressStep{ 1 };
+
+    // items per caeuProgressIncr() call in the current progress step
+    PWP_UINT32          progressEvery{ 1 };
+
+    // items counted since the last caeuProgressIncr() call
+    PWP_UINT32          progressCount{ 0 };
+
+    // earliest time pollAbort() asks the host again
+    std::chrono::steady_clock::time_point nextAbortPoll;
+
+    // time pollAbort() saw the abort (unset if it did not)
+    std::chrono::steady_clock::time_point abortTime;
 };
 
+// Minimum time between two pollAbort() calls to the host. Every phase polls
+// often enough that an abort is honored within a few of these intervals.
+static const PWP_UINT32 AbortPollMs = 50;
+
+// Number of shadow faces written between abort polls in endCB()
+static const PWP_UINT32 ShadowChunkSize = 65536;
+
+// Asks the host whether the export was aborted, at most once per AbortPollMs.
+// CAEPU_RT_IS_ABORTED() sees the result. Cheap enough to call per element.
+static bool
+pollAbort(CAEP_RTITEM &rti)
+{
+    if (!CAEPU_RT_IS_ABORTED(&rti)) {
+        const std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        if (now >= rti.data->nextAbortPoll) {
+            rti.data->nextAbortPoll = now +
+                std::chrono::milliseconds(AbortPollMs);
+            if (PwuProgressQuit(rti.pApiData->apiInfo.name)) {
+                rti.opAborted = PWP_TRUE;
+                rti.data->abortTime = now;
+            }
+        }
+    }
+    return 0 != CAEPU_RT_IS_ABORTED(&rti);
+}
+
+// Number of host progress updates per step if ProgressStep is 0
+static const PWP_UINT32 ProgressTicks = 1000;
+
+// Starts a progress step of total items. The host is told about every
+// progressEvery-th item only.
+static bool
+progressBeginStep(CAEP_RTITEM &rti, const PWP_UINT32 total)
+{
+    PWP_UINT32 every = rti.data->progressStep;
+    if (0 == every) {
+        every = std::max(1U, total / ProgressTicks);
+    }
+    rti.data->progressEvery = every;
+    rti.data->progressCount = 0;
+    return 0 != caeuProgressBeginStep(&rti, total / every +
+        (0 != total % every ? 1 : 0));
+}
+
+
+// Counts one item of the current progress step. Returns false if the export
+// was aborted.
+static inline bool
+progressIncr(CAEP_RTITEM &rti)
+{
+    if (++rti.data->progressCount < rti.data->progressEvery) {
+        return !CAEPU_RT_IS_ABORTED(&rti);
+    }
+    rti.data->progressCount = 0;
+    return 0 != caeuProgressIncr(&rti);
+}
+
+
+// Number of vertices written per writeVerts() trace span
+static const PWP_UINT32 VertChunkSize = 65536;
+
+// Number of faces accumulated by faceCB() before they are processed
+static const PWP_UINT32 FaceBatchSize = 4096;
+
+// Size of the stack buffer used by writeFaceRun() to format faces
+static const PWP_UINT32 FaceBufSize = 16384;
+
+// Widths of the blank lines reserved for a face zone's comment and header
+static const PWP_UINT32 ZoneCommentLen = 128;
+static const PWP_UINT32 ZoneHeaderLen = 50;
+
+// Longest possible formatted face line. A mixed quad face is 7 values of
+// at most 8 hex digits plus separators.
+static const PWP_UINT32 MaxFaceLineLen = 7 * 9 + 1;
+
 
 static inline PWP_UINT32
 convertCellType(const PWGM_ENUM_ELEMTYPE pwType)
@@ -230,8 +595,9 @@ getElemsCodeBlkCells(const PWGM_HBLOCK hBlk, PWGM_ELEMCOUNTS elemCnts,
 
 
 static inline PWP_UINT32
-getNeighborVCId(PWGM_FACESTREAM_DATA *data)
+getNeighborVCId(const PWGM_FACESTREAM_DATA *data)
 {
+    FluentApiPhase apiPhase(FluentApiStats::NeighborVC);
     PWP_UINT32 result = PWP_BADID;
     if (PWGM_FACETYPE_CONNECTION == data->type) {
         PWGM_ENUMELEMDATA eData;
@@ -278,6 +644,9 @@ makeSafe(std::string &bctype, const char spaceReplacement)
 static void
 getSafeBC(const CAEP_RTITEM &rti, const PWGM_HDOMAIN &h, PWGM_CONDDATA &cond)
 {
+    // cond is left alone if h is not a domain, e.g. for the boundary faces
+    // that are not on one
+    memset(&cond, 0, sizeof(cond));
     if (!PwDomCondition(h, &cond) || (0 == cond.tid)) {
         // Type is unspecified - default to wall BC
         cond.tid = rti.pBCInfo[0].id;
@@ -293,6 +662,7 @@ getSafeBC(const CAEP_RTITEM &rti, const PWGM_HDOMAIN &h, PWGM_CONDDATA &cond)
 static void
 getSafeVC(const CAEP_RTITEM &rti, const PWGM_HBLOCK &h, PWGM_CONDDATA &cond)
 {
+    memset(&cond, 0, sizeof(cond));
     if (!PwBlkCondition(h, &cond) || (0 == cond.tid)) {
         // Type is unspecified - default to fluid VC
         cond.tid = rti.pVCInfo[0].id;
@@ -305,6 +675,90 @@ getSafeVC(const CAEP_RTITEM &rti, const PWGM_HBLOCK &h, PWGM_CONDDATA &cond)
 }
 
 
+// returns true if bcType is one of the ShadowTypes
+static bool
+isShadowType(const char *bcType)
+{
+    const std::string types = std::string("|") + ShadowTypes + "|";
+    return bcType && (std::string::npos !=
+        types.find(std::string("|") + bcType + "|"));
+}
+
+
+// Number of faces of the domains with one of the ShadowTypes. faceCB() caches
+// that many shadow faces.
+static PWP_UINT64
+countShadowFaces(const CAEP_RTITEM &rti)
+{
+    PWP_UINT64 ret = 0;
+    PWGM_ELEMCOUNTS ec;
+    const PWP_UINT32 domainCount = PwModDomainCount(rti.model);
+    for (PWP_UINT32 ndx = 0; ndx < domainCount; ++ndx) {
+        PWGM_HDOMAIN hDom = PwModEnumDomains(rti.model, ndx);
+        PWGM_CONDDATA cond;
+        getSafeBC(rti, hDom, cond);
+        if (isShadowType(cond.type)) {
+            ret += PwDomElementCount(hDom, &ec);
+        }
+    }
+    return ret;
+}
+
+
+// Load rti.data->domainBCs with the BC condition id of each domain. Domains
+// without a BC share the id of the unspecified condition.
+static void
+loadDomainBCs(CAEP_RTITEM &rti)
+{
+    const PWP_UINT32 domainCount = PwModDomainCount(rti.model);
+    rti.data->domainBCs.resize(domainCount);
+    for (PWP_UINT32 ndx = 0; ndx < domainCount; ++ndx) {
+        PWGM_CONDDATA cond = PWGM_CONDDATA();
+        getSafeBC(rti, PwModEnumDomains(rti.model, ndx), cond);
+        rti.data->domainBCs[ndx] = cond.id;
+    }
+}
+
+
+// The BC zone of a cached face of a MergeBCZones export. Shadow faces and BC
+// faces of the same BC are kept in separate zones.
+static inline PWP_UINT64
+bcZoneKey(const DomainBCs &bcs, const PWGM_FACESTREAM_DATA &f)
+{
+    const PWP_UINT32 domId = PWGM_HDOMAIN_ID(f.owner.domain);
+    const PWP_UINT64 shadow = (PWGM_FACETYPE_CONNECTION == f.type ? 1 : 0);
+    return (shadow << 32) | (domId < bcs.size() ? bcs[domId] : PWP_BADID);
+}
+
+
+// The face zone of a cached face: its BC zone in a MergeBCZones export, else
+// its domain
+static inline PWP_UINT64
+cachedZoneKey(const CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA &f)
+{
+    return rti.data->mergeBCZones ? bcZoneKey(rti.data->domainBCs, f) :
+        PWGM_HDOMAIN_ID(f.owner.domain);
+}
+
+
+// Starts the next content hash section at the current output position. The
+// section of a zone is named after its kind and zone id.
+static void
+beginHashSection(CAEP_RTITEM &rti, const char *kind, const PWP_UINT32 zone)
+{
+    if (nullptr != rti.data->hashSink) {
+        char name[32];
+        if (0 != zone) {
+            snprintf(name, sizeof(name), "%s %u", kind, zone);
+        }
+        else {
+            snprintf(name, sizeof(name), "%s", kind);
+        }
+        rti.data->hashSink->beginSection(name);
+    }
+}
+
+
 static void
 writeSectionListHdr(CAEP_RTITEM &rti, va_list &arglist, SectionId id,
     const char *format, const char *sfx)
@@ -315,9 +769,10 @@ writeSectionListHdr(CAEP_RTITEM &rti, va_list &arglist, SectionId id,
     //     ...
     //   data line N
     // ))                  <-- footer
-    fprintf(rti.fp, "(%d (", id);
-    ::vfprintf(rti.fp, format, arglist);
-    fprintf(rti.fp, ")(%s", (sfx ? sfx : ""));
+    FluentSink &out = *rti.data->sink;
+    out.print("(%d (", id);
+    out.vprint(format, arglist);
+    out.print(")(%s", (sfx ? sfx : ""));
 }
 
 
@@ -344,7 +799,7 @@ writeSectionListHdrNoCR(CAEP_RTITEM &rti, SectionId id, const char *format, ...)
 static void
 writeSectionListFtr(CAEP_RTITEM &rti)
 {
-    ::fprintf(rti.fp, "))\n");
+    rti.data->sink->write("))\n", 3);
 }
 
 
@@ -353,9 +808,10 @@ writeSectionLine(CAEP_RTITEM &rti, va_list &arglist, SectionId id,
     const char *format, const char *sfx)
 {
     // (45 (2 fluid vcFluid) ())
-    fprintf(rti.fp, "(%d (", id);
-    ::vfprintf(rti.fp, format, arglist);
-    fprintf(rti.fp, ")())%s", (sfx ? sfx : ""));
+    FluentSink &out = *rti.data->sink;
+    out.print("(%d (", id);
+    out.vprint(format, arglist);
+    out.print(")())%s", (sfx ? sfx : ""));
 }
 
 
@@ -372,24 +828,26 @@ writeSectionLine(CAEP_RTITEM &rti, SectionId id, const char *format, ...)
 static void
 writeComment(CAEP_RTITEM &rti, const char *format, ...)
 {
-    fprintf(rti.fp, "(%d \"", FLUENT_COMMENT);
+    FluentSink &out = *rti.data->sink;
+    out.print("(%d \"", FLUENT_COMMENT);
     va_list args;
     va_start(args, format);
-    ::vfprintf(rti.fp, format, args);
+    out.vprint(format, args);
     va_end(args);
-    fprintf(rti.fp, "\")\n");
+    out.write("\")\n", 3);
 }
 
 
 static void
 writeCommentNoCR(CAEP_RTITEM &rti, const char *format, ...)
 {
-    fprintf(rti.fp, "(%d \"", FLUENT_COMMENT);
+    FluentSink &out = *rti.data->sink;
+    out.print("(%d \"", FLUENT_COMMENT);
     va_list args;
     va_start(args, format);
-    ::vfprintf(rti.fp, format, args);
+    out.vprint(format, args);
     va_end(args);
-    fprintf(rti.fp, "\")");
+    out.write("\")", 2);
 }
 
 
@@ -409,6 +867,26 @@ writeFacesListFtr(CAEP_RTITEM &rti)
 }
 
 
+// Appends v as lowercase hex, exactly as printf("%x") would
+static inline char *
+appendHex(char *p, PWP_UINT32 v)
+{
+    static const char Digits[] = "0123456789abcdef";
+    char tmp[8];
+    int n = 0;
+    do {
+        tmp[n++] = Digits[v & 0xF];
+        v >>= 4;
+    } while (0 != v);
+    while (0 != n) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+
+// Formats one face line into p and returns the end of the line. Writes at
+// most MaxFaceLineLen chars.
 /*
 face header: (13 (zoneId firstIndex lastIndex elemType))
    or
@@ -478,16 +956,19 @@ where type is the type of face, as defined in the following table:
         36      outflow
         37      axis
 */
-static void
-writeOneFace(const CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA &face)
+static inline char *
+formatOneFace(char *p, const PWP_UINT32 vcCellType,
+    const PWGM_FACESTREAM_DATA &face)
 {
     // if zone has mixed cell types, must prefix face with vertex count.
-    if (FLUENT_CELL_MIXED == rti.data->vcCellType) {
-        fprintf(rti.fp, "%x ", face.elemData.vertCnt);
+    if (FLUENT_CELL_MIXED == vcCellType) {
+        p = appendHex(p, face.elemData.vertCnt);
+        *p++ = ' ';
     }
     // write the node indices
     for (PWP_UINT32 i = 0; i < face.elemData.vertCnt; ++i) {
-        fprintf(rti.fp, "%x ", face.elemData.index[i] + 1);
+        p = appendHex(p, face.elemData.index[i] + 1);
+        *p++ = ' ';
     }
     // write the owner/neighbor cell indices
     switch (face.type) {
@@ -495,35 +976,223 @@ writeOneFace(const CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA &face)
         // Since PW boundary normals point to the interior of zone, the owner
         // cell is always the first index (cr). There is no neighbor, so second
         // index is zero (cl).
-        fprintf(rti.fp, "%x %x\n", face.owner.cellIndex + 1, 0);
+        p = appendHex(p, face.owner.cellIndex + 1);
+        *p++ = ' ';
+        *p++ = '0';
         break;
     case PWGM_FACETYPE_INTERIOR:
     case PWGM_FACETYPE_CONNECTION:
-        fprintf(rti.fp, "%x %x\n", face.owner.cellIndex + 1,
-            face.neighborCellIndex + 1);
+        p = appendHex(p, face.owner.cellIndex + 1);
+        *p++ = ' ';
+        p = appendHex(p, face.neighborCellIndex + 1);
         break;
     default:
         // SHOULD NEVER GET HERE
-        fprintf(rti.fp, "%x %x\n", 0, 0);
+        *p++ = '0';
+        *p++ = ' ';
+        *p++ = '0';
         break;
     }
+    *p++ = '\n';
+    return p;
+}
+
+
+// The 0-based node of vertex ndx in a boundary only export
+static inline PWP_UINT32
+surfaceNodeIndex(const SurfaceNodes &nodes, const PWP_UINT32 ndx)
+{
+    return PWP_UINT32(std::lower_bound(nodes.begin(), nodes.end(), ndx) -
+        nodes.begin());
+}
+
+
+// Formats a face of a boundary only export. Its vertices are renumbered to
+// the surface nodes, and there are no cells on either side.
+static inline char *
+formatSurfaceFace(char *p, const PWP_UINT32 vcCellType,
+    const PWGM_FACESTREAM_DATA &face, const SurfaceNodes &nodes)
+{
+    if (FLUENT_CELL_MIXED == vcCellType) {
+        p = appendHex(p, face.elemData.vertCnt);
+        *p++ = ' ';
+    }
+    for (PWP_UINT32 i = 0; i < face.elemData.vertCnt; ++i) {
+        p = appendHex(p, surfaceNodeIndex(nodes, face.elemData.index[i]) + 1);
+        *p++ = ' ';
+    }
+    *p++ = '0';
+    *p++ = ' ';
+    *p++ = '0';
+    *p++ = '\n';
+    return p;
+}
+
+
+// false if the staged face zone outgrew the ZoneStageLimit export attribute.
+// The export fails then.
+static bool
+checkZoneStage(CAEP_RTITEM &rti)
+{
+    if (nullptr == rti.data->zoneSink || rti.data->zoneStage->ok()) {
+        return true;
+    }
+    if (!rti.data->writeFailed) {
+        caeuSendErrorMsg(&rti, "A face zone is larger than the ZoneStageLimit "
+            "export attribute allows. It cannot be held in memory for an "
+            "output that cannot be patched (an output descriptor or a "
+            "compressed output copy).", 0);
+        rti.data->writeFailed = true;
+    }
+    return false;
+}
+
+
+// false if the export's sink has failed. The first failure is reported and
+// fails the export.
+static bool
+checkSink(CAEP_RTITEM &rti)
+{
+    if (!checkZoneStage(rti)) {
+        return false;
+    }
+    if (rti.data->sink->ok()) {
+        return true;
+    }
+    if (!rti.data->writeFailed) {
+        caeuSendErrorMsg(&rti, "Could not write the case file.", 0);
+        rti.data->writeFailed = true;
+    }
+    return false;
+}
+
+
+// Overwrite the blank line reserved at offset with line's text. A line
+// wider than the reservation, or a failed patch, fails the export.
+static bool
+patchReservedLine(CAEP_RTITEM &rti, const PWP_UINT64 offset,
+    const FluentMemorySink &line, const PWP_UINT32 width)
+{
+    if (line.size() > size_t(width)) {
+        std::string msg("The line \"");
+        msg.append(line.data(), line.size());
+        msg.append("\" does not fit the space reserved for it in the case "
+            "file.");
+        caeuSendErrorMsg(&rti, msg.c_str(), 0);
+        rti.data->writeFailed = true;
+        return false;
+    }
+    if (0 != line.size()) {
+        rti.data->sink->patch(offset, line.data(), line.size());
+    }
+    return checkSink(rti);
+}
+
+
+// Write a run of faces to the open face zone. The faces are formatted into a
+// local buffer that is written in large pieces.
+static bool
+writeFaceRun(CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA *faces,
+    const PWP_UINT32 cnt, const bool progress)
+{
+    FluentSink &out = *rti.data->sink;
+    char buf[FaceBufSize];
+    char *p = buf;
+    const char * const pEnd = buf + FaceBufSize - MaxFaceLineLen;
+    const PWP_UINT32 vcCellType = rti.data->vcCellType;
+    const bool writeText = rti.data->writeText;
+    const bool surface = rti.data->boundaryOnly;
+    const SurfaceNodes &nodes = rti.data->surfaceNodes;
+    if (nullptr != rti.data->cff) {
+        rti.data->cff->addFaces(faces, cnt);
+    }
+    bool ok = true;
+    for (PWP_UINT32 i = 0; i < cnt; ++i) {
+        if (p > pEnd) {
+            out.write(buf, size_t(p - buf));
+            p = buf;
+        }
+        if (writeText) {
+            p = surface ? formatSurfaceFace(p, vcCellType, faces[i], nodes) :
+                formatOneFace(p, vcCellType, faces[i]);
+        }
+        if (progress && !progressIncr(rti)) {
+            ok = false;
+            break;
+        }
+    }
+    if (p != buf) {
+        out.write(buf, size_t(p - buf));
+    }
+    rti.data->faceIndex += (ok ? cnt : 0);
+    return checkSink(rti) && ok;
+}
+
+
+static void
+writeReal(FluentSink &out, const bool single, const PWP_REAL &v,
+          const char* prefix, const char* suffix)
+{
+    if (suffix && prefix) {
+        if (single) {
+            // 9 significant digits restore a float exactly
+            out.print("%s%15.8e%s", prefix, double(float(v)), suffix);
+        }
+        else {
+            out.print("%s%23.15e%s", prefix, v, suffix);
+        }
+    }
 }
 
 
+// Write the coordinates of one node as a line of the nodes section
 static void
-writeReal(const CAEP_RTITEM &rti, const PWP_REAL &v, const char* prefix,
-          const char* suffix)
+writeNode(FluentSink &out, const bool single, const PWP_UINT32 dim,
+          const PWGM_VERTDATA &vertData)
 {
-    if (rti.fp && suffix && prefix) {
-        fprintf(rti.fp, "%s%23.15e%s", prefix, v, suffix); 
+    writeReal(out, single, vertData.x, "", "");
+    if (2 == dim) {
+        // Write XY only for 2-D export
+        writeReal(out, single, vertData.y, " ", "\n");
+    }
+    else {
+        // Write XYZ for 3-D export
+        writeReal(out, single, vertData.y, " ", "");
+        writeReal(out, single, vertData.z, " ", "\n");
     }
 }
 
 
+// Number of chars writeReal() writes per coordinate, plus its separator
+static PWP_UINT32
+realChars(const CAEP_RTITEM &rti)
+{
+    return CAEPU_RT_PREC_SINGLE(&rti) ? 16 : 24;
+}
+
+
 static void
 writeBlankLine(CAEP_RTITEM &rti, const PWP_UINT32 lineLength)
 {
-    fprintf(rti.fp, "%*.*s\n", lineLength, lineLength, "");
+    rti.data->sink->print("%*.*s\n", lineLength, lineLength, "");
+}
+
+
+// Record a section in the index file. The section occupies the length bytes
+// starting at offset.
+static void
+addIndexEntry(CAEP_RTITEM &rti, SectionId id, PWP_UINT32 first,
+    PWP_UINT32 last, PWP_UINT64 offset, PWP_UINT64 length,
+    std::string condType, std::string condName)
+{
+    if (nullptr != rti.data->sectionIndex) {
+        // Match the names written to the zone section
+        makeSafe(condType, '-');
+        makeSafe(condName, '_');
+        const FluentSectionIndex::Entry entry = { rti.data->zone,
+            PWP_UINT32(id), first, last, offset, length, condType, condName };
+        rti.data->sectionIndex->add(entry);
+    }
 }
 
 
@@ -532,6 +1201,8 @@ static bool
 writeHeader(CAEP_RTITEM &rti, PWP_UINT32 nFaces, PWP_UINT32 nBFaces, 
     PWP_UINT32 &nNodes) 
 {
+    FluentTraceSpan span(rti.data->trace, "writeHeader");
+    FluentApiPhase apiPhase(FluentApiStats::Header);
     time_t rawtime;
     time(&rawtime);
     PWP_UINT32 nCells = 0;
@@ -539,30 +1210,43 @@ writeHeader(CAEP_RTITEM &rti, PWP_UINT32 nFaces, PWP_UINT32 nBFaces,
     strftime(timestr, 50, "%H:%M:%S  %a %b %d %Y", localtime(&rawtime));
 
     const PWP_UINT32 dim = (CAEPU_RT_DIM_2D(&rti) ? 2 : 3);
-    nNodes = PwModVertexCount(rti.model);
+    nNodes = (rti.data->boundaryOnly ?
+        PWP_UINT32(rti.data->surfaceNodes.size()) :
+        PwModVertexCount(rti.model));
 
+    beginHashSection(rti, "header", 0);
     //rti. getAttribute("AppNameAndVersion", appVer, "Unknown");
     const char *val = 0;
     if (!PwModGetAttributeString(rti.model, "AppNameAndVersion", &val)) {
         val = "Pointwise";
     }
-    fprintf(rti.fp, "(%d \"Exported from %s\")\n", FLUENT_HEADER, val);
+    FluentSink &out = *rti.data->sink;
+    out.print("(%d \"Exported from %s\")\n", FLUENT_HEADER, val);
     writeComment(rti, "%s", timestr);
-    fprintf(rti.fp, "\n");
+    out.print("\n");
 
     writeComment(rti, "Dimension : %u", dim);
-    fprintf(rti.fp, "(%d %u)\n", FLUENT_DIMENSION, dim);
-    fprintf(rti.fp, "\n");
+    out.print("(%d %u)\n", FLUENT_DIMENSION, dim);
+    out.print("\n");
 
     writeComment(rti, "Number of Nodes : %u", nNodes);
-    fprintf(rti.fp, "(%d (0 1 %x 0 %u))\n", FLUENT_NODES, nNodes, dim);
-    fprintf(rti.fp, "\n");
+    out.print("(%d (0 1 %x 0 %u))\n", FLUENT_NODES, nNodes, dim);
+    out.print("\n");
 
     writeComment(rti, "Total Number of Faces : %u", nFaces);
     writeComment(rti, "       Boundary Faces : %u", nBFaces);
     writeComment(rti, "       Interior Faces : %u", nFaces - nBFaces);
-    fprintf(rti.fp, "(%d (0 1 %x 0))\n", FLUENT_FACES, nFaces);
-    fprintf(rti.fp, "\n");
+    out.print("(%d (0 1 %x 0))\n", FLUENT_FACES, nFaces);
+    out.print("\n");
+
+    if (rti.data->boundaryOnly) {
+        // The cells are not counted or written
+        writeComment(rti, "Total Number of Cells : 0 (boundary only)");
+        out.print("(%d (0 1 0 0))\n", FLUENT_CELLS);
+        out.print("\n");
+        rti.data->cellCount = 0;
+        return !CAEPU_RT_IS_ABORTED(&rti);
+    }
 
     PWP_UINT32 nTets = 0;
     PWP_UINT32 nPyrs = 0;
@@ -573,7 +1257,7 @@ writeHeader(CAEP_RTITEM &rti, PWP_UINT32 nFaces, PWP_UINT32 nBFaces,
     PWP_UINT32 ndx = 0;
     PWGM_HBLOCK hBlk = PwModEnumBlocks(rti.model, 0);
     PWGM_ELEMCOUNTS elemCnts;
-    while (PWGM_HBLOCK_ISVALID(hBlk) && !CAEPU_RT_IS_ABORTED(&rti)) {
+    while (PWGM_HBLOCK_ISVALID(hBlk) && !pollAbort(rti)) {
         nCells += PwBlkElementCount(hBlk, &elemCnts);
         if (3 == dim) {
             nTets += PWGM_ECNT_Tet(elemCnts);
@@ -600,9 +1284,79 @@ writeHeader(CAEP_RTITEM &rti, PWP_UINT32 nFaces, PWP_UINT32 nBFaces,
         writeComment(rti, "            Tri cells : %u", nTris);
         writeComment(rti, "           Quad cells : %u", nQuads);
     }
-    fprintf(rti.fp, "(%d (0 1 %x 0))\n", FLUENT_CELLS, nCells);
-    fprintf(rti.fp, "\n");
+    out.print("(%d (0 1 %x 0))\n", FLUENT_CELLS, nCells);
+    out.print("\n");
+    rti.data->cellCount = nCells;
+    return !CAEPU_RT_IS_ABORTED(&rti);
+}
+
+
+// Writes the coordinates of nNodes nodes to out, or of the nodes listed in
+// surface if it is not null. Runs on the thread of the node writer.
+static bool
+writeNodeCoords(FluentSink &out, const std::atomic<bool> &cancelled,
+    const PWGM_HGRIDMODEL model, const SurfaceNodes *surface,
+    const PWP_UINT32 nNodes, const bool single, const PWP_UINT32 dim)
+{
+    PWGM_VERTDATA vertData;
+    for (PWP_UINT32 ii = 0; ii < nNodes; ++ii) {
+        if (0 == (ii & 0xFFFF) && cancelled) {
+            return false;
+        }
+        if (!PwVertDataMod(PwModEnumVertices(model,
+                surface ? (*surface)[ii] : ii), &vertData)) {
+            return false;
+        }
+        writeNode(out, single, dim, vertData);
+    }
+    return out.ok();
+}
+
+
+// Starts writing the coordinates of the nodes section on the node writer's
+// thread, if the export has one. They have a fixed width, so the sink skips
+// the bytes they take and the writer fills them in with pwrite() while the
+// faces are streamed. Returns false if the sink cannot skip ahead, in which
+// case the caller writes the coordinates itself.
+static bool
+startNodeWriter(CAEP_RTITEM &rti, const PWP_UINT32 nNodes,
+    const PWP_UINT32 dim)
+{
+#if !defined(WINDOWS)
+    FluentNodeWriter *writer = rti.data->nodeWriter;
+    FluentFdSink *sink = dynamic_cast<FluentFdSink*>(rti.data->sink);
+    if (nullptr == writer || nullptr == sink || !sink->isPatchable() ||
+            !sink->flush()) {
+        return false;
+    }
+    // The descriptor is at the sink's offset once the sink is flushed
+    const PWP_UINT64 begin = sink->tell();
+    const PWP_UINT64 end = begin + PWP_UINT64(nNodes) * dim *
+        realChars(rti);
+    if ((off_t)begin != lseek(sink->fd(), 0, SEEK_CUR) ||
+            (off_t)end != lseek(sink->fd(), (off_t)end, SEEK_SET) ||
+            !sink->resumeAt(end)) {
+        return false;
+    }
+    const PWGM_HGRIDMODEL model = rti.model;
+    const SurfaceNodes *surface = (rti.data->boundaryOnly ?
+        &rti.data->surfaceNodes : nullptr);
+    const bool single = (0 != CAEPU_RT_PREC_SINGLE(&rti));
+    FluentApiStats *apiStats = rti.data->apiStats;
+    writer->start(new FluentPwriteSink(sink->fd(), begin,
+        rti.data->bufferSize), [=](FluentSink &out,
+            const std::atomic<bool> &cancelled) {
+        FluentApiStats::countWorker(apiStats, FluentApiStats::Nodes);
+        return writeNodeCoords(out, cancelled, model, surface, nNodes,
+            single, dim);
+    });
     return true;
+#else
+    (void)rti;
+    (void)nNodes;
+    (void)dim;
+    return false;
+#endif
 }
 
 
@@ -610,97 +1364,233 @@ writeHeader(CAEP_RTITEM &rti, PWP_UINT32 nFaces, PWP_UINT32 nBFaces,
 static bool
 writeVerts(CAEP_RTITEM &rti, const PWP_UINT32 nNodes)
 {
+    FluentApiPhase apiPhase(FluentApiStats::Verts);
     const PWP_UINT32 dim = (CAEPU_RT_DIM_2D(&rti) ? 2 : 3);
+    beginHashSection(rti, "nodes", rti.data->zone + 1);
     writeComment(rti, "Zone %u  Number of Nodes : %u", ++rti.data->zone,
         nNodes);
+    const PWP_UINT64 offset = rti.data->sink->tell();
     // (10 (1 1 NumNodesHex 1 dim)(
-    fprintf(rti.fp, "(%d (1 1 %x 1 %u)(\n", FLUENT_NODES, nNodes, dim);
-    if (caeuProgressBeginStep(&rti, nNodes)) {
+    rti.data->sink->print("(%d (1 1 %x 1 %u)(\n", FLUENT_NODES, nNodes, dim);
+    FluentCffWriter *cff = rti.data->cff;
+    const bool writeText = rti.data->writeText &&
+        (nullptr == rti.data->countingSink);
+    const bool surface = rti.data->boundaryOnly;
+    const SurfaceNodes &nodes = rti.data->surfaceNodes;
+    if (nullptr != rti.data->countingSink) {
+        // Every coordinate is written with a fixed width plus a separator.
+        // Count them without formatting.
+        rti.data->countingSink->skip(PWP_UINT64(nNodes) * dim *
+            realChars(rti));
+    }
+    const bool single = (0 != CAEPU_RT_PREC_SINGLE(&rti));
+    if (writeText && startNodeWriter(rti, nNodes, dim)) {
+        // The coordinates are written meanwhile. The step ends at once as
+        // for a resumed export.
+        if (progressBeginStep(rti, 1)) {
+            caeuProgressEndStep(&rti);
+        }
+    }
+    else if ((writeText || nullptr != cff) &&
+            progressBeginStep(rti, nNodes)) {
+        FluentPerfScope perfScope(rti.data->perf, FluentPerf::Verts);
+        if (nullptr != rti.data->perf) {
+            rti.data->perf->addItems(FluentPerf::Verts, nNodes);
+        }
+        if (nullptr != cff) {
+            cff->beginNodes(rti.data->zone, nNodes);
+        }
         PWGM_VERTDATA vertData;
-        for (PWP_UINT32 ii = 0; ii < nNodes; ++ii) {
-            PwVertDataMod(PwModEnumVertices(rti.model, ii), &vertData);
-            writeReal(rti, vertData.x, "", "");
-            if (2 == dim) {
-                // Write XY only for 2-D export
-                writeReal(rti, vertData.y, " ", "\n");
-            }
-            else {
-                // Write XYZ for 3-D export
-                writeReal(rti, vertData.y, " ", "");
-                writeReal(rti, vertData.z, " ", "\n");
-            }
-            if (!caeuProgressIncr(&rti)) {
-                break;
+        bool ok = true;
+        for (PWP_UINT32 first = 0; ok && first < nNodes;
+                first += VertChunkSize) {
+            const PWP_UINT32 last = std::min(nNodes, first + VertChunkSize);
+            FluentTraceSpan span(rti.data->trace, "writeVerts");
+            span.arg("first", first + 1);
+            span.arg("count", last - first);
+            for (PWP_UINT32 ii = first; ii < last; ++ii) {
+                PwVertDataMod(PwModEnumVertices(rti.model,
+                    surface ? nodes[ii] : ii), &vertData);
+                if (nullptr != cff) {
+                    cff->addNode(vertData.x, vertData.y, vertData.z);
+                }
+                if (writeText) {
+                    writeNode(*rti.data->sink, single, dim, vertData);
+                }
+                if (!progressIncr(rti)) {
+                    ok = false;
+                    break;
+                }
             }
         }
+        if (nullptr != cff) {
+            cff->endNodes();
+        }
         caeuProgressEndStep(&rti);
     }
     // Close out nodes section
     writeSectionListFtr(rti);
-    return true;
+    addIndexEntry(rti, FLUENT_NODES, 1, nNodes, offset,
+        rti.data->sink->tell() - offset, "", "");
+    return !CAEPU_RT_IS_ABORTED(&rti);
 }
 
 
 static void
-writeZoneEnd(CAEP_RTITEM &rti, std::string condType, std::string condName)
+writeZoneSection(CAEP_RTITEM &rti, const PWP_UINT32 zone,
+    std::string condType, std::string condName)
 {
     // Make zone names safe for fluent write
     makeSafe(condType, '-');
     makeSafe(condName, '_');
     // (45 (3 interior interior-3)())
-    writeSectionLine(rti, FLUENT_ZONE, "%d %s %s", rti.data->zone,
-        condType.c_str(), condName.c_str());
+    writeSectionLine(rti, FLUENT_ZONE, "%d %s %s", zone, condType.c_str(),
+        condName.c_str());
+}
+
+
+// Ends the current zone with its zone section. The mesh file of a MeshCache
+// export records the zone's kind and ids instead, and its zone section is
+// written to the case file by writeMeshZoneLayer().
+static void
+writeZoneEnd(CAEP_RTITEM &rti, std::string condType, std::string condName,
+    const FluentMeshZones::Kind kind, const PWP_UINT32 id,
+    const PWP_UINT32 id2 = PWP_BADID)
+{
+    if (nullptr != rti.data->meshZones) {
+        rti.data->meshZones->add(rti.data->zone, kind, id, id2);
+    }
+    else {
+        writeZoneSection(rti, rti.data->zone, condType, condName);
+    }
+}
+
+
+// Temporarily sends the writer helpers' output to another sink
+class ScopedSinkRedirect {
+public:
+    ScopedSinkRedirect(CAEP_RTITEM &rti, FluentSink &sink) :
+        rti_(rti),
+        prev_(rti.data->sink)
+    {
+        rti_.data->sink = &sink;
+    }
+
+    ~ScopedSinkRedirect()
+    {
+        rti_.data->sink = prev_;
+    }
+
+private:
+    CAEP_RTITEM    &rti_;
+    FluentSink     *prev_;
+};
+
+
+// Finish the open face zone of the HDF5 case file, if any
+static void
+closeCffFaceZone(CAEP_RTITEM &rti, const PWP_UINT32 bcType,
+    std::string name)
+{
+    if (nullptr != rti.data->cff) {
+        makeSafe(name, '_');
+        rti.data->cff->endFaceZone(rti.data->faceStartIndex,
+            rti.data->faceIndex - 1, bcType, rti.data->vcCellType, name);
+    }
 }
 
 
 static void
 writeCloseFaceZone(CAEP_RTITEM &rti, const PWGM_ENUM_FACETYPE faceType)
 {
+    FluentTraceSpan span(rti.data->trace, "writeCloseFaceZone");
+    FluentApiPhase apiPhase(FluentApiStats::CloseFaceZone);
+    span.arg("zone", rti.data->zone);
     writeFacesListFtr(rti);
 
-    sysFILEPOS eof;
-    pwpFileGetpos(rti.fp, &eof);
-
     const PWP_UINT faceCnt = rti.data->faceIndex - rti.data->faceStartIndex;
+    // The face section starts with the header line reserved at indexPos2
+    PWP_UINT64 sectionOffset = rti.data->indexPos2;
+    const PWP_UINT64 sectionLength = rti.data->sink->tell() - sectionOffset;
+
+    PWGM_CONDDATA condData;
+    if (PWGM_FACETYPE_BOUNDARY == faceType) {
+        getSafeBC(rti, rti.data->prevDom, condData);
+    }
 
-    // write the zone comment line
-    pwpFileSetpos(rti.fp, &rti.data->indexPos1);
+    // Format the zone comment line and the header. They replace the blank
+    // lines reserved by writeOpenFaceZone().
+    FluentMemorySink comment;
+    FluentMemorySink header;
     switch (faceType) {
     case PWGM_FACETYPE_BOUNDARY: {
-        PWGM_CONDDATA condData;
-        getSafeBC(rti, rti.data->prevDom, condData);
+        if (nullptr != rti.data->meshZones) {
+            // A mesh file does not depend on the BCs. Its zone sections in
+            // the case file name and type the zone.
+            ScopedSinkRedirect redirect(rti, comment);
+            writeCommentNoCR(rti, "Zone %d %u faces %u..%u, BC",
+                rti.data->zone, faceCnt, rti.data->faceStartIndex,
+                rti.data->faceIndex - 1);
+            ScopedSinkRedirect redirect2(rti, header);
+            writeFacesListHdr(rti, FLUENT_WALL);
+            break;
+        }
         std::string convertedType = condData.type;
         makeSafe(convertedType, '-');
+        ScopedSinkRedirect redirect(rti, comment);
         writeCommentNoCR(rti, "Zone %d %u faces %u..%u, BC: %0.40s %s = %u",
             rti.data->zone, faceCnt, rti.data->faceStartIndex,
             rti.data->faceIndex - 1, condData.name, convertedType.c_str(),
             condData.tid);
+        ScopedSinkRedirect redirect2(rti, header);
+        writeFacesListHdr(rti, condData.tid);
         break; }
     case PWGM_FACETYPE_INTERIOR:
-    case PWGM_FACETYPE_CONNECTION:
+    case PWGM_FACETYPE_CONNECTION: {
+        ScopedSinkRedirect redirect(rti, comment);
         writeCommentNoCR(rti, "Zone %d %u faces %u..%u, Interior",
             rti.data->zone, faceCnt, rti.data->faceStartIndex,
             rti.data->faceIndex - 1);
-        break;
+        ScopedSinkRedirect redirect2(rti, header);
+        writeFacesListHdr(rti, FLUENT_INTERIOR);
+        break; }
     default:
         break;
     }
+    // A failed patch has failed the export
+    bool patched = patchReservedLine(rti, rti.data->indexPos1, comment,
+        ZoneCommentLen);
+    patched = patchReservedLine(rti, rti.data->indexPos2, header,
+        ZoneHeaderLen) && patched;
+    if (nullptr == rti.data->zoneSink && nullptr != rti.data->hashSink) {
+        rti.data->hashSink->release(rti.data->indexPos1);
+    }
 
-    // Close specific Face zone by first finishing header, and then writing
-    // face zone close.
-    pwpFileSetpos(rti.fp, &rti.data->indexPos2);
-    switch (faceType) {
-    case PWGM_FACETYPE_BOUNDARY: {
-        PWGM_CONDDATA condData;
-        getSafeBC(rti, rti.data->prevDom, condData);
-        writeFacesListHdr(rti, condData.tid);
-        pwpFileSetpos(rti.fp, &eof);
-        writeZoneEnd(rti, condData.type, condData.name);
-        break; }
+    if (nullptr != rti.data->zoneSink) {
+        // The zone is complete. Move it from the stage to the export's sink.
+        FluentMemorySink &stage = *rti.data->zoneStage;
+        const bool staged = checkZoneStage(rti);
+        rti.data->sink = rti.data->zoneSink;
+        rti.data->zoneSink = nullptr;
+        sectionOffset += rti.data->sink->tell();
+        if (staged && patched) {
+            rti.data->sink->write(stage.data(), stage.size());
+        }
+        stage.clear();
+    }
+
+    // Close specific Face zone
+    switch (faceType) {
+    case PWGM_FACETYPE_BOUNDARY:
+        addIndexEntry(rti, FLUENT_FACES, rti.data->faceStartIndex,
+            rti.data->faceIndex - 1, sectionOffset, sectionLength,
+            condData.type, condData.name);
+        closeCffFaceZone(rti, condData.tid, condData.name);
+        writeZoneEnd(rti, condData.type, condData.name,
+            FluentMeshZones::Boundary, PWGM_HDOMAIN_ID(rti.data->prevDom));
+        break;
     case PWGM_FACETYPE_CONNECTION:
     case PWGM_FACETYPE_INTERIOR: {
-        writeFacesListHdr(rti, FLUENT_INTERIOR);
-        pwpFileSetpos(rti.fp, &eof);
         // Grab the current VC name from the block to VC cache
         std::string zoneName = "interior-";
         const BlockVCMap &blockToVCs = rti.data->blockVCMap;
@@ -715,11 +1605,29 @@ writeCloseFaceZone(CAEP_RTITEM &rti, const PWGM_ENUM_FACETYPE faceType)
                 zoneName.append(mIter->second.first.name);
             }
         }
-        writeZoneEnd(rti, "interior", zoneName.c_str());
+        addIndexEntry(rti, FLUENT_FACES, rti.data->faceStartIndex,
+            rti.data->faceIndex - 1, sectionOffset, sectionLength, "interior",
+            zoneName);
+        closeCffFaceZone(rti, FLUENT_INTERIOR, zoneName);
+        writeZoneEnd(rti, "interior", zoneName.c_str(),
+            FluentMeshZones::Interior, rti.data->prevVCId,
+            rti.data->prevNeighborVCId);
         break; }
     default:
         break;
     }
+
+    FluentTrace *trace = rti.data->trace;
+    if (trace->enabled()) {
+        // The zone's span covers all of its faces, from open to close
+        const FluentTrace::Arg args[] = {
+            { "zone", rti.data->zone },
+            { "faces", faceCnt },
+            { "type", (PWP_UINT64)faceType }
+        };
+        trace->complete("faceZone", rti.data->zoneTraceBegin, trace->now(),
+            args, ARRAYSIZE(args));
+    }
 }
 
 
@@ -730,11 +1638,32 @@ writeOpenFaceZone(CAEP_RTITEM &rti)
     // writing faces. Write one blank line for the zone comment and one for the
     // zone header. Theses lines will be replaced by writeCloseFaceZone() once
     // all faces have been streamed.
-    fprintf(rti.fp, "\n");
-    pwpFileGetpos(rti.fp, &rti.data->indexPos1);
-    writeBlankLine(rti, 128);
-    pwpFileGetpos(rti.fp, &rti.data->indexPos2);
-    writeBlankLine(rti, 50);
+    FluentTraceSpan span(rti.data->trace, "writeOpenFaceZone");
+    span.arg("zone", rti.data->zone);
+    if (rti.data->trace->enabled()) {
+        rti.data->zoneTraceBegin = rti.data->trace->now();
+    }
+    if (nullptr != rti.data->cff) {
+        rti.data->cff->beginFaceZone(rti.data->zone);
+    }
+    beginHashSection(rti, "faces", rti.data->zone);
+    if (!rti.data->sink->isPatchable()) {
+        // The blank lines cannot be replaced in the export's sink. Stage the
+        // zone in memory until it is closed.
+        rti.data->zoneSink = rti.data->sink;
+        rti.data->zoneStage->clear();
+        rti.data->sink = rti.data->zoneStage;
+    }
+    rti.data->sink->write("\n", 1);
+    if (rti.data->sink == rti.data->hashSink) {
+        // The lines are patched in place. Hold them open in the digests.
+        rti.data->hashSink->hold(rti.data->sink->tell(),
+            ZoneCommentLen + ZoneHeaderLen + 2);
+    }
+    rti.data->indexPos1 = rti.data->sink->tell();
+    writeBlankLine(rti, ZoneCommentLen);
+    rti.data->indexPos2 = rti.data->sink->tell();
+    writeBlankLine(rti, ZoneHeaderLen);
 }
 
 
@@ -751,9 +1680,12 @@ isNewBCGroup(const CAEP_RTITEM &rti) {
 static void
 processBlockVCMap(CAEP_RTITEM &rti)
 {
+    FluentTraceSpan span(rti.data->trace, "processBlockVCMap");
+    FluentApiPhase apiPhase(FluentApiStats::BlockVCMap);
     const PWP_UINT32 blockCount = PwModBlockCount(rti.model);
 
-    for (PWP_UINT32 blockIndex = 0; blockIndex < blockCount; ++blockIndex) {
+    for (PWP_UINT32 blockIndex = 0; blockIndex < blockCount &&
+            !pollAbort(rti); ++blockIndex) {
         PWGM_HBLOCK hBlk = PwModEnumBlocks(rti.model, blockIndex);
         PWGM_CONDDATA condData;
         PWGM_ELEMCOUNTS elemCnts;
@@ -765,18 +1697,19 @@ processBlockVCMap(CAEP_RTITEM &rti)
         // Need to add new vector for this vc
         if (rti.data->blockVCMap.end() == mIter) {
             // first block
+            FluentArena &arena = *rti.data->arena;
             VCGroupStats stats = {
                 nBlkCells,
                 elemTypes,
                 condData.tid,
-                condData.type,
-                condData.name
+                arena.copy(condData.type, FluentArena::VCNames),
+                arena.copy(condData.name, FluentArena::VCNames)
             };
-            VCBlocks blocks;
+            VCBlocks blocks(VCBlocks::allocator_type(&arena,
+                FluentArena::VCBlocks));
             blocks.push_back(blockIndex);
-            VCGroupData groupData(stats, blocks);
-            rti.data->blockVCMap.insert(
-                std::pair<PWP_UINT32, VCGroupData>(condData.id, groupData));
+            rti.data->blockVCMap.emplace(condData.id,
+                VCGroupData(stats, std::move(blocks)));
         }
         else {
             // Found existing
@@ -792,10 +1725,99 @@ processBlockVCMap(CAEP_RTITEM &rti)
 }
 
 
+// Appends the Fluent cell type of each cell of the blocks to types. The
+// blocks are enumerated until aborted() returns true. It is called for every
+// cell and must be cheap. Returns false if the types are incomplete.
+template<typename Blocks, typename Aborted>
+static bool
+collectCellTypes(PWGM_HGRIDMODEL model, const Blocks &blocks,
+    FluentCellTypeLists::Types &types, Aborted aborted)
+{
+    typename Blocks::const_iterator vIter = blocks.begin();
+    for(; vIter != blocks.end(); ++vIter) {
+        PWP_UINT32 cellndx = 0;
+        PWGM_HBLOCK hBlk = PwModEnumBlocks(model, *vIter);
+        PWGM_HELEMENT hElem = PwBlkEnumElements(hBlk, 0);
+        PWGM_ELEMDATA eData;
+        while (PWGM_HELEMENT_ISVALID(hElem)) {
+            if (aborted()) {
+                return false;
+            }
+            PwElemDataMod(hElem, &eData);
+            types.push_back((unsigned char)convertCellType(eData.type));
+            hElem = PwBlkEnumElements(hBlk, ++cellndx);
+        }
+    }
+    return true;
+}
+
+
+// Starts making the cell type lists of the mixed VCs on the worker of
+// rti.data->cellTypeLists, in the order of their first block. That is the
+// order the faces stream them in.
+static void
+startCellTypeLists(CAEP_RTITEM &rti)
+{
+    FluentCellTypeLists *lists = rti.data->cellTypeLists;
+    if (nullptr == lists || CAEPU_RT_IS_ABORTED(&rti)) {
+        return;
+    }
+    // The worker gets its own copy of the block lists
+    std::map<PWP_UINT32, std::vector<PWP_UINT32> > vcBlocks;
+    std::vector<std::pair<PWP_UINT32, PWP_UINT32> > order;
+    BlockVCMap::const_iterator mIter = rti.data->blockVCMap.begin();
+    for (; rti.data->blockVCMap.end() != mIter; ++mIter) {
+        const VCBlocks &blocks = mIter->second.second;
+        if (0 == mIter->second.first.elemTypes && !blocks.empty()) {
+            vcBlocks[mIter->first].assign(blocks.begin(), blocks.end());
+            order.push_back(std::make_pair(blocks.front(), mIter->first));
+        }
+    }
+    if (order.empty()) {
+        return;
+    }
+    std::sort(order.begin(), order.end());
+    std::vector<PWP_UINT32> vcIds;
+    for (size_t i = 0; i < order.size(); ++i) {
+        vcIds.push_back(order[i].second);
+    }
+    FluentTraceSpan span(rti.data->trace, "startCellTypeLists");
+    span.arg("zones", vcIds.size());
+    const PWGM_HGRIDMODEL model = rti.model;
+    FluentApiStats *apiStats = rti.data->apiStats;
+    lists->start(vcIds, [model, vcBlocks, apiStats](PWP_UINT32 vcId,
+            FluentCellTypeLists::Types &types,
+            const std::atomic<bool> &cancelled) {
+        FluentApiStats::countWorker(apiStats, FluentApiStats::CellTypes);
+        const std::vector<PWP_UINT32> &blocks = vcBlocks.find(vcId)->second;
+        return collectCellTypes(model, blocks, types,
+            [&cancelled]() { return bool(cancelled); });
+    });
+}
+
+
+// Moves the cell types of VC vcId made by the worker to types and their
+// section text to text. Returns false if there is no worker or it did not
+// make them.
+static bool
+takeCellTypes(CAEP_RTITEM &rti, const PWP_UINT32 vcId,
+    FluentCellTypeLists::Types &types, std::string &text)
+{
+    FluentCellTypeLists *lists = rti.data->cellTypeLists;
+    if (nullptr == lists || !lists->started()) {
+        return false;
+    }
+    // The span shows how long the export waited for the worker
+    FluentTraceSpan span(rti.data->trace, "takeCellTypes");
+    return lists->take(vcId, types, text);
+}
+
+
 // Write the Cell zone section FLUENT_CELLS(12)
 static const VCGroupStats*
 writeVCZone(CAEP_RTITEM &rti, const PWP_UINT32 &vcId)
 {
+    FluentApiPhase apiPhase(FluentApiStats::VCZone);
     const VCGroupStats *grpStats = NULL;
     const BlockVCMap &blockToVCs = rti.data->blockVCMap;
     // Write all block headers
@@ -803,99 +1825,346 @@ writeVCZone(CAEP_RTITEM &rti, const PWP_UINT32 &vcId)
     if (blockToVCs.end() != mIter && !CAEPU_RT_IS_ABORTED(&rti)) {
         const VCGroupData *groupData = &(mIter->second);
         grpStats = &(groupData->first);
-        VCBlocks blocks = groupData->second;
+        const VCBlocks &blocks = groupData->second;
+
+        FluentTraceSpan span(rti.data->trace, "writeVCZone");
+        span.arg("zone", rti.data->zone);
+        span.arg("cells", grpStats->groupBlkCells);
+        span.arg("mixed", (0 == grpStats->elemTypes));
+        FluentPerfScope perfScope(rti.data->perf, FluentPerf::Cells);
 
         // Write block comment lines
-        fprintf(rti.fp, "\n");
-        writeComment(rti, "Zone %u %u cells %u..%u, VC: %0.40s %s = %i",
-            rti.data->zone, grpStats->groupBlkCells, rti.data->blockIndex,
-            rti.data->blockIndex + grpStats->groupBlkCells - 1,
-            grpStats->name.c_str(), grpStats->type.c_str(), (int)vcId);
+        beginHashSection(rti, "cells", rti.data->zone);
+        FluentSink &out = *rti.data->sink;
+        out.print("\n");
+        if (nullptr != rti.data->meshZones) {
+            // The VC's name and type are in the case file
+            writeComment(rti, "Zone %u %u cells %u..%u, VC = %i",
+                rti.data->zone, grpStats->groupBlkCells,
+                rti.data->blockIndex,
+                rti.data->blockIndex + grpStats->groupBlkCells - 1,
+                (int)vcId);
+        }
+        else {
+            writeComment(rti, "Zone %u %u cells %u..%u, VC: %0.40s %s = %i",
+                rti.data->zone, grpStats->groupBlkCells,
+                rti.data->blockIndex,
+                rti.data->blockIndex + grpStats->groupBlkCells - 1,
+                grpStats->name, grpStats->type, (int)vcId);
+        }
 
         // Write fluent Cell line
-        fprintf(rti.fp, "(%d (%x %x %x 1 %x", FLUENT_CELLS, rti.data->zone, 
+        const PWP_UINT64 offset = out.tell();
+        out.print("(%d (%x %x %x 1 %x", FLUENT_CELLS, rti.data->zone,
             rti.data->blockIndex,
             rti.data->blockIndex + grpStats->groupBlkCells - 1,
             grpStats->elemTypes);
 
+        FluentCffWriter *cff = rti.data->cff;
+        if (nullptr != cff) {
+            std::string name = grpStats->name;
+            makeSafe(name, '_');
+            cff->beginCellZone(rti.data->zone, rti.data->blockIndex,
+                rti.data->blockIndex + grpStats->groupBlkCells - 1,
+                grpStats->elemTypes, name);
+        }
+
         // If mixed, write cell type list
         if (0 == grpStats->elemTypes) {
-            fprintf(rti.fp, ")(\n");
-            PWP_UINT column = 0;
-            VCBlocks::iterator vIter = blocks.begin();
-            for(; vIter != blocks.end(); ++vIter) {
-                PWP_UINT32 cellndx = 0;
-                PWGM_HBLOCK hBlk = PwModEnumBlocks(rti.model, *vIter);
-                PWGM_HELEMENT hElem = PwBlkEnumElements(hBlk, 0);
-                PWGM_ELEMDATA eData;
-                while (PWGM_HELEMENT_ISVALID(hElem) &&
-                        !CAEPU_RT_IS_ABORTED(&rti)) {
-                    PwElemDataMod(hElem, &eData);
-                    if (9 == column) {
-                        fprintf(rti.fp, "\n");
-                        column = 1;
-                    }
-                    else {
-                        ++column;
-                    }
-                    fprintf(rti.fp, " %x", convertCellType(eData.type));
-                    hElem = PwBlkEnumElements(hBlk, ++cellndx);
+            out.print(")(\n");
+            FluentCellTypeLists::Types types;
+            std::string text;
+            if (!takeCellTypes(rti, vcId, types, text)) {
+                types.clear();
+                collectCellTypes(rti.model, blocks, types,
+                    [&rti]() { return pollAbort(rti); });
+                fluentFormatCellTypes(types, text);
+            }
+            if (nullptr != rti.data->perf) {
+                // Only the cells of mixed zones are visited
+                rti.data->perf->addItems(FluentPerf::Cells, types.size());
+            }
+            out.write(text.data(), text.size());
+            if (nullptr != cff) {
+                for (size_t ndx = 0; ndx < types.size(); ++ndx) {
+                    cff->addCellType(types[ndx]);
                 }
             }
-            fprintf(rti.fp, "\n");
+        }
+        if (nullptr != cff) {
+            cff->endCellZone();
         }
         writeSectionListFtr(rti);
+        const CellZone cellZone = { rti.data->zone, rti.data->blockIndex,
+            rti.data->blockIndex + grpStats->groupBlkCells - 1 };
+        rti.data->cellZones.push_back(cellZone);
+        addIndexEntry(rti, FLUENT_CELLS, cellZone.firstCell, cellZone.lastCell,
+            offset, out.tell() - offset, grpStats->type, grpStats->name);
         rti.data->blockIndex += grpStats->groupBlkCells;
-        writeZoneEnd(rti, grpStats->type, grpStats->name);
+        writeZoneEnd(rti, grpStats->type, grpStats->name,
+            FluentMeshZones::Cell, vcId);
     }
     return grpStats;
 }
 
 
+// Checkpoints the export at a face zone boundary if the Checkpoint interval
+// was written since the last checkpoint, or if force is true. ordinal is the
+// number of streamed faces in the file, and prevBlk the block to restore
+// for the face that follows. The new bytes are read back from the part file
+// for the digest, and are synced before the record is replaced.
+static void
+takeCheckpoint(CAEP_RTITEM &rti, const PWP_UINT64 ordinal,
+    const PWGM_HBLOCK &prevBlk, const bool force)
+{
+    CheckpointState *ckpt = rti.data->checkpoint;
+    if (nullptr == ckpt || !ckpt->enabled || CAEPU_RT_IS_ABORTED(&rti)) {
+        return;
+    }
+    FluentSink &out = *rti.data->sink;
+    const PWP_UINT64 length = out.tell();
+    if (!force && length < ckpt->hash.length() + ckpt->interval) {
+        return;
+    }
+    FluentTraceSpan span(rti.data->trace, "checkpoint");
+    span.arg("bytes", length);
+    bool ok = out.flush();
+#if !defined(WINDOWS)
+    std::vector<char> buf(FluentChunkHash::ChunkSize);
+    while (ok && ckpt->hash.length() < length) {
+        const size_t n = size_t(std::min<PWP_UINT64>(buf.size(),
+            length - ckpt->hash.length()));
+        const ssize_t got = pread(ckpt->fd, buf.data(), n,
+            (off_t)ckpt->hash.length());
+        ok = (0 < got);
+        if (ok) {
+            ckpt->hash.append(buf.data(), size_t(got));
+        }
+    }
+    ok = ok && (0 == fsync(ckpt->fd));
+#endif
+
+    const FLUENT_DATA &data = *rti.data;
+    FluentCheckpoint rec;
+    rec.fingerprint = ckpt->fingerprint;
+    rec.length = length;
+    rec.digest = ckpt->hash.digest();
+    rec.ordinal = ordinal;
+    rec.zone = data.zone;
+    rec.faceIndex = data.faceIndex;
+    rec.faceStartIndex = data.faceStartIndex;
+    rec.blockIndex = data.blockIndex;
+    rec.prevFaceType = PWP_UINT32(data.prevFaceType);
+    rec.prevDom = PWGM_HDOMAIN_ISVALID(data.prevDom) ?
+        PWGM_HDOMAIN_ID(data.prevDom) : PWP_BADID;
+    rec.prevBlk = PWGM_HBLOCK_ISVALID(prevBlk) ? PWGM_HBLOCK_ID(prevBlk) :
+        PWP_BADID;
+    rec.vcCellType = data.vcCellType;
+    rec.prevVCId = data.prevVCId;
+    rec.prevNeighborVCId = data.prevNeighborVCId;
+    rec.cellCount = data.cellCount;
+    for (size_t i = 0; i < data.cellZones.size(); ++i) {
+        const FluentCheckpoint::CellZone cz = { data.cellZones[i].zone,
+            data.cellZones[i].firstCell, data.cellZones[i].lastCell };
+        rec.cellZones.push_back(cz);
+    }
+    if (!ok || !rec.write(ckpt->recordFile.c_str())) {
+        caeuSendWarningMsg(&rti, "Could not write the export checkpoint. "
+            "Checkpointing is off.", 0);
+        ckpt->enabled = false;
+    }
+}
+
+
+// Restores the exporter state of the resumed checkpoint. The faces it holds
+// are skipped by faceCB().
+static void
+restoreCheckpoint(CAEP_RTITEM &rti)
+{
+    FLUENT_DATA &data = *rti.data;
+    const FluentCheckpoint &rec = data.checkpoint->resume;
+    data.zone = rec.zone;
+    data.faceIndex = rec.faceIndex;
+    data.faceStartIndex = rec.faceStartIndex;
+    data.blockIndex = rec.blockIndex;
+    data.prevFaceType = PWGM_ENUM_FACETYPE(rec.prevFaceType);
+    if (PWP_BADID == rec.prevDom) {
+        PWGM_HDOMAIN_SET_INVALID(data.prevDom);
+    }
+    else {
+        data.prevDom = PwModEnumDomains(rti.model, rec.prevDom);
+    }
+    data.currDom = data.prevDom;
+    if (PWP_BADID == rec.prevBlk) {
+        PWGM_HBLOCK_SET_INVALID(data.prevBlk);
+    }
+    else {
+        data.prevBlk = PwModEnumBlocks(rti.model, rec.prevBlk);
+    }
+    data.vcCellType = rec.vcCellType;
+    data.prevVCId = rec.prevVCId;
+    data.prevNeighborVCId = rec.prevNeighborVCId;
+    data.cellCount = rec.cellCount;
+    for (size_t i = 0; i < rec.cellZones.size(); ++i) {
+        const CellZone cz = { rec.cellZones[i].zone,
+            rec.cellZones[i].firstCell, rec.cellZones[i].lastCell };
+        data.cellZones.push_back(cz);
+    }
+    data.batchOrdinal = rec.ordinal;
+    data.checkpoint->skipFaces = rec.ordinal;
+}
+
+
+// Collects the vertices of the domain elements of a boundary only export.
+// They are all the vertices its faces reference.
+static void
+collectSurfaceNodes(CAEP_RTITEM &rti)
+{
+    FluentTraceSpan span(rti.data->trace, "collectSurfaceNodes");
+    SurfaceNodes &nodes = rti.data->surfaceNodes;
+    const PWP_UINT32 domainCount = PwModDomainCount(rti.model);
+    PWGM_ELEMCOUNTS ec;
+    PWP_UINT64 nElems = 0;
+    for (PWP_UINT32 ndx = 0; ndx < domainCount; ++ndx) {
+        nElems += PwDomElementCount(PwModEnumDomains(rti.model, ndx), &ec);
+    }
+    nodes.reserve(size_t(4 * nElems));
+    PWGM_ELEMDATA eData;
+    for (PWP_UINT32 ndx = 0; ndx < domainCount; ++ndx) {
+        PWGM_HDOMAIN hDom = PwModEnumDomains(rti.model, ndx);
+        PWP_UINT32 elemNdx = 0;
+        PWGM_HELEMENT hElem = PwDomEnumElements(hDom, 0);
+        while (PWGM_HELEMENT_ISVALID(hElem) && !pollAbort(rti)) {
+            PwElemDataMod(hElem, &eData);
+            nodes.insert(nodes.end(), eData.index, eData.index +
+                eData.vertCnt);
+            hElem = PwDomEnumElements(hDom, ++elemNdx);
+        }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    span.arg("nodes", nodes.size());
+}
+
+
+// Starts the perf phase of the face stream. It runs from the end of beginCB()
+// to the last batch of endCB(), so it covers every faceCB() call and the grid
+// model between the calls.
+static void
+startFaceStreamPerf(CAEP_RTITEM &rti)
+{
+    if (nullptr != rti.data->perf && rti.data->perf->enabled() &&
+            !rti.data->perfFaces) {
+        rti.data->perf->start(FluentPerf::Faces);
+        rti.data->perfFaces = true;
+    }
+}
+
+
+// Stops the perf phase of the face stream if it is running
+static void
+stopFaceStreamPerf(CAEP_RTITEM &rti)
+{
+    if (rti.data->perfFaces) {
+        rti.data->perf->stop();
+        rti.data->perfFaces = false;
+    }
+}
+
+
 // Invoked once by PwModStreamFaces() before the first face is streamed.
 PWP_UINT32
 beginCB(PWGM_BEGINSTREAM_DATA *data)
 {
     CAEP_RTITEM &rti = *((CAEP_RTITEM*)data->userData);
-    PWP_UINT32 nNodes;
-    bool result = writeHeader(rti, data->totalNumFaces, data->numBoundaryFaces,
-        nNodes) && writeVerts(rti, nNodes);
+    FluentTraceSpan span(rti.data->trace, "beginCB");
+    // The API calls of the stream are charged to faceCB unless a function
+    // below charges them to its own phase
+    FluentApiStats::setCurrentPhase(FluentApiStats::Faces);
+    span.arg("faces", data->totalNumFaces);
+    const CheckpointState *ckpt = rti.data->checkpoint;
+    const bool resumed = (nullptr != ckpt) && ckpt->resumed;
+    if (rti.data->boundaryOnly) {
+        collectSurfaceNodes(rti);
+    }
+    if (rti.data->mergeBCZones) {
+        loadDomainBCs(rti);
+    }
+    bool result;
+    if (resumed) {
+        // The header and the nodes are in the resumed file already
+        restoreCheckpoint(rti);
+        result = progressBeginStep(rti, 1) && caeuProgressEndStep(&rti);
+    }
+    else {
+        PWP_UINT32 nNodes;
+        result = writeHeader(rti, data->totalNumFaces,
+            data->numBoundaryFaces, nNodes) && writeVerts(rti, nNodes);
+    }
     if (result) {
         // Process blocks to VC Map. Blocks in the same VC are added to a
         // vector. Those vectors are stored in a map where the VCId is the key.
         processBlockVCMap(rti);
+        startCellTypeLists(rti);
+        if (!resumed) {
+            takeCheckpoint(rti, 0, rti.data->prevBlk, true);
+        }
     }
-    return result && caeuProgressBeginStep(&rti, data->totalNumFaces);
+    if (nullptr != rti.data->cellGraph) {
+        rti.data->cellGraph->init(rti.data->cellCount);
+    }
+    rti.data->faceBatch.reserve(FaceBatchSize);
+    // Size the shadow face cache once instead of growing it by doubling
+    PWP_UINT64 nShadowFaces = countShadowFaces(rti);
+    if (rti.data->mergeBCZones) {
+        // The BC faces are cached with them
+        nShadowFaces += data->numBoundaryFaces;
+    }
+    if (0 != rti.data->shadowBudget) {
+        nShadowFaces = std::min(nShadowFaces, rti.data->shadowBudget /
+            sizeof(PWGM_FACESTREAM_DATA) + 1);
+    }
+    rti.data->shadowFaces.reserve(size_t(nShadowFaces));
+    startFaceStreamPerf(rti);
+    return result && progressBeginStep(rti, data->totalNumFaces);
 }
 
 
-// Invoked by PwModStreamFaces() for each face in the grid.
-PWP_UINT32
-faceCB(PWGM_FACESTREAM_DATA *face)
+// returns true if face f starts a new run of faces. Faces of a run share the
+// zone state of the run's first face, run0.
+static inline bool
+isNewFaceRun(const PWGM_FACESTREAM_DATA &run0, const PWGM_FACESTREAM_DATA &f)
 {
-    CAEP_RTITEM &rti = *((CAEP_RTITEM*)face->userData);
+    return PWGM_HBLOCK_ID(f.owner.block) != PWGM_HBLOCK_ID(run0.owner.block) ||
+        PWGM_HDOMAIN_ID(f.owner.domain) != PWGM_HDOMAIN_ID(run0.owner.domain) ||
+        faceTypesDiffer(f.type, run0.type);
+}
 
-    if ((PWGM_FACETYPE_CONNECTION == face->type) &&
-        PWGM_HDOMAIN_ISVALID(face->owner.domain)) {
-        // cache the shadow face for dumping in endCB().
-        rti.data->shadowFaces.push_back(*face);
-        return !PwuProgressQuit(rti.pApiData->apiInfo.name);
-    }
 
+// Runs the zone state machine for the first face of a run. Opens, closes and
+// writes zones as needed so that the whole run can be written to the open
+// face zone. ordinal is the number of faces streamed before the run. If
+// openZone is false, the run is cached instead and no face zone is opened.
+static void
+beginFaceRun(CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA &face,
+    const PWP_UINT64 ordinal, const bool openZone)
+{
+    // A resumed export replays this call from the state before it
+    const PWGM_HBLOCK entryBlk = rti.data->prevBlk;
     PWP_UINT32 currentVCId = rti.data->prevVCId;
     PWP_UINT32 currentNeighborVCId = rti.data->prevNeighborVCId;
 
-    rti.data->currDom = face->owner.domain;
+    rti.data->currDom = face.owner.domain;
 
     // For performance reasons, only check vc id when a new block is
     // encountered.
-    if (PWGM_HBLOCK_ID(face->owner.block) !=
+    if (PWGM_HBLOCK_ID(face.owner.block) !=
         PWGM_HBLOCK_ID(rti.data->prevBlk)) {
-        rti.data->prevBlk = face->owner.block;
+        rti.data->prevBlk = face.owner.block;
         PWGM_CONDDATA blkCondData;
-        PwBlkCondition(face->owner.block, &blkCondData);
+        PwBlkCondition(face.owner.block, &blkCondData);
         currentVCId = blkCondData.id;
-        currentNeighborVCId = getNeighborVCId(face);
+        currentNeighborVCId = getNeighborVCId(&face);
     }
 
     // 1. Close Header Zone if a header is open and
@@ -903,10 +2172,11 @@ faceCB(PWGM_FACESTREAM_DATA *face)
     // -> A new VC zone is to be written, or
     // -> A new BC type is to be written.
     if (rti.data->headerOpen) {
-        if (faceTypesDiffer(face->type, rti.data->prevFaceType) ||
+        if (faceTypesDiffer(face.type, rti.data->prevFaceType) ||
                 currentVCId != rti.data->prevVCId || isNewBCGroup(rti)) {
             writeCloseFaceZone(rti, rti.data->prevFaceType);
             rti.data->headerOpen = PWP_FALSE;
+            takeCheckpoint(rti, ordinal, entryBlk, false);
         }
     }
 
@@ -914,9 +2184,21 @@ faceCB(PWGM_FACESTREAM_DATA *face)
     // written.
     if (!rti.data->headerOpen && currentVCId != rti.data->prevVCId) {
         // VC zones are NOT written for connections.
-        if (PWGM_FACETYPE_CONNECTION != face->type) {
-            ++rti.data->zone;
-            const VCGroupStats *grpStats = writeVCZone(rti, currentVCId);
+        if (PWGM_FACETYPE_CONNECTION != face.type) {
+            const VCGroupStats *grpStats = nullptr;
+            if (rti.data->boundaryOnly) {
+                // No cell zones are written. The face types still follow
+                // the VC.
+                BlockVCMap::const_iterator mIter =
+                    rti.data->blockVCMap.find(currentVCId);
+                if (rti.data->blockVCMap.end() != mIter) {
+                    grpStats = &mIter->second.first;
+                }
+            }
+            else {
+                ++rti.data->zone;
+                grpStats = writeVCZone(rti, currentVCId);
+            }
             if (0 != grpStats) {
                 // Update vcCellType to the element types in the the current
                 // VC group.
@@ -939,111 +2221,2018 @@ faceCB(PWGM_FACESTREAM_DATA *face)
 
     // 3. Open face Header only if a there is no header. All faces must be
     // enclosed in a zone header/closer.
-    if (!rti.data->headerOpen) {
+    if (openZone && !rti.data->headerOpen) {
         ++rti.data->zone;
-        rti.data->prevFaceType = face->type;
+        rti.data->prevFaceType = face.type;
         writeOpenFaceZone(rti);
         rti.data->faceStartIndex = rti.data->faceIndex;
         rti.data->prevDom = rti.data->currDom;
         rti.data->headerOpen = PWP_TRUE;
     }
+}
+
+
+// Writes the batched faces. A tight scan splits the batch into runs of faces
+// from the same block, domain and face type. The zone state machine runs once
+// per run, and each run is formatted in bulk.
+static bool
+flushFaceBatch(CAEP_RTITEM &rti)
+{
+    FaceBatch &batch = rti.data->faceBatch;
+    const PWP_UINT32 cnt = PWP_UINT32(batch.size());
+    FluentTraceSpan span(rti.data->trace, "faceBatch");
+    span.arg("faces", cnt);
+    bool ok = true;
+    PWP_UINT32 runCnt = 0;
+    PWP_UINT32 runStart = 0;
+    while (ok && runStart < cnt) {
+        const PWGM_FACESTREAM_DATA &run0 = batch[runStart];
+        PWP_UINT32 runEnd = runStart + 1;
+        while (runEnd < cnt && !isNewFaceRun(run0, batch[runEnd])) {
+            ++runEnd;
+        }
+        beginFaceRun(rti, run0, rti.data->batchOrdinal + runStart, true);
+        ok = writeFaceRun(rti, &run0, runEnd - runStart, true);
+        runStart = runEnd;
+        ++runCnt;
+    }
+    span.arg("runs", runCnt);
+    rti.data->batchOrdinal += cnt;
+    batch.clear();
+    return checkSink(rti) && ok;
+}
+
+
+// Strict ordering of the shadow faces: by domain id, then by cell index,
+// then by cell-face index
+static bool
+shadowFaceLess(const PWGM_FACESTREAM_DATA &f1, const PWGM_FACESTREAM_DATA &f2)
+{
+    if (PWGM_HDOMAIN_ID(f1.owner.domain) != PWGM_HDOMAIN_ID(f2.owner.domain)) {
+        // primary sort by domain id
+        return PWGM_HDOMAIN_ID(f1.owner.domain) <
+            PWGM_HDOMAIN_ID(f2.owner.domain);
+    }
 
-    // 4. Write current face
-    writeOneFace(rti, *face);
-    ++rti.data->faceIndex;
+    if (f1.owner.cellIndex != f2.owner.cellIndex) {
+        // f1.owner.domain == f2.owner.domain
+        // secondary sort by cell index
+        return f1.owner.cellIndex < f2.owner.cellIndex;
+    }
 
-    return caeuProgressIncr(&rti);
+    // f1.owner.domain == f2.owner.domain AND
+    // f1.owner.cellIndex == f2.owner.cellIndex
+    // tertiary sort by cell-face index
+    return f1.owner.cellFaceIndex < f2.owner.cellFaceIndex;
 }
 
 
-// Invoked once by PwModStreamFaces() after last face is streamed.
-PWP_UINT32
-endCB(PWGM_ENDSTREAM_DATA *data) {
-    CAEP_RTITEM &rti = *((CAEP_RTITEM*) data->userData);
+// Strict ordering of the cached faces: by BC zone in a MergeBCZones export,
+// then as shadowFaceLess()
+struct CachedFaceLess {
+    explicit CachedFaceLess(const CAEP_RTITEM &rti) :
+        rti(rti)
+    {
+    }
 
-    if (rti.data->headerOpen) {
-        // Close out the last face zone
-        writeCloseFaceZone(rti, rti.data->prevFaceType);
-        rti.data->headerOpen = PWP_FALSE;
+    bool operator()(const PWGM_FACESTREAM_DATA &f1,
+        const PWGM_FACESTREAM_DATA &f2) const
+    {
+        if (rti.data->mergeBCZones) {
+            const DomainBCs &bcs = rti.data->domainBCs;
+            const PWP_UINT64 k1 = bcZoneKey(bcs, f1);
+            const PWP_UINT64 k2 = bcZoneKey(bcs, f2);
+            if (k1 != k2) {
+                return k1 < k2;
+            }
+        }
+        return shadowFaceLess(f1, f2);
     }
 
-    if (!rti.data->shadowFaces.empty()) {
-        // Deal with the cached shadow faces
-        ShadowFaces &faces = rti.data->shadowFaces;
-        // Sort shadow faces using a strict ordering
+    const CAEP_RTITEM &rti;
+};
+
+
+// Thrown by the comparator of sortShadowFaces() to stop the sort
+struct ShadowSortAborted {
+};
+
+
+// std::sort() with an abort check every 64K comparisons. An abort leaves the
+// faces in an unspecified order.
+template<typename Less>
+static void
+sortShadowFaces(CAEP_RTITEM &rti, ShadowFaces &faces, Less less)
+{
+    PWP_UINT32 cnt = 0;
+    try {
         std::sort(faces.begin(), faces.end(),
-            [](const PWGM_FACESTREAM_DATA &f1, const PWGM_FACESTREAM_DATA &f2)
+            [&](const PWGM_FACESTREAM_DATA &f1, const PWGM_FACESTREAM_DATA &f2)
             {
-                if (PWGM_HDOMAIN_ID(f1.owner.domain) !=
-                        PWGM_HDOMAIN_ID(f2.owner.domain)) {
-                    // primary sort by domain id
-                    return PWGM_HDOMAIN_ID(f1.owner.domain) <
-                        PWGM_HDOMAIN_ID(f2.owner.domain);
+                if (0 == (++cnt & 0xFFFF) && pollAbort(rti)) {
+                    throw ShadowSortAborted();
                 }
+                return less(f1, f2);
+            });
+    }
+    catch (const ShadowSortAborted &) {
+    }
+}
 
-                if (f1.owner.cellIndex != f2.owner.cellIndex) {
-                    // f1.owner.domain == f2.owner.domain
-                    // secondary sort by cell index
-                    return f1.owner.cellIndex < f2.owner.cellIndex;
-                }
 
-                // f1.owner.domain == f2.owner.domain AND
-                // f1.owner.cellIndex == f2.owner.cellIndex
-                // tertiary sort by cell-face index
-                return f1.owner.cellFaceIndex < f2.owner.cellFaceIndex;
-            });
+// Sorts the cached shadow faces and moves them to the spill file once they
+// fill the ShadowMemory budget. If the spill file cannot be written, the
+// faces stay in memory and the budget is dropped.
+static void
+spillShadowFaces(CAEP_RTITEM &rti)
+{
+    ShadowFaces &faces = rti.data->shadowFaces;
+    FluentTraceSpan span(rti.data->trace, "spillShadowFaces");
+    span.arg("faces", faces.size());
+    sortShadowFaces(rti, faces, CachedFaceLess(rti));
+    if (CAEPU_RT_IS_ABORTED(&rti)) {
+        return;
+    }
+    if (rti.data->shadowSpill->addRun(faces.data(), faces.size())) {
+        faces.clear();
+    }
+    else {
+        caeuSendWarningMsg(&rti, "Could not spill the shadow faces to a "
+            "temporary file. Keeping them in memory.", 0);
+        rti.data->shadowBudget = 0;
+    }
+}
 
-        // Init the domain tracking values used to detect zone transitions.
-        PWGM_HDOMAIN_SET_INVALID(rti.data->prevDom);
-        PWGM_HDOMAIN_SET_INVALID(rti.data->currDom);
-        ShadowFaces::iterator it = faces.begin();
-        for (; faces.end() != it; ++it) {
-            PWGM_FACESTREAM_DATA &face = *it;
-            rti.data->currDom = face.owner.domain;
-            if (PWGM_HDOMAIN_ID(rti.data->currDom) !=
-                    PWGM_HDOMAIN_ID(rti.data->prevDom)) {
-                // We have transitioned from one zone to the next
-                if (PWGM_HDOMAIN_ISVALID(rti.data->prevDom)) {
-                    // Close out the previous zone
-                    writeCloseFaceZone(rti, PWGM_FACETYPE_BOUNDARY);
-                }
-                rti.data->prevDom = rti.data->currDom;
-                ++rti.data->zone;
-                rti.data->faceStartIndex = rti.data->faceIndex;
-                writeOpenFaceZone(rti);
-            }
-            // Write the face to the current zone
-            writeOneFace(rti, face);
-            ++rti.data->faceIndex;
+
+// Adds the cell type of the VC of a cached face to its BC zone. The faces of
+// a block and BC zone share it, so it is only looked up when either changes.
+static void
+addBCZoneType(CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA &face)
+{
+    const PWP_UINT64 key = bcZoneKey(rti.data->domainBCs, face);
+    if (PWGM_HBLOCK_ID(face.owner.block) ==
+            PWGM_HBLOCK_ID(rti.data->bcTypeBlk) && key == rti.data->bcTypeKey) {
+        return;
+    }
+    rti.data->bcTypeBlk = face.owner.block;
+    rti.data->bcTypeKey = key;
+    PWGM_CONDDATA cond;
+    getSafeVC(rti, face.owner.block, cond);
+    BlockVCMap::const_iterator mIter = rti.data->blockVCMap.find(cond.id);
+    const PWP_UINT32 cellType = (rti.data->blockVCMap.end() != mIter) ?
+        mIter->second.first.elemTypes : PWP_UINT32(FLUENT_CELL_MIXED);
+    std::pair<BCZoneTypes::iterator, bool> ins =
+        rti.data->bcZoneTypes.emplace(key, cellType);
+    if (!ins.second && ins.first->second != cellType) {
+        // The zone borders cells of several types
+        ins.first->second = FLUENT_CELL_MIXED;
+    }
+}
+
+
+// Caches a face for endCB(). The cache is spilled once it fills the
+// ShadowMemory budget.
+static void
+cacheFace(CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA &face)
+{
+    if (rti.data->mergeBCZones) {
+        addBCZoneType(rti, face);
+    }
+    rti.data->shadowFaces.push_back(face);
+    if (0 != rti.data->shadowBudget && rti.data->shadowBudget <=
+            rti.data->shadowFaces.size() * sizeof(PWGM_FACESTREAM_DATA)) {
+        spillShadowFaces(rti);
+    }
+}
+
+
+// Runs the zone state machine for a BC face of a MergeBCZones export. The
+// face is cached, but it may still close the open face zone or start the
+// cells of the next VC. That is only checked for the first face after the
+// batched faces or of a new block.
+static bool
+beginBCZoneFace(CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA &face)
+{
+    const CheckpointState *ckpt = rti.data->checkpoint;
+    if (nullptr != ckpt && 0 != ckpt->skipFaces) {
+        // The face comes before the resumed checkpoint
+        return true;
+    }
+    if (rti.data->faceBatch.empty() && PWGM_HBLOCK_ID(face.owner.block) ==
+            PWGM_HBLOCK_ID(rti.data->bcZoneBlk)) {
+        return true;
+    }
+    rti.data->bcZoneBlk = face.owner.block;
+    if (!flushFaceBatch(rti)) {
+        return false;
+    }
+    beginFaceRun(rti, face, rti.data->batchOrdinal, false);
+    return !CAEPU_RT_IS_ABORTED(&rti);
+}
+
+
+// Invoked by PwModStreamFaces() for each face in the grid.
+PWP_UINT32
+faceCB(PWGM_FACESTREAM_DATA *face)
+{
+    CAEP_RTITEM &rti = *((CAEP_RTITEM*)face->userData);
+    if (nullptr != rti.data->perf) {
+        rti.data->perf->addItems(FluentPerf::Faces, 1);
+    }
+
+    if (nullptr != rti.data->cellGraph) {
+        rti.data->cellGraph->addFace(face->owner.cellIndex,
+            (PWGM_FACETYPE_BOUNDARY == face->type) ? PWP_BADID :
+                face->neighborCellIndex);
+    }
+
+    if ((PWGM_FACETYPE_CONNECTION == face->type) &&
+        PWGM_HDOMAIN_ISVALID(face->owner.domain)) {
+        // cache the shadow face for dumping in endCB().
+        cacheFace(rti, *face);
+        return !pollAbort(rti);
+    }
+
+    if (rti.data->mergeBCZones && PWGM_FACETYPE_BOUNDARY == face->type) {
+        // cache the BC face for dumping with its BC zone in endCB().
+        if (!beginBCZoneFace(rti, *face)) {
+            return PWP_FALSE;
         }
-        // Close out the final shadow face zone
-        writeCloseFaceZone(rti, PWGM_FACETYPE_BOUNDARY);
+        cacheFace(rti, *face);
+        return progressIncr(rti);
     }
 
-    return caeuProgressEndStep(&rti);
+    CheckpointState *ckpt = rti.data->checkpoint;
+    if (nullptr != ckpt && 0 != ckpt->skipFaces) {
+        // The face is in the resumed case file already
+        --ckpt->skipFaces;
+        return progressIncr(rti);
+    }
+
+    // The face is written once the batch is full or the stream ends.
+    FaceBatch &batch = rti.data->faceBatch;
+    batch.push_back(*face);
+    if (batch.size() < FaceBatchSize) {
+        return !CAEPU_RT_IS_ABORTED(&rti);
+    }
+    return flushFaceBatch(rti);
 }
 
 
-// Invoked once for each requested grid export.
-PWP_BOOL
-runtimeWrite(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
-    const CAEP_WRITEINFO *pWriteInfo)
+// Partition the cells and write the partition section FLUENT_PARTITION(40)
+// for each cell zone
+static void
+writePartitions(CAEP_RTITEM &rti)
 {
-    PWP_BOOL ret = PWP_FALSE;
-    if (pRti && pRti->fp && model && pWriteInfo) {
-        // init plugin-defined instance data pointer
-        FLUENT_DATA fluentData;
-        pRti->data = &fluentData; // cppcheck-suppress autoVariables
+    FluentTraceSpan span(rti.data->trace, "partition");
+    span.arg("parts", rti.data->partCount);
+    span.arg("cells", rti.data->cellCount);
+    const PWP_UINT32 nParts = rti.data->partCount;
+    std::vector<PWP_UINT32> part;
+    FluentPartitioner::Graph graph;
+    rti.data->cellGraph->buildGraph(graph, CAEPU_RT_DIM_3D(&rti),
+        rti.data->partPrismWeight);
+    FluentPartitioner partitioner(rti.data->partImbalance,
+        rti.data->threads);
+    // Partition on a worker so that this thread can keep polling for an
+    // abort
+    PWP_UINT64 cut = 0;
+    std::atomic<bool> done(false);
+    std::thread worker([&]() {
+        cut = partitioner.partition(graph, nParts, part);
+        done = true;
+    });
+    while (!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (pollAbort(rti)) {
+            partitioner.cancel();
+        }
+    }
+    worker.join();
+    if (CAEPU_RT_IS_ABORTED(&rti)) {
+        return;
+    }
+    span.arg("cut", cut);
+
+    beginHashSection(rti, "partitions", 0);
+    FluentSink &out = *rti.data->sink;
+    out.print("\n");
+    writeComment(rti, "Partitions : %u  Cut faces : %llu", nParts,
+        (unsigned long long)cut);
+    CellZones::const_iterator zIter = rti.data->cellZones.begin();
+    for (; rti.data->cellZones.end() != zIter; ++zIter) {
+        const PWP_UINT64 offset = out.tell();
+        // (40 (zoneId firstIndex lastIndex partitionCount)(
+        writeSectionListHdr(rti, FLUENT_PARTITION, "%x %x %x %x",
+            zIter->zone, zIter->firstCell, zIter->lastCell, nParts);
+        PWP_UINT column = 0;
+        for (PWP_UINT32 c = zIter->firstCell; c <= zIter->lastCell; ++c) {
+            if (pollAbort(rti)) {
+                return;
+            }
+            if (16 == column) {
+                out.print("\n");
+                column = 1;
+            }
+            else {
+                ++column;
+            }
+            out.print(" %x", (c <= part.size()) ? part[c - 1] : 0);
+        }
+        out.print("\n");
+        writeSectionListFtr(rti);
+        if (nullptr != rti.data->sectionIndex) {
+            const FluentSectionIndex::Entry entry = { zIter->zone,
+                FLUENT_PARTITION, zIter->firstCell, zIter->lastCell, offset,
+                out.tell() - offset, "", "" };
+            rti.data->sectionIndex->add(entry);
+        }
+    }
+}
 
-        PWP_UINT32 cnt = 2; /* the # of MAJOR progress steps */
-        // 1. Write vertices
-        // 2. Write faces (VC zones are written during face writting)
-        if (caeuProgressInit(pRti, cnt)) {
-            // Configure the grid model to enumerate elements grouped by VC
-            PwModAppendEnumElementOrder(model, PWGM_ELEMORDER_VC);
-            // Stream the interior model faces first, followed by the BC faces
-            ret = PwModStreamFaces(pRti->model, PWGM_FACEORDER_VCGROUPSBCLAST,
-                beginCB, faceCB, endCB, pRti) && !CAEPU_RT_IS_ABORTED(pRti);
+
+// Writes a run of sorted cached faces. A face zone is opened for each
+// domain, or for each BC zone of a MergeBCZones export, closing the zone of
+// the previous one. Returns false if the faces could not be written.
+static bool
+writeShadowFaces(CAEP_RTITEM &rti, const PWGM_FACESTREAM_DATA *faces,
+    const PWP_UINT32 cnt)
+{
+    bool ok = true;
+    PWP_UINT32 i = 0;
+    while (ok && i < cnt) {
+        const PWP_UINT64 key = cachedZoneKey(rti, faces[i]);
+        PWP_UINT32 runEnd = i + 1;
+        while (runEnd < cnt && cachedZoneKey(rti, faces[runEnd]) == key) {
+            ++runEnd;
+        }
+        if (!PWGM_HDOMAIN_ISVALID(rti.data->prevDom) ||
+                rti.data->cachedZoneKey != key) {
+            rti.data->currDom = faces[i].owner.domain;
+            // We have transitioned from one zone to the next
+            if (PWGM_HDOMAIN_ISVALID(rti.data->prevDom)) {
+                // Close out the previous zone
+                writeCloseFaceZone(rti, PWGM_FACETYPE_BOUNDARY);
+            }
+            rti.data->prevDom = rti.data->currDom;
+            rti.data->cachedZoneKey = key;
+            if (rti.data->mergeBCZones) {
+                // The zone may span VCs of different cell types
+                BCZoneTypes::const_iterator tIter =
+                    rti.data->bcZoneTypes.find(key);
+                rti.data->vcCellType = convertCellTypeToFace(
+                    (rti.data->bcZoneTypes.end() != tIter) ? tIter->second :
+                    PWP_UINT32(FLUENT_CELL_MIXED), CAEPU_RT_DIM_2D(&rti));
+            }
+            ++rti.data->zone;
+            rti.data->faceStartIndex = rti.data->faceIndex;
+            writeOpenFaceZone(rti);
+            rti.data->headerOpen = PWP_TRUE;
+        }
+        ok = writeFaceRun(rti, &faces[i], runEnd - i, false);
+        i = runEnd;
+    }
+    return ok;
+}
+
+
+// Invoked once by PwModStreamFaces() after last face is streamed.
+PWP_UINT32
+endCB(PWGM_ENDSTREAM_DATA *data) {
+    CAEP_RTITEM &rti = *((CAEP_RTITEM*) data->userData);
+    // Write the faces still waiting in the batch. They end the face stream.
+    const bool flushed = flushFaceBatch(rti);
+    stopFaceStreamPerf(rti);
+    if (!flushed) {
+        return PWP_FALSE;
+    }
+    FluentPerfScope perfScope(rti.data->perf, FluentPerf::End);
+    FluentApiPhase apiPhase(FluentApiStats::End);
+    if (nullptr != rti.data->perf) {
+        rti.data->perf->addItems(FluentPerf::End, rti.data->shadowFaces.size() +
+            rti.data->shadowSpill->itemCount());
+    }
+
+    if (rti.data->headerOpen) {
+        // Close out the last face zone
+        writeCloseFaceZone(rti, rti.data->prevFaceType);
+        rti.data->headerOpen = PWP_FALSE;
+    }
+
+    bool ok = true;
+    ShadowFaces &faces = rti.data->shadowFaces;
+    ShadowSpill &spill = *rti.data->shadowSpill;
+    if ((!faces.empty() || 0 != spill.runCount()) && !pollAbort(rti)) {
+        // Deal with the cached shadow faces
+        {
+            FluentTraceSpan sortSpan(rti.data->trace, "sortShadowFaces");
+            sortSpan.arg("faces", faces.size());
+            sortShadowFaces(rti, faces, CachedFaceLess(rti));
+        }
+
+        // Init the domain tracking values used to detect zone transitions.
+        PWGM_HDOMAIN_SET_INVALID(rti.data->prevDom);
+        PWGM_HDOMAIN_SET_INVALID(rti.data->currDom);
+        if (0 == spill.runCount()) {
+            // Write the faces in chunks, polling for an abort in between
+            for (size_t i = 0; ok && i < faces.size() && !pollAbort(rti);
+                    i += ShadowChunkSize) {
+                ok = writeShadowFaces(rti, &faces[i], PWP_UINT32(
+                    std::min<size_t>(faces.size() - i, ShadowChunkSize)));
+            }
+        }
+        else if (!CAEPU_RT_IS_ABORTED(&rti)) {
+            // Merge the spilled runs with the faces still in memory
+            FluentTraceSpan mergeSpan(rti.data->trace, "mergeShadowFaces");
+            mergeSpan.arg("runs", spill.runCount());
+            ok = spill.merge(faces.data(), faces.size(), CachedFaceLess(rti),
+                [&rti](const PWGM_FACESTREAM_DATA *batch, size_t cnt) {
+                    return writeShadowFaces(rti, batch, PWP_UINT32(cnt)) &&
+                        !pollAbort(rti);
+                }, size_t(rti.data->shadowBudget), ShadowChunkSize);
+            if (!ok) {
+                caeuSendErrorMsg(&rti, "Could not read the spilled shadow "
+                    "faces", 0);
+            }
+        }
+        // Close out the final shadow face zone, unless an abort came before
+        // the first one was opened or the file is discarded
+        if (rti.data->headerOpen && !CAEPU_RT_IS_ABORTED(&rti)) {
+            writeCloseFaceZone(rti, PWGM_FACETYPE_BOUNDARY);
+        }
+        rti.data->headerOpen = PWP_FALSE;
+    }
+
+    if (nullptr != rti.data->cellGraph && !CAEPU_RT_IS_ABORTED(&rti)) {
+        writePartitions(rti);
+    }
+
+    {
+        FluentTraceSpan span(rti.data->trace, "flush");
+        rti.data->sink->flush();
+    }
+
+    return ok && checkSink(rti) && caeuProgressEndStep(&rti);
+}
+
+
+// Returns the trace-event file requested by the CAEUNSFLUENT_TRACE
+// environment variable or the TraceEvents export attribute. The variable may
+// name the file or be "1" to use the default "<export file>.trace.json".
+// Returns an empty string if tracing is off.
+static std::string
+getTraceFilename(const CAEP_WRITEINFO &writeInfo, PWGM_HGRIDMODEL model)
+{
+    std::string ret;
+    PWP_BOOL traceOn = PWP_FALSE;
+    const char *env = getenv("CAEUNSFLUENT_TRACE");
+    if (env && *env && 0 != strcmp(env, "0")) {
+        traceOn = PWP_TRUE;
+        if (0 != strcmp(env, "1")) {
+            ret = env;
+        }
+    }
+    else if (!PwModGetAttributeBOOL(model, "TraceEvents", &traceOn)) {
+        traceOn = PWP_FALSE;
+    }
+    if (traceOn && ret.empty() && writeInfo.fileDest) {
+        ret = writeInfo.fileDest;
+        ret.append(".trace.json");
+    }
+    return ret;
+}
+
+
+// Returns the boolean setting of environment variable env, or of export
+// attribute attr if env is not set. Any value but "0" turns it on.
+static bool
+getBoolSetting(PWGM_HGRIDMODEL model, const char *attr, const char *env)
+{
+    const char *val = getenv(env);
+    if (val && *val) {
+        return 0 != strcmp(val, "0");
+    }
+    PWP_BOOL on = PWP_FALSE;
+    return PwModGetAttributeBOOL(model, attr, &on) && on;
+}
+
+
+// Returns the unsigned setting of environment variable env, or of export
+// attribute attr if env is not set, or def. A variable that is not a 32 bit
+// unsigned number is ignored with a warning.
+static PWP_UINT32
+getUIntSetting(CAEP_RTITEM &rti, const char *attr, const char *env,
+    PWP_UINT32 def)
+{
+    const char *val = getenv(env);
+    if (val && *val) {
+        char *end = nullptr;
+        errno = 0;
+        const unsigned long long uval = strtoull(val, &end, 0);
+        if (0 == errno && '\0' == *end && nullptr == strchr(val, '-') &&
+                uval <= 0xffffffffULL) {
+            return PWP_UINT32(uval);
+        }
+        const std::string msg = std::string("Ignoring ") + env + "=" + val +
+            ", which is not an unsigned 32 bit number.";
+        caeuSendWarningMsg(&rti, msg.c_str(), 0);
+    }
+    PWP_UINT32 uval;
+    return PwModGetAttributeUINT32(rti.model, attr, &uval) ? uval : def;
+}
+
+
+// Returns the output mode set by the CAEUNSFLUENT_OUTPUT_MODE environment
+// variable or the OutputMode export attribute
+static std::string
+getOutputMode(CAEP_RTITEM &rti)
+{
+    const char *mode = getenv("CAEUNSFLUENT_OUTPUT_MODE");
+    if ((nullptr == mode || !*mode) &&
+            !PwModGetAttributeEnum(rti.model, "OutputMode", &mode)) {
+        mode = nullptr;
+    }
+    return std::string(mode ? mode : "buffered");
+}
+
+
+// true if the CAEUNSFLUENT_PERF environment variable or the PerfCounters
+// export attribute asks for the per-phase hardware counters
+static bool
+isPerfRequested(PWGM_HGRIDMODEL model)
+{
+    return getBoolSetting(model, "PerfCounters", "CAEUNSFLUENT_PERF");
+}
+
+
+// Sends the counter report as info messages and writes it to
+// "<export file>.perf.txt"
+static void
+reportPerf(CAEP_RTITEM &rti, const FluentPerf &perf)
+{
+    const std::vector<std::string> lines = perf.report();
+    for (size_t i = 0; i < lines.size(); ++i) {
+        caeuSendInfoMsg(&rti, lines[i].c_str(), 0);
+    }
+    if (rti.pWriteInfo->fileDest) {
+        const std::string filename = std::string(rti.pWriteInfo->fileDest) +
+            ".perf.txt";
+        if (!perf.write(filename.c_str())) {
+            caeuSendWarningMsg(&rti, "Could not write the counter report.",
+                0);
+        }
+    }
+}
+
+
+// Reads the Partition* export attributes. A PartitionCount below 2 disables
+// partitioning.
+static void
+getPartitionSettings(PWGM_HGRIDMODEL model, FLUENT_DATA &data)
+{
+    PWP_UINT32 uval;
+    PWP_REAL rval;
+    if (PwModGetAttributeUINT32(model, "PartitionCount", &uval)) {
+        data.partCount = uval;
+    }
+    if (PwModGetAttributeREAL(model, "PartitionImbalance", &rval) &&
+            0.0 <= rval) {
+        data.partImbalance = rval;
+    }
+    if (PwModGetAttributeREAL(model, "PartitionPrismWeight", &rval) &&
+            0.0 < rval) {
+        data.partPrismWeight = rval;
+    }
+}
+
+
+// Cells per worker thread that AutoTune aims for
+static const PWP_UINT64 CellsPerThread = 100000;
+
+
+// Reads the runtime settings. Each export attribute can be overridden by an
+// environment variable. AutoTune fills the settings left at their defaults:
+// the threads from the core count and the cell count, the output buffer size
+// from a write-throughput probe next to the export file (if probe is true),
+// and the progress granularity per step.
+static void
+getRuntimeSettings(CAEP_RTITEM &rti, const bool probe)
+{
+    FLUENT_DATA &data = *rti.data;
+    const PWP_UINT32 cores = std::max(1U, std::thread::hardware_concurrency());
+    data.threads = getUIntSetting(rti, "Threads", "CAEUNSFLUENT_THREADS", 0);
+    data.bufferSize = getUIntSetting(rti, "BufferSize",
+        "CAEUNSFLUENT_BUFFER_SIZE", 0);
+    const bool bufferSet = (0 != data.bufferSize);
+    data.shadowBudget = PWP_UINT64(getUIntSetting(rti, "ShadowMemory",
+        "CAEUNSFLUENT_SHADOW_MEMORY", 0)) * 1024 * 1024;
+    data.progressStep = getUIntSetting(rti, "ProgressStep",
+        "CAEUNSFLUENT_PROGRESS_STEP", 1);
+    if (getBoolSetting(rti.model, "AutoTune", "CAEUNSFLUENT_AUTOTUNE")) {
+        if (0 == data.threads) {
+            PWP_UINT64 nCells = 0;
+            PWGM_ELEMCOUNTS ec;
+            const PWP_UINT32 blockCount = PwModBlockCount(rti.model);
+            for (PWP_UINT32 ndx = 0; ndx < blockCount; ++ndx) {
+                nCells += PwBlkElementCount(PwModEnumBlocks(rti.model, ndx),
+                    &ec);
+            }
+            data.threads = PWP_UINT32(std::max<PWP_UINT64>(1,
+                std::min<PWP_UINT64>(cores, nCells / CellsPerThread)));
+        }
+        double mbps = 0.0;
+#if !defined(WINDOWS)
+        if (0 == data.bufferSize && probe && rti.pWriteInfo->fileDest) {
+            data.bufferSize = PWP_UINT32(fluentProbeBufferSize(
+                rti.pWriteInfo->fileDest, mbps));
+        }
+#else
+        (void)probe;
+#endif
+        if (1 == data.progressStep) {
+            data.progressStep = 0;
+        }
+        // Report the buffer the output mode uses, which is its default
+        // unless the probe or BufferSize chose one
+#if !defined(WINDOWS)
+        const std::string mode = getOutputMode(rti);
+        size_t bufSize = data.bufferSize;
+        if (0 == bufSize) {
+            bufSize = ("direct" == mode) ?
+                size_t(FluentDirectSink::DefaultBufferSize) :
+                ("mmap" == mode) ? size_t(FluentMmapSink::DefaultWindowSize) :
+                size_t(FluentFdSink::DefaultBufferSize);
+        }
+#else
+        const std::string mode("stdio");
+        const size_t bufSize = 0;
+#endif
+        char msg[160];
+        if ("stdio" == mode) {
+            snprintf(msg, sizeof(msg), "AutoTune: %u threads, the output "
+                "buffer of the C stream", data.threads);
+        }
+        else if (0.0 < mbps) {
+            snprintf(msg, sizeof(msg), "AutoTune: %u threads, %u KiB output "
+                "buffer (%.0f MB/s probed)", data.threads,
+                unsigned(bufSize / 1024), mbps);
+        }
+        else {
+            snprintf(msg, sizeof(msg), "AutoTune: %u threads, %u KiB output "
+                "buffer (%s)", data.threads, unsigned(bufSize / 1024),
+                bufferSet ? "BufferSize" : "default, not probed");
+        }
+        caeuSendInfoMsg(&rti, msg, 0);
+    }
+    if (0 == data.threads) {
+        data.threads = cores;
+    }
+}
+
+
+// Appends the content digests to the case file as comments and returns
+// them as lines of text. The file digest covers the bytes before these
+// comments.
+static std::vector<std::string>
+writeContentHash(CAEP_RTITEM &rti)
+{
+    FluentHashSink &hash = *rti.data->hashSink;
+    hash.endSection();
+    std::vector<std::string> lines;
+    char line[160];
+    snprintf(line, sizeof(line), "Content hash %016llx of %llu bytes "
+        "(XXH64 of 1 MiB chunks)", (unsigned long long)hash.digest(),
+        (unsigned long long)hash.tell());
+    lines.push_back(line);
+    const std::vector<FluentHashSink::Section> &sections = hash.sections();
+    for (size_t i = 0; i < sections.size(); ++i) {
+        snprintf(line, sizeof(line), "  %-16s %016llx at %llu, %llu bytes",
+            sections[i].name.c_str(), (unsigned long long)sections[i].digest,
+            (unsigned long long)sections[i].offset,
+            (unsigned long long)sections[i].length);
+        lines.push_back(line);
+    }
+    rti.data->sink->print("\n");
+    for (size_t i = 0; i < lines.size(); ++i) {
+        writeComment(rti, "%s", lines[i].c_str());
+    }
+    return lines;
+}
+
+
+// Sends the Stats summary of an export that took secs seconds and wrote
+// bytes to the case file. The summary and the content digests are written to
+// "<export file>.stats.txt".
+static void
+reportStats(CAEP_RTITEM &rti, const double secs, const PWP_UINT64 bytes,
+    const std::vector<std::string> &hashLines)
+{
+    const PWP_UINT32 nFaces = rti.data->faceIndex - 1;
+    const double t = std::max(secs, 1e-6);
+    std::vector<std::string> lines;
+    char msg[256];
+    snprintf(msg, sizeof(msg), "Wrote %llu bytes, %u nodes, %u cells and %u "
+        "faces in %.3f s (%.1f MB/s, %.0f faces/s)", (unsigned long long)bytes,
+        rti.data->boundaryOnly ? PWP_UINT32(rti.data->surfaceNodes.size()) :
+            PwModVertexCount(rti.model), rti.data->cellCount, nFaces, secs,
+        double(bytes) / t / 1.0e6, double(nFaces) / t);
+    lines.push_back(msg);
+    snprintf(msg, sizeof(msg), "Settings: %u threads, %u byte buffer, "
+        "%llu MiB shadow memory, progress every %u items, %llu shadow face "
+        "runs spilled", rti.data->threads, rti.data->bufferSize,
+        (unsigned long long)(rti.data->shadowBudget / (1024 * 1024)),
+        rti.data->progressEvery,
+        (unsigned long long)rti.data->shadowSpill->runCount());
+    lines.push_back(msg);
+    const std::vector<std::string> arenaLines = rti.data->arena->report();
+    lines.insert(lines.end(), arenaLines.begin(), arenaLines.end());
+    if (nullptr != rti.data->apiStats) {
+        const std::vector<std::string> apiLines =
+            rti.data->apiStats->report(secs);
+        lines.insert(lines.end(), apiLines.begin(), apiLines.end());
+    }
+    for (size_t i = 0; i < lines.size(); ++i) {
+        caeuSendInfoMsg(&rti, lines[i].c_str(), 0);
+    }
+    lines.insert(lines.end(), hashLines.begin(), hashLines.end());
+    if (rti.pWriteInfo->fileDest) {
+        const std::string filename = std::string(rti.pWriteInfo->fileDest) +
+            ".stats.txt";
+        FILE *fp = fopen(filename.c_str(), "w");
+        bool ok = (nullptr != fp);
+        for (size_t i = 0; ok && i < lines.size(); ++i) {
+            ok = (0 <= fprintf(fp, "%s\n", lines[i].c_str()));
+        }
+        if (nullptr != fp) {
+            ok = (0 == fclose(fp)) && ok;
+        }
+        if (!ok) {
+            caeuSendWarningMsg(&rti, "Could not write the stats file.", 0);
+        }
+    }
+}
+
+
+// Estimate the case file size by section and the peak memory of the export
+// from the block and domain element counts. Nothing is streamed.
+static void
+estimateSize(CAEP_RTITEM &rti, FluentSizeEstimate &est)
+{
+    const bool is3D = CAEPU_RT_DIM_3D(&rti);
+    const PWP_UINT32 dim = (is3D ? 3 : 2);
+    const PWP_UINT64 nNodes = PwModVertexCount(rti.model);
+
+    // Cells and, indexed by node count, the faces of all cells
+    PWP_UINT64 nCells = 0;
+    PWP_UINT64 nMixedCells = 0;
+    PWP_UINT64 cellFaces[5] = { 0, 0, 0, 0, 0 };
+    std::map<PWP_UINT32, PWP_UINT64> vcCells;
+    PWGM_ELEMCOUNTS ec;
+    const PWP_UINT32 blockCount = PwModBlockCount(rti.model);
+    for (PWP_UINT32 ndx = 0; ndx < blockCount; ++ndx) {
+        PWGM_HBLOCK hBlk = PwModEnumBlocks(rti.model, ndx);
+        const PWP_UINT64 n = PwBlkElementCount(hBlk, &ec);
+        nCells += n;
+        if (isMixedBlock(ec)) {
+            nMixedCells += n;
+        }
+        if (is3D) {
+            cellFaces[3] += 4 * PWP_UINT64(PWGM_ECNT_Tet(ec)) +
+                2 * PWP_UINT64(PWGM_ECNT_Wedge(ec)) +
+                4 * PWP_UINT64(PWGM_ECNT_Pyramid(ec));
+            cellFaces[4] += 3 * PWP_UINT64(PWGM_ECNT_Wedge(ec)) +
+                PWP_UINT64(PWGM_ECNT_Pyramid(ec)) +
+                6 * PWP_UINT64(PWGM_ECNT_Hex(ec));
+        }
+        else {
+            cellFaces[2] += 3 * PWP_UINT64(PWGM_ECNT_Tri(ec)) +
+                4 * PWP_UINT64(PWGM_ECNT_Quad(ec));
+        }
+        PWGM_CONDDATA cond;
+        getSafeVC(rti, hBlk, cond);
+        vcCells[cond.id] += n;
+    }
+
+    // Boundary faces by node count. Shadow BC faces are written twice.
+    // MergeBCZones writes a zone per BC and caches all of the BC faces.
+    PWP_UINT64 bFaces[5] = { 0, 0, 0, 0, 0 };
+    PWP_UINT64 nShadowFaces = 0;
+    PWP_UINT32 nFaceZones = PWP_UINT32(vcCells.size());   // interior zones
+    std::set<PWP_UINT64> bcZones;
+    const PWP_UINT32 domainCount = PwModDomainCount(rti.model);
+    for (PWP_UINT32 ndx = 0; ndx < domainCount; ++ndx) {
+        PWGM_HDOMAIN hDom = PwModEnumDomains(rti.model, ndx);
+        PwDomElementCount(hDom, &ec);
+        PWGM_CONDDATA cond;
+        getSafeBC(rti, hDom, cond);
+        const PWP_UINT64 mult = (isShadowType(cond.type) ? 2 : 1);
+        PWP_UINT64 n = 0;
+        if (is3D) {
+            bFaces[3] += mult * PWGM_ECNT_Tri(ec);
+            bFaces[4] += mult * PWGM_ECNT_Quad(ec);
+            n = PWP_UINT64(PWGM_ECNT_Tri(ec)) + PWGM_ECNT_Quad(ec);
+        }
+        else {
+            bFaces[2] += mult * PWGM_ECNT_Bar(ec);
+            n = PWGM_ECNT_Bar(ec);
+        }
+        nShadowFaces += ((2 == mult || rti.data->mergeBCZones) ? n : 0);
+        if (!rti.data->mergeBCZones ||
+                bcZones.insert((mult << 32) | cond.id).second) {
+            nFaceZones += PWP_UINT32(mult);
+        }
+    }
+
+    // Average bytes of a node or cell index, with its separator
+    const double nodeLen = (nNodes ? double(fluentHexDigitSum(nNodes)) /
+        double(nNodes) : 1.0) + 1.0;
+    const double cellLen = (nCells ? double(fluentHexDigitSum(nCells)) /
+        double(nCells) : 1.0) + 1.0;
+    const double mixedFrac = (nCells ? double(nMixedCells) / double(nCells) :
+        0.0);
+
+    // Each face is in two cells, or one cell and a domain
+    double faceBytes = 0.0;
+    PWP_UINT64 nFaces = 0;
+    for (int k = 2; k <= 4; ++k) {
+        const PWP_UINT64 total = (cellFaces[k] + bFaces[k]) / 2;
+        const PWP_UINT64 interior = total - std::min(total, bFaces[k]);
+        const double lineLen = k * nodeLen + cellLen + 2.0 * mixedFrac;
+        faceBytes += double(interior) * (lineLen + cellLen) +
+            double(total - interior) * (lineLen + 2.0);
+        nFaces += total;
+    }
+    // Reserved zone comment and header lines, and the footer
+    faceBytes += nFaceZones * double(1 + ZoneCommentLen + 1 + ZoneHeaderLen +
+        1 + 3);
+
+    est.addSection(FLUENT_NODES, 1, 32 + nNodes * dim * realChars(rti) + 3);
+    // Mixed zones list the type of each cell
+    est.addSection(FLUENT_CELLS, PWP_UINT32(vcCells.size()),
+        40 * PWP_UINT64(vcCells.size()) + 2 * nMixedCells + nMixedCells / 9);
+    est.addSection(FLUENT_FACES, nFaceZones, PWP_UINT64(faceBytes));
+    if (1 < rti.data->partCount) {
+        const double partLen = double(fluentHexDigitSum(
+            rti.data->partCount)) / double(rti.data->partCount) + 1.0;
+        est.addSection(FLUENT_PARTITION, PWP_UINT32(vcCells.size()),
+            PWP_UINT64(double(nCells) * (partLen + 1.0 / 16.0) +
+                40.0 * vcCells.size()));
+    }
+    // Header, comments and the zone (45) lines
+    est.otherBytes = 1024 + 160 * PWP_UINT64(vcCells.size() + nFaceZones);
+
+    // The shadow face cache is sized once, up to the ShadowMemory budget
+    PWP_UINT64 shadowBytes = nShadowFaces * sizeof(PWGM_FACESTREAM_DATA);
+    if (0 != rti.data->shadowBudget) {
+        // the cache and the merge buffers
+        shadowBytes = std::min(shadowBytes, 2 * rti.data->shadowBudget);
+    }
+    est.addMemory("shadow face cache", shadowBytes);
+    est.addMemory("face batch", FaceBatchSize * sizeof(PWGM_FACESTREAM_DATA));
+#if !defined(WINDOWS)
+    est.addMemory("output buffer", (0 != rti.data->bufferSize) ?
+        rti.data->bufferSize : PWP_UINT32(FluentFdSink::DefaultBufferSize));
+#endif
+    if (1 < rti.data->partCount) {
+        // edge list, then the graph and its first two halves
+        const PWP_UINT64 nEdges = nFaces - bFaces[2] - bFaces[3] - bFaces[4];
+        est.addMemory("cell graph", nCells + 8 * nEdges +
+            2 * (4 * (3 * nCells + 1) + 16 * nEdges) + 4 * nCells);
+    }
+    est.freeBytes = fluentFreeDiskSpace(rti.pWriteInfo->fileDest);
+}
+
+
+// Replace the estimated sections with the exact sizes recorded by a
+// counting dry run. The dry run does not partition the cells, so the
+// partition sections keep their estimate.
+static void
+setCountedSize(const FluentSectionIndex &index, PWP_UINT64 totalBytes,
+    FluentSizeEstimate &est)
+{
+    std::vector<FluentSizeEstimate::Section> partitions;
+    for (size_t i = 0; i < est.sections.size(); ++i) {
+        if (FLUENT_PARTITION == est.sections[i].id) {
+            partitions.push_back(est.sections[i]);
+        }
+    }
+    est.sections.clear();
+    PWP_UINT64 sectionBytes = 0;
+    const std::vector<FluentSectionIndex::Entry> &entries = index.entries();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        est.addSection(entries[i].section, 1, entries[i].length);
+        sectionBytes += entries[i].length;
+    }
+    est.otherBytes = totalBytes - sectionBytes;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        est.addSection(partitions[i].id, partitions[i].count,
+            partitions[i].bytes);
+    }
+    est.exact = true;
+    est.partitionsEstimated = !partitions.empty();
+}
+
+
+// Send the dry run report to the host and write it to "<file>.size.txt"
+static bool
+reportSize(CAEP_RTITEM &rti, const FluentSizeEstimate &est)
+{
+    const std::vector<std::string> lines = est.report();
+    for (size_t i = 0; i < lines.size(); ++i) {
+        caeuSendInfoMsg(&rti, lines[i].c_str(), 0);
+    }
+    if (est.exceedsFreeSpace()) {
+        caeuSendWarningMsg(&rti, "The case file will not fit on the disk", 0);
+    }
+    bool ret = true;
+    if (rti.pWriteInfo->fileDest) {
+        const std::string filename = std::string(rti.pWriteInfo->fileDest) +
+            ".size.txt";
+        ret = est.write(filename.c_str());
+    }
+    return ret;
+}
+
+
+// The DryRun export attribute values
+enum DryRunMode {
+    DryRunOff,
+    DryRunEstimate,
+    DryRunCount
+};
+
+
+static DryRunMode
+getDryRunMode(PWGM_HGRIDMODEL model)
+{
+    DryRunMode ret = DryRunOff;
+    const char *val = 0;
+    if (PwModGetAttributeEnum(model, "DryRun", &val) && val) {
+        if (0 == strcmp(val, "estimate")) {
+            ret = DryRunEstimate;
+        }
+        else if (0 == strcmp(val, "count")) {
+            ret = DryRunCount;
+        }
+    }
+    return ret;
+}
+
+
+enum CaseFormat {
+    CaseFormatText,   // the text case file only
+    CaseFormatCff,    // the HDF5 "<case>.h5" file only
+    CaseFormatBoth    // both files from one pass over the grid
+};
+
+
+static CaseFormat
+getCaseFormat(PWGM_HGRIDMODEL model)
+{
+    CaseFormat ret = CaseFormatText;
+    const char *val = 0;
+    if (PwModGetAttributeEnum(model, "CaseFormat", &val) && val) {
+        if (0 == strcmp(val, "cff")) {
+            ret = CaseFormatCff;
+        }
+        else if (0 == strcmp(val, "both")) {
+            ret = CaseFormatBoth;
+        }
+    }
+    return ret;
+}
+
+
+// Opens the HDF5 case file for the CaseFormat attribute. Returns false if
+// the export cannot continue.
+static bool
+openCffOutput(CAEP_RTITEM &rti, FluentCffWriter &cff)
+{
+    const CaseFormat format = getCaseFormat(rti.model);
+    if (CaseFormatText == format || nullptr == rti.pWriteInfo->fileDest) {
+        return true;
+    }
+    const std::string cffFile = std::string(rti.pWriteInfo->fileDest) +
+        ".h5";
+    if (!cff.open(cffFile.c_str(), CAEPU_RT_DIM_3D(&rti) ? 3 : 2,
+            rti.data->threads, 0 != CAEPU_RT_PREC_SINGLE(&rti))) {
+        const std::string msg = "Could not open " + cffFile +
+            " (HDF5 output needs a build with CAEUNSFLUENT_HAVE_HDF5)";
+        if (CaseFormatCff == format) {
+            caeuSendErrorMsg(&rti, msg.c_str(), 0);
+            return false;
+        }
+        caeuSendWarningMsg(&rti, msg.c_str(), 0);
+        return true;
+    }
+    rti.data->cff = &cff;
+    rti.data->writeText = (CaseFormatBoth == format);
+    return true;
+}
+
+
+// Writes the export file of a CaseFormat cff export. It only names the HDF5
+// case file, so that it is not taken for an empty case.
+static bool
+writeCffStub(CAEP_RTITEM &rti)
+{
+    std::string cffFile = std::string(rti.pWriteInfo->fileDest) + ".h5";
+    const size_t slash = cffFile.find_last_of("/\\");
+    if (std::string::npos != slash) {
+        cffFile.erase(0, slash + 1);
+    }
+    FluentFileSink stub(rti.fp);
+    ScopedSinkRedirect redirect(rti, stub);
+    writeComment(rti, "The mesh is in the HDF5 (Common Fluids Format) case "
+        "file %s", cffFile.c_str());
+    return stub.flush();
+}
+
+
+// Opens the extra case file copies named by the OutputCopies attribute and
+// adds their names to names. Returns false if the export cannot continue.
+static bool
+openOutputCopies(CAEP_RTITEM &rti,
+    std::vector<std::unique_ptr<FluentSink> > &copies,
+    std::vector<std::string> &names)
+{
+    const char *val = 0;
+    if (!PwModGetAttributeString(rti.model, "OutputCopies", &val) ||
+            nullptr == val) {
+        return true;
+    }
+    const std::string list(val);
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(';', start);
+        if (std::string::npos == end) {
+            end = list.size();
+        }
+        const std::string name = list.substr(start, end - start);
+        start = end + 1;
+        if (name.empty()) {
+            continue;
+        }
+        std::string err;
+        FluentSink *copy = fluentOpenCopySink(name, err);
+        if (nullptr == copy) {
+            caeuSendErrorMsg(&rti, err.c_str(), 0);
+            return false;
+        }
+        copies.push_back(std::unique_ptr<FluentSink>(copy));
+        names.push_back(name);
+    }
+    return true;
+}
+
+
+// Empties the export file after an abort so that no partial case file is
+// left behind. The host owns the file itself.
+static void
+discardExportFile(CAEP_RTITEM &rti)
+{
+    fflush(rti.fp);
+#if defined(WINDOWS)
+    _chsize_s(_fileno(rti.fp), 0);
+#else
+    if (0 != ftruncate(fileno(rti.fp), 0)) {
+        caeuSendWarningMsg(&rti, "Could not remove the partial case file.", 0);
+    }
+#endif
+}
+
+
+// Reports how long the export took to stop after pollAbort() saw the abort
+static void
+reportAbortLatency(CAEP_RTITEM &rti)
+{
+    if (std::chrono::steady_clock::time_point() == rti.data->abortTime) {
+        return;
+    }
+    const long long ms = (long long)std::chrono::duration_cast<
+        std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+            rti.data->abortTime).count();
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Export aborted. Stopped %lld ms after the "
+        "abort request was seen.", ms);
+    caeuSendInfoMsg(&rti, msg, 0);
+}
+
+
+#if !defined(WINDOWS)
+
+// Reserve the estimated size of the export file on disk, starting at the
+// current file position. base is set to that position if the space was
+// reserved. Returns false if the disk is too full for the export.
+static bool
+preallocateOutput(CAEP_RTITEM &rti, off_t &base)
+{
+    base = -1;
+    PWP_BOOL prealloc = PWP_FALSE;
+    const char *env = getenv("CAEUNSFLUENT_OUTPUT_FD");
+    if (!PwModGetAttributeBOOL(rti.model, "Preallocate", &prealloc) ||
+            !prealloc || (env && *env)) {
+        return true;
+    }
+    const int fd = fileno(rti.fp);
+    const off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0) {
+        return true;
+    }
+    FluentSizeEstimate est;
+    estimateSize(rti, est);
+    const int err = fluentPreallocate(fd, PWP_UINT64(pos), est.totalBytes());
+    if (ENOSPC == err) {
+        caeuSendErrorMsg(&rti, "Not enough disk space for the case file", 0);
+        return false;
+    }
+    base = (0 == err) ? pos : -1;
+    return true;
+}
+
+#endif // !WINDOWS
+
+
+// Adds the id, tid, name and type of a condition to a fingerprint
+static void
+hashCondition(FluentXxh64 &h, const PWGM_CONDDATA &cond)
+{
+    h.update64(cond.id);
+    h.update64(cond.tid);
+    h.update(cond.name ? cond.name : "", cond.name ? strlen(cond.name) + 1 : 1);
+    h.update(cond.type ? cond.type : "", cond.type ? strlen(cond.type) + 1 : 1);
+}
+
+
+// Fingerprint of the model as far as the case file depends on it: the
+// dimension and precision, the vertices, and the element counts and
+// conditions of the blocks and domains. A checkpoint is only resumed by an
+// export with the same fingerprint. If grid is true, the fingerprint is of
+// the mesh file of a MeshCache export instead. Only the ids of the
+// conditions, which group the elements into zones, and whether a BC has
+// shadow faces count then, as do the partitioning settings.
+static PWP_UINT64
+modelFingerprint(CAEP_RTITEM &rti, const bool grid)
+{
+    FluentXxh64 h;
+    h.update64(CAEPU_RT_DIM_2D(&rti) ? 2 : 3);
+    h.update64(CAEPU_RT_PREC_SINGLE(&rti) ? 1 : 0);
+    h.update64(rti.data->boundaryOnly ? 1 : 0);
+    h.update64(rti.data->mergeBCZones ? 1 : 0);
+    if (grid && 1 < rti.data->partCount) {
+        h.update64(rti.data->partCount);
+        h.update(&rti.data->partImbalance, sizeof(rti.data->partImbalance));
+        h.update(&rti.data->partPrismWeight,
+            sizeof(rti.data->partPrismWeight));
+    }
+    const PWP_UINT32 nVerts = PwModVertexCount(rti.model);
+    h.update64(nVerts);
+    PWGM_VERTDATA v;
+    for (PWP_UINT32 ndx = 0; ndx < nVerts && !pollAbort(rti); ++ndx) {
+        PwVertDataMod(PwModEnumVertices(rti.model, ndx), &v);
+        h.update(&v.x, sizeof(v.x));
+        h.update(&v.y, sizeof(v.y));
+        h.update(&v.z, sizeof(v.z));
+    }
+    PWGM_ELEMCOUNTS ec;
+    PWGM_CONDDATA cond;
+    const PWP_UINT32 blockCount = PwModBlockCount(rti.model);
+    h.update64(blockCount);
+    for (PWP_UINT32 ndx = 0; ndx < blockCount; ++ndx) {
+        PWGM_HBLOCK hBlk = PwModEnumBlocks(rti.model, ndx);
+        h.update64(PwBlkElementCount(hBlk, &ec));
+        h.update(&ec, sizeof(ec));
+        getSafeVC(rti, hBlk, cond);
+        if (grid) {
+            h.update64(cond.id);
+        }
+        else {
+            hashCondition(h, cond);
+        }
+    }
+    const PWP_UINT32 domainCount = PwModDomainCount(rti.model);
+    h.update64(domainCount);
+    for (PWP_UINT32 ndx = 0; ndx < domainCount; ++ndx) {
+        PWGM_HDOMAIN hDom = PwModEnumDomains(rti.model, ndx);
+        h.update64(PwDomElementCount(hDom, &ec));
+        h.update(&ec, sizeof(ec));
+        getSafeBC(rti, hDom, cond);
+        if (grid) {
+            h.update64(cond.id);
+            h.update64(isShadowType(cond.type) ? 1 : 0);
+        }
+        else {
+            hashCondition(h, cond);
+        }
+    }
+    return h.digest();
+}
+
+
+// Opens "<file>.part" for a checkpointed export if the Checkpoint export
+// attribute (or the CAEUNSFLUENT_CHECKPOINT environment variable) asks for
+// one. If "<file>.ckpt" records a checkpoint of the same model and the part
+// file still holds the bytes it covers, the export resumes from there.
+// Returns the sink of the part file, or null to write the export file as
+// usual.
+static FluentSink *
+openCheckpoint(CAEP_RTITEM &rti, CheckpointState &ckpt)
+{
+    const PWP_UINT32 mib = getUIntSetting(rti, "Checkpoint",
+        "CAEUNSFLUENT_CHECKPOINT", 0);
+    if (0 == mib || nullptr == rti.pWriteInfo->fileDest) {
+        return nullptr;
+    }
+#if !defined(WINDOWS)
+    const char *env = getenv("CAEUNSFLUENT_OUTPUT_FD");
+    const char *copies = nullptr;
+    PWP_BOOL index = PWP_FALSE;
+    if (nullptr != rti.data->cff || (env && *env) ||
+            (PwModGetAttributeString(rti.model, "OutputCopies", &copies) &&
+                copies && *copies) ||
+            (PwModGetAttributeBOOL(rti.model, "SectionIndex", &index) &&
+                index)) {
+        caeuSendWarningMsg(&rti, "Checkpoint cannot be combined with the "
+            "HDF5 case file, output copies, a section index or an output "
+            "descriptor. Checkpointing is off.", 0);
+        return nullptr;
+    }
+    ckpt.partFile = std::string(rti.pWriteInfo->fileDest) + ".part";
+    ckpt.recordFile = std::string(rti.pWriteInfo->fileDest) + ".ckpt";
+    ckpt.interval = PWP_UINT64(mib) * 1024 * 1024;
+    ckpt.fingerprint = modelFingerprint(rti, false);
+    ckpt.fd = open(ckpt.partFile.c_str(), O_RDWR | O_CREAT, 0666);
+    if (ckpt.fd < 0) {
+        caeuSendWarningMsg(&rti, "Could not open the checkpointed case file. "
+            "Checkpointing is off.", 0);
+        return nullptr;
+    }
+    FluentCheckpoint &rec = ckpt.resume;
+    if (rec.read(ckpt.recordFile.c_str())) {
+        // Verify the checkpointed bytes before any of them are reused
+        struct stat st;
+        FluentChunkHash hash;
+        ckpt.resumed = (rec.fingerprint == ckpt.fingerprint) &&
+            (0 == fstat(ckpt.fd, &st)) &&
+            (PWP_UINT64(st.st_size) >= rec.length) &&
+            fluentHashFile(ckpt.partFile.c_str(), rec.length,
+                rti.data->threads, hash) &&
+            (hash.digest() == rec.digest);
+        if (ckpt.resumed) {
+            ckpt.hash = hash;
+        }
+        else {
+            caeuSendInfoMsg(&rti, "The export checkpoint does not match the "
+                "model or the case file. Starting over.", 0);
+        }
+    }
+    const PWP_UINT64 length = (ckpt.resumed ? rec.length : 0);
+    if (0 != ftruncate(ckpt.fd, (off_t)length) ||
+            (off_t)length != lseek(ckpt.fd, (off_t)length, SEEK_SET)) {
+        caeuSendWarningMsg(&rti, "Could not truncate the checkpointed case "
+            "file. Checkpointing is off.", 0);
+        close(ckpt.fd);
+        ckpt.fd = -1;
+        ckpt.resumed = false;
+        return nullptr;
+    }
+    FluentFdSink *sink = new FluentFdSink(ckpt.fd, true,
+        rti.data->bufferSize);
+    sink->resumeAt(length);
+    if (ckpt.resumed) {
+        char msg[160];
+        snprintf(msg, sizeof(msg), "Resuming the export from its checkpoint "
+            "at byte %llu (zone %u, %llu faces written).",
+            (unsigned long long)length, rec.zone,
+            (unsigned long long)rec.ordinal);
+        caeuSendInfoMsg(&rti, msg, 0);
+    }
+    return sink;
+#else
+    (void)ckpt;
+    caeuSendWarningMsg(&rti, "Checkpoint is not supported on this platform.",
+        0);
+    return nullptr;
+#endif
+}
+
+
+// Completes a checkpointed export once its sink is closed. The part file
+// replaces the export file if the export succeeded. Otherwise the part file
+// and its checkpoint record are kept for a later export to resume from.
+static bool
+finishCheckpoint(CAEP_RTITEM &rti, CheckpointState &ckpt, const bool ok)
+{
+#if !defined(WINDOWS)
+    close(ckpt.fd);
+    ckpt.fd = -1;
+#endif
+    if (!ok) {
+        if (0 != ckpt.hash.length()) {
+            caeuSendInfoMsg(&rti, "The export can be resumed from its "
+                "checkpoint.", 0);
+        }
+        return false;
+    }
+    if (0 != rename(ckpt.partFile.c_str(), rti.pWriteInfo->fileDest)) {
+        caeuSendErrorMsg(&rti, "Could not replace the case file with the "
+            "checkpointed file.", 0);
+        return false;
+    }
+    remove(ckpt.recordFile.c_str());
+    return true;
+}
+
+
+// Sink installed by fluentSetOutputSink() for the next export
+static FluentSink *nextOutputSink = nullptr;
+
+
+void
+fluentSetOutputSink(FluentSink *sink)
+{
+    nextOutputSink = sink;
+}
+
+
+// Creates the sink for the export file. On POSIX systems, the file is written
+// through a buffered descriptor unless the OutputMode export attribute (or
+// the CAEUNSFLUENT_OUTPUT_MODE environment variable) selects the C stdio
+// stream, a memory map, direct I/O or a buffered descriptor written on a
+// worker thread. The CAEUNSFLUENT_OUTPUT_FD environment variable can redirect
+// the output to an inherited pipe or socket.
+static FluentSink *
+createOutputSink(CAEP_RTITEM &rti)
+{
+#if !defined(WINDOWS)
+    const char *env = getenv("CAEUNSFLUENT_OUTPUT_FD");
+    if (env && *env) {
+        char *end = nullptr;
+        errno = 0;
+        const long fd = strtol(env, &end, 10);
+        if (0 != errno || '\0' != *end || fd < 0 || fd > INT_MAX ||
+                -1 == fcntl(int(fd), F_GETFD)) {
+            caeuSendErrorMsg(&rti, "CAEUNSFLUENT_OUTPUT_FD is not the number "
+                "of an open file descriptor.", 0);
+            return nullptr;
+        }
+        return new FluentFdSink(int(fd), false, rti.data->bufferSize);
+    }
+    const std::string outputMode = getOutputMode(rti);
+    if ("stdio" == outputMode) {
+        return new FluentFileSink(rti.fp);
+    }
+    fflush(rti.fp);
+    const size_t bufSize = rti.data->bufferSize;
+    const off_t pos = lseek(fileno(rti.fp), 0, SEEK_CUR);
+    if ("direct" == outputMode && rti.pWriteInfo->fileDest) {
+        std::unique_ptr<FluentDirectSink> direct(new FluentDirectSink);
+        if (0 <= pos && direct->open(rti.pWriteInfo->fileDest,
+                PWP_UINT64(pos), bufSize ? bufSize :
+                    size_t(FluentDirectSink::DefaultBufferSize))) {
+            return direct.release();
+        }
+        caeuSendWarningMsg(&rti, "Direct I/O is not available for the case "
+            "file. Using buffered output.", 0);
+    }
+    else if ("mmap" == outputMode && rti.pWriteInfo->fileDest) {
+        std::unique_ptr<FluentMmapSink> mapped(new FluentMmapSink);
+        if (0 <= pos && mapped->open(rti.pWriteInfo->fileDest,
+                PWP_UINT64(pos), bufSize ? bufSize :
+                    size_t(FluentMmapSink::DefaultWindowSize))) {
+            return mapped.release();
+        }
+        caeuSendWarningMsg(&rti, "The case file cannot be memory mapped. "
+            "Using buffered output.", 0);
+    }
+    else if ("async" == outputMode) {
+        return new FluentAsyncSink(new FluentFdSink(fileno(rti.fp), true,
+            bufSize));
+    }
+    return new FluentFdSink(fileno(rti.fp), true, bufSize);
+#else
+    return new FluentFileSink(rti.fp);
+#endif
+}
+
+
+// Path of the mesh file of the grid with fingerprint in the MeshCache folder
+// dir: "<dir>/<fingerprint>.msh". A relative dir is in the folder of the
+// case file.
+static std::string
+meshCacheFile(const CAEP_RTITEM &rti, std::string dir,
+    const PWP_UINT64 fingerprint)
+{
+    const bool absolute = ('/' == dir[0]) || ('\\' == dir[0]) ||
+        (1 < dir.size() && ':' == dir[1]);
+    if (!absolute && nullptr != rti.pWriteInfo->fileDest) {
+        const std::string caseFile = rti.pWriteInfo->fileDest;
+        const size_t sep = caseFile.find_last_of("/\\");
+        if (std::string::npos != sep) {
+            dir = caseFile.substr(0, sep + 1) + dir;
+        }
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.msh",
+        (unsigned long long)fingerprint);
+    return dir + name;
+}
+
+
+// Reads the MeshCache export attribute (or the CAEUNSFLUENT_MESH_CACHE
+// environment variable). If it names a folder, sets meshFile to the mesh
+// file of the model's grid in that folder and zones.fingerprint to the
+// grid's fingerprint. Returns false if the whole case file is written.
+static bool
+getMeshCacheFile(CAEP_RTITEM &rti, std::string &meshFile,
+    FluentMeshZones &zones)
+{
+    const char *dir = getenv("CAEUNSFLUENT_MESH_CACHE");
+    if ((nullptr == dir || !*dir) &&
+            !PwModGetAttributeString(rti.model, "MeshCache", &dir)) {
+        dir = nullptr;
+    }
+    if (nullptr == dir || !*dir) {
+        return false;
+    }
+    const char *copies = nullptr;
+    PWP_BOOL index = PWP_FALSE;
+    if (nullptr != rti.data->cff ||
+            0 != getUIntSetting(rti, "Checkpoint",
+                "CAEUNSFLUENT_CHECKPOINT", 0) ||
+            (PwModGetAttributeString(rti.model, "OutputCopies", &copies) &&
+                copies && *copies) ||
+            (PwModGetAttributeBOOL(rti.model, "SectionIndex", &index) &&
+                index) ||
+            getBoolSetting(rti.model, "ContentHash",
+                "CAEUNSFLUENT_CONTENT_HASH")) {
+        caeuSendWarningMsg(&rti, "MeshCache cannot be combined with the HDF5 "
+            "case file, a checkpoint, output copies, a section index or a "
+            "content hash. Writing the whole case file.", 0);
+        return false;
+    }
+    zones.fingerprint = modelFingerprint(rti, true);
+    meshFile = meshCacheFile(rti, dir, zones.fingerprint);
+    return !CAEPU_RT_IS_ABORTED(&rti);
+}
+
+
+// true if every VC and domain that zones refers to is in the grid
+static bool
+hasMeshZoneConditions(CAEP_RTITEM &rti, const FluentMeshZones &zones)
+{
+    std::set<PWP_UINT32> vcIds;
+    const PWP_UINT32 blockCount = PwModBlockCount(rti.model);
+    for (PWP_UINT32 ndx = 0; ndx < blockCount; ++ndx) {
+        PWGM_CONDDATA cond;
+        getSafeVC(rti, PwModEnumBlocks(rti.model, ndx), cond);
+        vcIds.insert(cond.id);
+    }
+    const PWP_UINT32 domainCount = PwModDomainCount(rti.model);
+    for (size_t i = 0; i < zones.zones.size(); ++i) {
+        const FluentMeshZones::Zone &z = zones.zones[i];
+        if (FluentMeshZones::Boundary == z.kind) {
+            if (z.id >= domainCount) {
+                return false;
+            }
+        }
+        else if (0 == vcIds.count(z.id) || (FluentMeshZones::Interior ==
+                z.kind && PWP_BADID != z.id2 && 0 == vcIds.count(z.id2))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Loads zones from the record of meshFile. Returns true if the mesh file
+// and its record are complete, of the grid with zones.fingerprint and refer
+// only to conditions the grid has.
+static bool
+loadMeshZones(CAEP_RTITEM &rti, const std::string &meshFile,
+    FluentMeshZones &zones)
+{
+    FILE *fp = fopen(meshFile.c_str(), "rb");
+    if (nullptr == fp) {
+        return false;
+    }
+    fclose(fp);
+    FluentMeshZones rec;
+    if (!rec.read((meshFile + ".zones").c_str()) ||
+            rec.fingerprint != zones.fingerprint) {
+        return false;
+    }
+    if (!hasMeshZoneConditions(rti, rec)) {
+        caeuSendWarningMsg(&rti, ("The zones of the mesh file " + meshFile +
+            " do not match the grid. Writing the mesh file again.").c_str(),
+            0);
+        return false;
+    }
+    zones = rec;
+    return true;
+}
+
+
+// The mesh file of a MeshCache export while it is written to a temporary
+// file of its own
+class MeshFileOutput {
+public:
+    MeshFileOutput() :
+        fp_(nullptr)
+    {
+    }
+
+    ~MeshFileOutput()
+    {
+        close(false);
+    }
+
+    bool open(const std::string &meshFile, const size_t bufSize)
+    {
+        meshFile_ = meshFile;
+        fp_ = fluentCreateTempFile(meshFile, tmpFile_, "wb");
+        if (nullptr == fp_) {
+            return false;
+        }
+#if !defined(WINDOWS)
+        sink_.reset(new FluentFdSink(fileno(fp_), true, bufSize));
+#else
+        (void)bufSize;
+        sink_.reset(new FluentFileSink(fp_));
+#endif
+        return true;
+    }
+
+    FluentSink *sink() const
+    {
+        return sink_.get();
+    }
+
+    // Closes the file. It replaces the mesh file if ok, else it is removed.
+    // Returns true if the mesh file was replaced.
+    bool close(bool ok)
+    {
+        if (nullptr == fp_) {
+            return false;
+        }
+        ok = sink_->flush() && ok;
+        sink_.reset();
+        ok = (0 == fclose(fp_)) && ok;
+        fp_ = nullptr;
+        if (ok) {
+#if defined(WINDOWS)
+            remove(meshFile_.c_str());
+#endif
+            ok = (0 == rename(tmpFile_.c_str(), meshFile_.c_str()));
+        }
+        if (!ok) {
+            remove(tmpFile_.c_str());
+        }
+        return ok;
+    }
+
+private:
+    MeshFileOutput(const MeshFileOutput&) = delete;
+    MeshFileOutput& operator=(const MeshFileOutput&) = delete;
+
+private:
+    std::string                 meshFile_;
+    std::string                 tmpFile_;
+    FILE                       *fp_;
+    std::unique_ptr<FluentSink> sink_;
+};
+
+
+// Writes the zone sections (45) of the zones of a mesh file to out. They
+// name and type the zones by the current conditions, the way the sections
+// of the whole case file do.
+static bool
+writeMeshZoneLayer(CAEP_RTITEM &rti, FluentSink &out,
+    const std::string &meshFile, const FluentMeshZones &zones)
+{
+    FluentTraceSpan span(rti.data->trace, "writeMeshZoneLayer");
+    span.arg("zones", zones.zones.size());
+    ScopedSinkRedirect redirect(rti, out);
+    const char *val = 0;
+    if (!PwModGetAttributeString(rti.model, "AppNameAndVersion", &val)) {
+        val = "Pointwise";
+    }
+    out.print("(%d \"Exported from %s\")\n", FLUENT_HEADER, val);
+    writeComment(rti, "Zones of the mesh file %s", meshFile.c_str());
+    out.print("\n");
+
+    // The first block of a VC names its zones, as in processBlockVCMap()
+    std::map<PWP_UINT32, PWGM_CONDDATA> vcs;
+    const PWP_UINT32 blockCount = PwModBlockCount(rti.model);
+    for (PWP_UINT32 ndx = 0; ndx < blockCount; ++ndx) {
+        PWGM_CONDDATA cond;
+        getSafeVC(rti, PwModEnumBlocks(rti.model, ndx), cond);
+        vcs.emplace(cond.id, cond);
+    }
+    for (size_t i = 0; i < zones.zones.size() && !pollAbort(rti); ++i) {
+        const FluentMeshZones::Zone &z = zones.zones[i];
+        std::map<PWP_UINT32, PWGM_CONDDATA>::const_iterator vc =
+            vcs.find(z.id);
+        if ((FluentMeshZones::Boundary == z.kind) ?
+                (z.id >= PwModDomainCount(rti.model)) : (vcs.end() == vc ||
+                (PWP_BADID != z.id2 && vcs.end() == vcs.find(z.id2)))) {
+            char msg[160];
+            snprintf(msg, sizeof(msg), "Zone %u of the mesh file is of a "
+                "condition the grid does not have.", z.zone);
+            caeuSendErrorMsg(&rti, msg, 0);
+            return false;
+        }
+        switch (z.kind) {
+        case FluentMeshZones::Cell:
+            writeZoneSection(rti, z.zone, vc->second.type, vc->second.name);
+            break;
+        case FluentMeshZones::Boundary: {
+            PWGM_CONDDATA cond;
+            getSafeBC(rti, PwModEnumDomains(rti.model, z.id), cond);
+            writeZoneSection(rti, z.zone, cond.type, cond.name);
+            break; }
+        case FluentMeshZones::Interior: {
+            std::string zoneName = "interior-";
+            zoneName.append(vc->second.name);
+            if (PWP_BADID != z.id2) {
+                zoneName.append("-");
+                zoneName.append(vcs.find(z.id2)->second.name);
+            }
+            writeZoneSection(rti, z.zone, "interior", zoneName);
+            break; }
+        default:
+            break;
+        }
+    }
+    return out.ok() && !CAEPU_RT_IS_ABORTED(&rti);
+}
+
+
+// true if sink can skip ahead and fill the skipped bytes in later, as
+// startNodeWriter() needs
+static bool
+canSkipAhead(FluentSink *sink)
+{
+#if !defined(WINDOWS)
+    const FluentFdSink *fdSink = dynamic_cast<FluentFdSink*>(sink);
+    return (nullptr != fdSink) && fdSink->isPatchable();
+#else
+    (void)sink;
+    return false;
+#endif
+}
+
+
+// Invoked once for each requested grid export.
+PWP_BOOL
+runtimeWrite(CAEP_RTITEM *pRti, PWGM_HGRIDMODEL model,
+    const CAEP_WRITEINFO *pWriteInfo)
+{
+    PWP_BOOL ret = PWP_FALSE;
+    if (pRti && pRti->fp && model && pWriteInfo) {
+        // init plugin-defined instance data pointer
+        // The arena must outlive the containers of fluentData
+        FluentArena arena;
+        FLUENT_DATA fluentData;
+        fluentData.setArena(arena);
+        pRti->data = &fluentData; // cppcheck-suppress autoVariables
+
+        FluentTrace trace;
+        trace.open(getTraceFilename(*pWriteInfo, model).c_str());
+        fluentData.trace = &trace;
+
+        FluentPerf perf;
+        if (isPerfRequested(model)) {
+            perf.open();
+            fluentData.perf = &perf;
+        }
+
+        // Counts the grid model API calls of this thread from here on
+        FluentApiStats apiStats;
+        if (getBoolSetting(model, "ApiStats", "CAEUNSFLUENT_API_STATS")) {
+            apiStats.start();
+            fluentData.apiStats = &apiStats;
+        }
+
+        const DryRunMode dryRun = getDryRunMode(model);
+
+        // Partitioning needs the cell adjacency collected during streaming.
+        // A counting dry run estimates the partition sections instead.
+        FluentCellGraph cellGraph;
+        getPartitionSettings(model, fluentData);
+        if (1 < fluentData.partCount && DryRunCount != dryRun) {
+            fluentData.cellGraph = &cellGraph;
+        }
+        const std::chrono::steady_clock::time_point startTime =
+            std::chrono::steady_clock::now();
+
+        // Shadow faces over the ShadowMemory budget are spilled to disk
+        ShadowSpill shadowSpill;
+        fluentData.shadowSpill = &shadowSpill;
+        getRuntimeSettings(*pRti, DryRunOff == dryRun);
+
+        // The HDF5 case file is written alongside or instead of the text file
+        FluentCffWriter cff;
+        const bool cffOk = (DryRunOff != dryRun) || openCffOutput(*pRti, cff);
+
+        // A boundary only export writes the BC faces and their nodes
+        fluentData.boundaryOnly = getBoolSetting(model, "BoundaryOnly",
+            "CAEUNSFLUENT_BOUNDARY_ONLY");
+        if (fluentData.boundaryOnly && (nullptr != fluentData.cff ||
+                nullptr != fluentData.cellGraph)) {
+            caeuSendWarningMsg(pRti, "BoundaryOnly cannot be combined with "
+                "the HDF5 case file or partitioning. Writing the whole "
+                "mesh.", 0);
+            fluentData.boundaryOnly = false;
+        }
+
+        // BC faces are cached and written as one face zone per BC
+        fluentData.mergeBCZones = getBoolSetting(model, "MergeBCZones",
+            "CAEUNSFLUENT_MERGE_BC_ZONES");
+
+        // A MeshCache export writes the grid to a mesh file shared by the
+        // exports of the same grid, and the zone sections to the case file
+        std::string meshFile;
+        FluentMeshZones meshZones;
+        const bool splitMesh = (DryRunOff == dryRun) &&
+            fluentData.writeText && getMeshCacheFile(*pRti, meshFile,
+                meshZones);
+        const bool meshCached = splitMesh &&
+            loadMeshZones(*pRti, meshFile, meshZones);
+
+        // On request the cell types of the mixed cell zones are enumerated
+        // and formatted on a worker while the faces stream. The worker calls
+        // the grid model API concurrently with the export thread.
+        FluentCellTypeLists cellTypeLists;
+        if (getBoolSetting(model, "PipelineCellTypes",
+                "CAEUNSFLUENT_PIPELINE_CELL_TYPES") &&
+                !fluentData.boundaryOnly) {
+            fluentData.cellTypeLists = &cellTypeLists;
+        }
+
+        // A dry run writes nothing to the export file
+        CheckpointState checkpoint;
+        FluentCountingSink countingSink;
+        std::unique_ptr<FluentSink> fileSink;
+        bool outputOk = true;
+        FluentSink *sink = nextOutputSink;
+        nextOutputSink = nullptr;
+        if (DryRunOff != dryRun) {
+            sink = &countingSink;
+            fluentData.countingSink = &countingSink;
+        }
+        else if (!fluentData.writeText) {
+            // Only the HDF5 file is wanted; the text sections are counted
+            sink = &countingSink;
+        }
+        else if (nullptr == sink) {
+            // A checkpointed export writes "<file>.part" instead
+            fileSink.reset(openCheckpoint(*pRti, checkpoint));
+            if (0 <= checkpoint.fd) {
+                fluentData.checkpoint = &checkpoint;
+            }
+            else {
+                fileSink.reset(createOutputSink(*pRti));
+            }
+            sink = fileSink.get();
+            if (nullptr == sink) {
+                // Nothing can be written
+                outputOk = false;
+                sink = &countingSink;
+            }
+        }
+
+        // Extra copies of the case file share the one pass over the grid
+        std::vector<std::unique_ptr<FluentSink> > copies;
+        std::vector<std::string> copyNames;
+        FluentTeeSink tee;
+        bool copiesOk = true;
+        if (DryRunOff == dryRun && fluentData.writeText) {
+            copiesOk = openOutputCopies(*pRti, copies, copyNames);
+            if (copiesOk && !copies.empty()) {
+                tee.add(sink);
+                for (size_t i = 0; i < copies.size(); ++i) {
+                    tee.add(copies[i].get());
+                }
+                sink = &tee;
+            }
+        }
+        // The content hash sees the case file before it is copied
+        std::unique_ptr<FluentHashSink> hashSink;
+        if (DryRunOff == dryRun && fluentData.writeText &&
+                getBoolSetting(model, "ContentHash",
+                    "CAEUNSFLUENT_CONTENT_HASH")) {
+            if (nullptr != fluentData.checkpoint && checkpoint.resumed) {
+                caeuSendWarningMsg(pRti, "The content hash is not computed "
+                    "for a resumed export.", 0);
+            }
+            else {
+                hashSink.reset(new FluentHashSink(*sink));
+                sink = hashSink.get();
+                fluentData.hashSink = hashSink.get();
+            }
+        }
+        // The grid goes to the mesh file unless it is up to date
+        FluentSink *caseSink = sink;
+        MeshFileOutput meshOut;
+        bool meshOk = true;
+        if (splitMesh && !meshCached) {
+            // A missing cache folder is created, parents included
+            const std::string folder = meshFile.substr(0,
+                meshFile.find_last_of('/'));
+            if (!fluentCreateFolder(folder)) {
+                meshOk = false;
+                caeuSendErrorMsg(pRti, ("Could not create the MeshCache "
+                    "folder " + folder + ".").c_str(), 0);
+            }
+            else if (meshOut.open(meshFile, fluentData.bufferSize)) {
+                sink = meshOut.sink();
+                fluentData.meshZones = &meshZones;
+            }
+            else {
+                meshOk = false;
+                caeuSendErrorMsg(pRti, ("Could not create the mesh file " +
+                    meshFile + ".").c_str(), 0);
+            }
+        }
+        FluentMemorySink zoneStage;
+        zoneStage.setLimit(size_t(getUIntSetting(*pRti, "ZoneStageLimit",
+            "CAEUNSFLUENT_ZONE_STAGE_LIMIT", 1024)) * 1024 * 1024);
+        fluentData.sink = sink;
+        fluentData.zoneStage = &zoneStage;
+
+        // The node coordinates can be written on a worker thread into a
+        // range of the case file skipped for them while the faces stream
+        FluentNodeWriter nodeWriter;
+        if (getBoolSetting(model, "PipelineNodes",
+                "CAEUNSFLUENT_PIPELINE_NODES")) {
+            if ((sink == fileSink.get() || sink == meshOut.sink()) &&
+                    nullptr == fluentData.checkpoint &&
+                    nullptr == fluentData.cff && canSkipAhead(sink)) {
+                fluentData.nodeWriter = &nodeWriter;
+            }
+            else if (DryRunOff == dryRun && fluentData.writeText) {
+                caeuSendWarningMsg(pRti, "PipelineNodes needs the buffered "
+                    "OutputMode (POSIX only) without a checkpoint, content "
+                    "hash, HDF5 case file or output copies. Writing the "
+                    "nodes first.", 0);
+            }
+        }
+
+        // A counting dry run sizes the sections with the index
+        FluentSectionIndex sectionIndex;
+        PWP_BOOL writeIndex = PWP_FALSE;
+        if (PwModGetAttributeBOOL(model, "SectionIndex", &writeIndex) &&
+                writeIndex && pWriteInfo->fileDest) {
+            fluentData.sectionIndex = &sectionIndex;
+        }
+        if (DryRunCount == dryRun) {
+            fluentData.sectionIndex = &sectionIndex;
+        }
+
+        bool preallocOk = true;
+#if !defined(WINDOWS)
+        off_t preallocBase = -1;
+        // sink offset at preallocBase
+        const PWP_UINT64 preallocTell = sink->tell();
+        // The estimate is of the whole mesh
+        if (fileSink && nullptr == fluentData.checkpoint &&
+                !fluentData.boundaryOnly && !splitMesh) {
+            preallocOk = preallocateOutput(*pRti, preallocBase);
+        }
+#endif
+
+        PWP_UINT32 cnt = 2; /* the # of MAJOR progress steps */
+        // 1. Write vertices
+        // 2. Write faces (VC zones are written during face writting)
+        if (meshCached) {
+            // 1. Write the zone sections
+            cnt = 1;
+        }
+        if (DryRunEstimate == dryRun) {
+            FluentSizeEstimate est;
+            estimateSize(*pRti, est);
+            ret = reportSize(*pRti, est);
+        }
+        else if (outputOk && cffOk && copiesOk && preallocOk && meshOk &&
+                caeuProgressInit(pRti, cnt)) {
+            // Configure the grid model to enumerate elements grouped by VC
+            PwModAppendEnumElementOrder(model, PWGM_ELEMORDER_VC);
+            if (meshCached) {
+                // The grid is in the mesh file already
+                caeuSendInfoMsg(pRti, ("The mesh file " + meshFile + " is "
+                    "up to date. Writing the zone sections only.").c_str(), 0);
+                ret = progressBeginStep(*pRti, 1) && writeMeshZoneLayer(*pRti,
+                    *caseSink, meshFile, meshZones) &&
+                    caeuProgressEndStep(pRti);
+            }
+            else {
+                // Stream the interior model faces first, followed by the BC
+                // faces. A boundary only export streams the BC faces alone.
+                FluentTraceSpan span(&trace, "runtimeWrite");
+                ret = PwModStreamFaces(pRti->model, fluentData.boundaryOnly ?
+                    PWGM_FACEORDER_BCGROUPSONLY :
+                    PWGM_FACEORDER_VCGROUPSBCLAST, beginCB, faceCB, endCB,
+                    pRti) && !CAEPU_RT_IS_ABORTED(pRti);
+                // Lists of zones an aborted stream did not get to
+                cellTypeLists.stop();
+                if (nodeWriter.started()) {
+                    const bool nodesOk = nodeWriter.wait([pRti]() {
+                        return pollAbort(*pRti); });
+                    if (ret && !nodesOk && !CAEPU_RT_IS_ABORTED(pRti)) {
+                        caeuSendErrorMsg(pRti, "Could not write the nodes.",
+                            0);
+                    }
+                    ret = ret && nodesOk;
+                }
+                if (nullptr != fluentData.apiStats) {
+                    // The workers are done
+                    fluentData.apiStats->mergeWorkers();
+                }
+                FluentApiStats::setCurrentPhase(FluentApiStats::Other);
+            }
+            if (splitMesh && !meshCached) {
+                // The mesh file is complete once its zones are recorded
+                const bool streamed = ret && !CAEPU_RT_IS_ABORTED(pRti);
+                ret = meshOut.close(streamed) &&
+                    meshZones.write((meshFile + ".zones").c_str());
+                if (streamed && !ret &&
+                        loadMeshZones(*pRti, meshFile, meshZones)) {
+                    // An export of the same grid replaced the mesh file or
+                    // its record while this one renamed its own
+                    ret = true;
+                }
+                if (streamed && !ret) {
+                    caeuSendErrorMsg(pRti, ("Could not write the mesh file " +
+                        meshFile + ".").c_str(), 0);
+                }
+                ret = ret && writeMeshZoneLayer(*pRti, *caseSink, meshFile,
+                    meshZones);
+                sink = caseSink;
+                fluentData.sink = sink;
+            }
+            std::vector<std::string> hashLines;
+            if (ret && hashSink) {
+                hashLines = writeContentHash(*pRti);
+                caeuSendInfoMsg(pRti, hashLines[0].c_str(), 0);
+            }
+            ret = sink->flush() && !fluentData.writeFailed && ret;
+            if (perf.enabled()) {
+                // An aborted stream may not have reached endCB()
+                stopFaceStreamPerf(*pRti);
+                reportPerf(*pRti, perf);
+            }
+            if (getBoolSetting(model, "Stats", "CAEUNSFLUENT_STATS") ||
+                    nullptr != fluentData.apiStats) {
+                reportStats(*pRti, std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - startTime).count(),
+                    fluentData.writeText ? sink->tell() : 0, hashLines);
+            }
+            if (cff.isOpen()) {
+                ret = cff.close(PwModVertexCount(model), fluentData.cellCount,
+                    fluentData.faceIndex - 1) && ret;
+                if (ret && !fluentData.writeText) {
+                    ret = writeCffStub(*pRti);
+                }
+            }
+#if !defined(WINDOWS)
+            if (0 <= preallocBase) {
+                // Release the reserved space past the end of the file
+                ret = (0 == ftruncate(fileno(pRti->fp), preallocBase +
+                    off_t(sink->tell() - preallocTell))) && ret;
+            }
+#endif
+            if (nullptr != fluentData.checkpoint) {
+                fileSink.reset();
+                ret = finishCheckpoint(*pRti, checkpoint, ret) && ret;
+            }
+            if (CAEPU_RT_IS_ABORTED(pRti)) {
+                // Do not leave partial output files behind
+                reportAbortLatency(*pRti);
+                copies.clear();
+                for (size_t i = 0; i < copyNames.size(); ++i) {
+                    remove(copyNames[i].c_str());
+                }
+                if (nullptr != fluentData.cff) {
+                    remove((std::string(pWriteInfo->fileDest) +
+                        ".h5").c_str());
+                }
+                if (fileSink) {
+                    fileSink.reset();
+                    discardExportFile(*pRti);
+                }
+            }
+            if (DryRunCount == dryRun) {
+                FluentSizeEstimate est;
+                estimateSize(*pRti, est);
+                setCountedSize(sectionIndex, countingSink.tell(), est);
+                ret = ret && reportSize(*pRti, est);
+            }
+            else if (ret && writeIndex) {
+                const std::string indexFile = std::string(
+                    pWriteInfo->fileDest) + ".idx";
+                ret = sectionIndex.write(indexFile.c_str());
+            }
             pRti->data->reset();
             caeuProgressEnd(pRti, ret);
         }
@@ -1058,8 +4247,102 @@ runtimeCreate(CAEP_RTITEM * /*pRti*/)
 {
     bool ret = true;
     // Publish which BC types are non-inflated/shadow.
-    const char * const ShadowTypes = "Porous Jump|Fan|Radiator|Interior";
     ret = ret && caeuAssignInfoValue("ShadowBcTypes", ShadowTypes, true);
+    // Publish the export attributes
+    ret = ret && caeuPublishValueDefinition("TraceEvents", PWP_VALTYPE_BOOL,
+        "false", "RW", "Write a Chrome trace-event timeline of the export to "
+        "<file>.trace.json", "false|true");
+    ret = ret && caeuPublishValueDefinition("PerfCounters", PWP_VALTYPE_BOOL,
+        "false", "RW", "Report cycles, instructions, cache and branch misses "
+        "and page faults per export phase to <file>.perf.txt (Linux)",
+        "false|true");
+    ret = ret && caeuPublishValueDefinition("DryRun", PWP_VALTYPE_ENUM, "off",
+        "RW", "Report the size of the case file and the peak memory of the "
+        "export without writing it. 'estimate' uses the element counts, "
+        "'count' streams the faces for exact section sizes",
+        "off|estimate|count");
+    ret = ret && caeuPublishValueDefinition("OutputMode", PWP_VALTYPE_ENUM,
+        "buffered", "RW", "How the case file is written. 'stdio' uses the C "
+        "stream, 'mmap' a memory map, 'direct' bypasses the page cache with "
+        "aligned O_DIRECT writes, 'async' writes on a worker thread (all but "
+        "'stdio' are POSIX only)", "buffered|stdio|mmap|direct|async");
+    ret = ret && caeuPublishValueDefinition("Threads", PWP_VALTYPE_UINT, "0",
+        "RW", "Worker threads for partitioning, HDF5 output and the cell "
+        "types of mixed cell zones (0 uses all cores)", "0 1024");
+    ret = ret && caeuPublishValueDefinition("BufferSize", PWP_VALTYPE_UINT,
+        "0", "RW", "Output buffer or memory map window size in bytes (0 uses "
+        "the default of the OutputMode)", "0 1073741824");
+    ret = ret && caeuPublishValueDefinition("ShadowMemory", PWP_VALTYPE_UINT,
+        "0", "RW", "MiB of shadow faces kept in memory before sorted runs "
+        "are spilled to a temporary file (0 is unlimited)", "0 1048576");
+    ret = ret && caeuPublishValueDefinition("ZoneStageLimit",
+        PWP_VALTYPE_UINT, "1024", "RW", "MiB a face zone may take in memory "
+        "while it is held for an output that cannot be patched (0 is "
+        "unlimited)", "0 1048576");
+    ret = ret && caeuPublishValueDefinition("ProgressStep", PWP_VALTYPE_UINT,
+        "1", "RW", "Items per progress update (0 picks about 1000 updates "
+        "per step)", "0 1000000000");
+    ret = ret && caeuPublishValueDefinition("AutoTune", PWP_VALTYPE_BOOL,
+        "false", "RW", "Choose the threads from the core and cell counts, "
+        "the BufferSize from a write-throughput probe and the ProgressStep "
+        "for settings left at their defaults", "false|true");
+    ret = ret && caeuPublishValueDefinition("BoundaryOnly", PWP_VALTYPE_BOOL,
+        "false", "RW", "Write only the BC faces and the nodes they use, "
+        "without cells or interior faces", "false|true");
+    ret = ret && caeuPublishValueDefinition("MergeBCZones", PWP_VALTYPE_BOOL,
+        "false", "RW", "Write the BC faces of all domains with the same BC "
+        "as one face zone", "false|true");
+    ret = ret && caeuPublishValueDefinition("MeshCache", PWP_VALTYPE_STRING,
+        "", "RW", "Folder of mesh files shared by exports of the same grid. "
+        "The grid is written to '<folder>/<grid hash>.msh' once, and the "
+        "case file holds the zone names and types only", "");
+    ret = ret && caeuPublishValueDefinition("PipelineCellTypes",
+        PWP_VALTYPE_BOOL, "false", "RW", "Enumerate and format the cell types "
+        "of the mixed cell zones on a worker thread while the faces are "
+        "written. Needs a thread safe grid model API", "false|true");
+    ret = ret && caeuPublishValueDefinition("PipelineNodes",
+        PWP_VALTYPE_BOOL, "false", "RW", "Write the node coordinates on a "
+        "worker thread while the faces are written (POSIX only). Needs a "
+        "thread safe grid model API", "false|true");
+    ret = ret && caeuPublishValueDefinition("ApiStats", PWP_VALTYPE_BOOL,
+        "false", "RW", "Count and time the grid model API calls by export "
+        "phase and add them to the Stats report", "false|true");
+    ret = ret && caeuPublishValueDefinition("ContentHash", PWP_VALTYPE_BOOL,
+        "false", "RW", "Hash the text case file and each of its sections "
+        "while it is written, and append the digests as comments",
+        "false|true");
+    ret = ret && caeuPublishValueDefinition("Checkpoint", PWP_VALTYPE_UINT,
+        "0", "RW", "Checkpoint the text case file at the first face zone "
+        "boundary after every this many MiB, so that a failed or aborted "
+        "export of the same model resumes from there (0 disables, POSIX "
+        "only)", "0 1048576");
+    ret = ret && caeuPublishValueDefinition("Stats", PWP_VALTYPE_BOOL,
+        "false", "RW", "Report the export time, throughput and the settings "
+        "used", "false|true");
+    ret = ret && caeuPublishValueDefinition("OutputCopies",
+        PWP_VALTYPE_STRING, "", "RW", "';' separated files that receive a "
+        "copy of the text case file from the same export pass. Names ending "
+        "in '.gz' are gzip compressed", "");
+    ret = ret && caeuPublishValueDefinition("CaseFormat", PWP_VALTYPE_ENUM,
+        "text", "RW", "The case file format. 'cff' writes the mesh to an "
+        "HDF5 '<case>.h5' file only, 'both' writes both files. The HDF5 "
+        "output is experimental and not validated with Fluent",
+        "text|cff|both");
+    ret = ret && caeuPublishValueDefinition("Preallocate", PWP_VALTYPE_BOOL,
+        "false", "RW", "Reserve the estimated size of the case file on disk "
+        "before writing it", "false|true");
+    ret = ret && caeuPublishValueDefinition("SectionIndex", PWP_VALTYPE_BOOL,
+        "false", "RW", "Write the byte offset and length of every section to "
+        "<file>.idx", "false|true");
+    ret = ret && caeuPublishValueDefinition("PartitionCount", PWP_VALTYPE_UINT,
+        "0", "RW", "Partition the cells into this many parts for parallel "
+        "solver runs (0 or 1 disables partitioning)", "0 65536");
+    ret = ret && caeuPublishValueDefinition("PartitionImbalance",
+        PWP_VALTYPE_REAL, "0.05", "RW", "Allowed relative overweight of a "
+        "partition", "0.0 1.0");
+    ret = ret && caeuPublishValueDefinition("PartitionPrismWeight",
+        PWP_VALTYPE_REAL, "1.0", "RW", "Partitioning weight of wedge, pyramid "
+        "and hex cells relative to tet cells", "0.01 100.0");
     return PWP_CAST_BOOL(ret);
 }
 